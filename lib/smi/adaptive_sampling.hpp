@@ -0,0 +1,144 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct adaptive_policy
+ * @brief Settings of adaptive (change-driven) sampling.
+ *
+ * While a processor's power, activity and temperature stay within tolerance
+ * of a reference sample, its sampling periods are stretched by a stride that
+ * doubles on every stable sample, up to max_stride. The first sample outside
+ * tolerance resets the stride to one, so a change is detected at most
+ * max_stride periods after it happens.
+ */
+struct adaptive_policy {
+  bool enabled{false};
+  uint32_t max_stride{8};            ///< Upper bound of the period multiplier
+  uint32_t power_tolerance{5};       ///< Socket power tolerance in watts
+  uint32_t activity_tolerance{2};    ///< GFX/UMC/MM activity tolerance in %
+  uint16_t temperature_tolerance{1}; ///< Temperature tolerance in degrees C
+};
+
+/**
+ * @class change_detector
+ * @brief Tracks the sampling stride of each processor from its samples.
+ *
+ * Samples are compared against the reference taken when the stride was last
+ * reset rather than against the previous sample, so a slow drift still
+ * counts as a change once it accumulates past the tolerance.
+ */
+class change_detector {
+public:
+  /**
+   * @brief Groups whose refresh makes a sample worth comparing. Reads of
+   * other groups leave power and activity stale and must not be fed in.
+   */
+  static constexpr group_mask watched_groups =
+      group_bit(metric_group::power) | group_bit(metric_group::activity);
+
+  /**
+   * @brief Constructs a detector for @p rows processors, all at stride one.
+   */
+  change_detector(const adaptive_policy &policy, std::size_t rows)
+      : m_policy{policy}, m_references(rows, smi_metrics{}),
+        m_has_reference(rows, false), m_strides(rows, 1) {}
+
+  /** @brief Grows the detector to @p rows processors at stride one. */
+  void resize(std::size_t rows) {
+    if (rows > m_strides.size()) {
+      m_references.resize(rows, smi_metrics{});
+      m_has_reference.resize(rows, false);
+      m_strides.resize(rows, 1);
+    }
+  }
+
+  /** @brief Returns a row to full rate and drops its reference sample. */
+  void reset_row(std::size_t row) {
+    m_has_reference[row] = false;
+    m_strides[row] = 1;
+  }
+
+  /** @brief Current period multiplier of a row. */
+  uint32_t stride(std::size_t row) const { return m_strides[row]; }
+
+  /**
+   * @brief Feeds a new sample of a row and returns its updated stride.
+   */
+  uint32_t update(std::size_t row, const smi_metrics &sample) {
+    if (!m_policy.enabled) {
+      return 1;
+    }
+    if (!m_has_reference[row] || changed(m_references[row], sample)) {
+      m_references[row] = sample;
+      m_has_reference[row] = true;
+      m_strides[row] = 1;
+    } else {
+      m_strides[row] =
+          std::min(m_strides[row] * 2, std::max(m_policy.max_stride, 1u));
+    }
+    return m_strides[row];
+  }
+
+  /** @brief Whether @p sample is outside tolerance of @p reference. */
+  bool changed(const smi_metrics &reference, const smi_metrics &sample) const {
+    auto outside = [](auto lhs, auto rhs, auto tolerance) {
+      return (lhs > rhs ? lhs - rhs : rhs - lhs) > tolerance;
+    };
+    return outside(reference.current_socket_power, sample.current_socket_power,
+                   m_policy.power_tolerance) ||
+           outside(reference.gfx_activity, sample.gfx_activity,
+                   m_policy.activity_tolerance) ||
+           outside(reference.umc_activity, sample.umc_activity,
+                   m_policy.activity_tolerance) ||
+           outside(reference.mm_activity, sample.mm_activity,
+                   m_policy.activity_tolerance) ||
+           outside(reference.hotspot_temperature, sample.hotspot_temperature,
+                   m_policy.temperature_tolerance);
+  }
+
+private:
+  adaptive_policy m_policy;
+  std::vector<smi_metrics> m_references;
+  std::vector<bool> m_has_reference;
+  std::vector<uint32_t> m_strides;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -28,9 +28,10 @@
 
 #pragma once
 
+#include "smi/driver.hpp"
+
 #include <amd_smi/amdsmi.h>
 #include <cstdint>
-#include <memory>
 
 namespace rocprofsys {
 namespace amd_smi {
@@ -98,20 +99,34 @@ struct amd_smi_driver {
   }
 
   static amdsmi_status_t
-  get_gpu_memory_usage(amdsmi_processor_handle processor_handle,
-                       amdsmi_memory_type_t memory_type,
-                       uint64_t *memory_used) {
-    return amdsmi_get_gpu_memory_usage(processor_handle, memory_type,
-                                       memory_used);
+  get_memory_total(amdsmi_processor_handle processor_handle,
+                   amdsmi_memory_type_t type, uint64_t *total) {
+    return amdsmi_get_gpu_memory_total(processor_handle, type, total);
+  }
+
+  static amdsmi_status_t
+  get_device_bdf(amdsmi_processor_handle processor_handle, amdsmi_bdf_t *bdf) {
+    return amdsmi_get_gpu_device_bdf(processor_handle, bdf);
+  }
+
+  static amdsmi_status_t
+  get_process_list(amdsmi_processor_handle processor_handle,
+                   uint32_t *max_processes, amdsmi_proc_info_t *processes) {
+    return amdsmi_get_gpu_process_list(processor_handle, max_processes,
+                                       processes);
   }
 };
 
+static_assert(smi_driver<amd_smi_driver>);
+static_assert(stateless_driver<amd_smi_driver>);
+static_assert(identity_driver<amd_smi_driver>);
+static_assert(memory_total_driver<amd_smi_driver>);
+static_assert(process_driver<amd_smi_driver>);
+
 struct amd_smi_driver_factory {
   using driver_t = amd_smi_driver;
 
-  static std::shared_ptr<driver_t> create_driver() {
-    return std::make_shared<driver_t>();
-  }
+  static constexpr driver_t create_driver() { return driver_t{}; }
 };
 
 } // namespace amd_smi
@@ -0,0 +1,148 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @class async_generator
+ * @tparam value_t Type of the yielded values.
+ * @brief Coroutine that yields values and may co_await between them.
+ *
+ * Consumers pull values with co_await next(), which resumes the generator
+ * until its next co_yield and returns std::nullopt once it finishes. Control
+ * passes between consumer and generator by symmetric transfer, so a
+ * generator suspended on an awaitable (such as round_signal::next_round())
+ * hands its value straight to the consumer when it is resumed.
+ */
+template <typename value_t> class async_generator {
+public:
+  struct promise_type;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  struct promise_type {
+    std::optional<value_t> current;
+    std::coroutine_handle<> consumer{};
+    std::exception_ptr error;
+
+    /** @brief Suspends the generator and resumes its consumer. */
+    struct transfer_to_consumer {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(handle_type handle) noexcept {
+        auto consumer = handle.promise().consumer;
+        return consumer ? consumer : std::noop_coroutine();
+      }
+      void await_resume() const noexcept {}
+    };
+
+    async_generator get_return_object() {
+      return async_generator{handle_type::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    transfer_to_consumer final_suspend() const noexcept { return {}; }
+
+    transfer_to_consumer yield_value(value_t value) {
+      current = std::move(value);
+      return {};
+    }
+
+    void return_void() const noexcept {}
+    void unhandled_exception() { error = std::current_exception(); }
+  };
+
+  /**
+   * @brief Awaitable returned by next().
+   */
+  struct next_awaiter {
+    handle_type generator;
+
+    bool await_ready() const noexcept {
+      return !generator || generator.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) {
+      generator.promise().consumer = consumer;
+      generator.promise().current.reset();
+      return generator;
+    }
+
+    std::optional<value_t> await_resume() {
+      if (!generator) {
+        return std::nullopt;
+      }
+      if (generator.promise().error) {
+        std::rethrow_exception(generator.promise().error);
+      }
+      return std::move(generator.promise().current);
+    }
+  };
+
+  async_generator(async_generator &&other) noexcept
+      : m_handle{std::exchange(other.m_handle, {})} {}
+
+  async_generator &operator=(async_generator &&other) noexcept {
+    if (this != &other) {
+      reset();
+      m_handle = std::exchange(other.m_handle, {});
+    }
+    return *this;
+  }
+
+  async_generator(const async_generator &) = delete;
+  async_generator &operator=(const async_generator &) = delete;
+
+  ~async_generator() { reset(); }
+
+  /**
+   * @brief Resumes the generator; yields the next value, or std::nullopt
+   * when it has finished.
+   */
+  next_awaiter next() { return next_awaiter{m_handle}; }
+
+private:
+  explicit async_generator(handle_type handle) : m_handle{handle} {}
+
+  void reset() {
+    if (m_handle) {
+      m_handle.destroy();
+      m_handle = {};
+    }
+  }
+
+  handle_type m_handle;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
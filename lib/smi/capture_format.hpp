@@ -0,0 +1,245 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/sample_batch.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Kinds of capture blocks.
+ */
+enum class capture_block_kind : uint16_t {
+  samples = 1, ///< sample_record payload
+};
+
+constexpr uint32_t capture_magic = 0x4b4c4253; ///< "SBLK" in memory order
+constexpr uint16_t capture_version = 1;
+constexpr std::size_t capture_block_alignment = 4096;
+constexpr std::size_t capture_header_size = 256;
+/** @brief Size of a stored sample_record: every column is present. */
+constexpr std::size_t capture_record_size = record_size(all_metric_columns);
+
+/**
+ * @brief Offset of a column's value in a stored record.
+ */
+constexpr std::size_t capture_column_offset(metric_column column) {
+  return record_size(all_metric_columns &
+                     ((1u << static_cast<std::size_t>(column)) - 1));
+}
+
+/**
+ * @struct capture_block_header
+ * @brief Header at the start of every capture block.
+ *
+ * A capture segment file is a sequence of fixed-size blocks, each a header
+ * followed by records and zero padding. The header's time range and
+ * per-column bounds let readers skip blocks without reading their records.
+ * Blocks whose magic does not match (for example a failed write) are
+ * skipped. Integers are in host byte order.
+ *
+ * Record times are host monotonic time, which is not comparable across
+ * nodes; realtime_offset_ns places them on the node's system clock, which
+ * is what captures of different nodes are aligned on.
+ */
+struct capture_block_header {
+  uint32_t magic{capture_magic};
+  uint16_t version{capture_version};
+  uint16_t kind{static_cast<uint16_t>(capture_block_kind::samples)};
+  uint32_t record_count{0};
+  uint32_t payload_bytes{0};                            ///< Bytes after header
+  uint32_t block_size{0};                               ///< Header included
+  uint64_t first_host_ns{~uint64_t{0}};                 ///< Earliest record
+  uint64_t last_host_ns{0};                             ///< Latest record
+  uint64_t processors{0};                               ///< Bit i: processor i
+  std::array<uint64_t, metric_column_count> min_values; ///< Per column
+  std::array<uint64_t, metric_column_count> max_values; ///< Per column
+  /** CLOCK_REALTIME minus host monotonic time when the block was sealed. */
+  int64_t realtime_offset_ns{0};
+  /** Processor range of the records; ids of 64 and above have no mask bit. */
+  uint32_t min_processor{~uint32_t{0}};
+  uint32_t max_processor{0};
+
+  capture_block_header() {
+    min_values.fill(std::numeric_limits<uint64_t>::max());
+    max_values.fill(0);
+  }
+
+  /** @brief Widens the time range and column bounds to @p record. */
+  void include(const sample_record &record) {
+    ++record_count;
+    first_host_ns = std::min(first_host_ns, record.host_ns);
+    last_host_ns = std::max(last_host_ns, record.host_ns);
+    if (record.processor < 64) {
+      processors |= uint64_t{1} << record.processor;
+    }
+    min_processor = std::min(min_processor, record.processor);
+    max_processor = std::max(max_processor, record.processor);
+    for (std::size_t column = 0; column < metric_column_count; ++column) {
+      min_values[column] = std::min(min_values[column], record.values[column]);
+      max_values[column] = std::max(max_values[column], record.values[column]);
+    }
+  }
+
+  /** @brief True if the header describes a block this version can read. */
+  bool valid() const {
+    return magic == capture_magic && version == capture_version &&
+           block_size > capture_header_size &&
+           payload_bytes == record_count * capture_record_size &&
+           payload_bytes <= block_size - capture_header_size;
+  }
+};
+
+static_assert(std::is_trivially_copyable_v<capture_block_header>);
+static_assert(sizeof(capture_block_header) <= capture_header_size);
+
+/**
+ * @brief Returns CLOCK_REALTIME minus host monotonic time, read between two
+ * monotonic reads.
+ */
+inline int64_t measure_realtime_offset_ns() {
+  auto before = host_timestamp_ns();
+  auto realtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+  auto after = host_timestamp_ns();
+  return realtime - static_cast<int64_t>(before + (after - before) / 2);
+}
+
+/**
+ * @brief Number of records that fit in one block.
+ */
+constexpr std::size_t capture_block_capacity(std::size_t block_size) {
+  return block_size > capture_header_size
+             ? (block_size - capture_header_size) / capture_record_size
+             : 0;
+}
+
+/**
+ * @brief Loads the value of one column of a stored record.
+ */
+inline uint64_t load_column(const std::byte *record, metric_column column) {
+  const std::byte *in = record + capture_column_offset(column);
+  if (column_width(column) == 8) {
+    uint64_t value;
+    std::memcpy(&value, in, 8);
+    return value;
+  }
+  uint32_t value;
+  std::memcpy(&value, in, 4);
+  return value;
+}
+
+/**
+ * @brief Stores a record in capture layout, the same layout as a samples
+ * frame record with every column selected.
+ */
+inline void store_record(std::byte *out, const sample_record &record) {
+  std::memcpy(out, &record.host_ns, 8);
+  std::memcpy(out + 8, &record.gpu_clock_counter, 8);
+  std::memcpy(out + 16, &record.processor, 4);
+  for (std::size_t column = 0; column < metric_column_count; ++column) {
+    auto metric = static_cast<metric_column>(column);
+    std::byte *value = out + capture_column_offset(metric);
+    if (column_width(metric) == 8) {
+      std::memcpy(value, &record.values[column], 8);
+    } else {
+      auto narrow = static_cast<uint32_t>(record.values[column]);
+      std::memcpy(value, &narrow, 4);
+    }
+  }
+}
+
+/** @brief Loads a record stored by store_record(). */
+inline sample_record load_record(const std::byte *in) {
+  sample_record record;
+  std::memcpy(&record.host_ns, in, 8);
+  std::memcpy(&record.gpu_clock_counter, in + 8, 8);
+  std::memcpy(&record.processor, in + 16, 4);
+  for (std::size_t column = 0; column < metric_column_count; ++column) {
+    record.values[column] = load_column(in, static_cast<metric_column>(column));
+  }
+  return record;
+}
+
+/**
+ * @brief File name of segment @p index of a capture, e.g.
+ * "smi-capture-000003.smicap".
+ */
+inline std::string capture_segment_name(const std::string &prefix,
+                                        uint32_t index) {
+  char suffix[24];
+  std::snprintf(suffix, sizeof(suffix), "-%06u.smicap", index);
+  return prefix + suffix;
+}
+
+/**
+ * @brief Segment files of the capture named @p prefix in @p directory, oldest
+ * first. Captures whose prefix merely starts with @p prefix do not match.
+ */
+inline std::vector<std::filesystem::path>
+capture_segments(const std::filesystem::path &directory,
+                 const std::string &prefix) {
+  constexpr std::string_view extension{".smicap"};
+  std::vector<std::filesystem::path> segments;
+  for (const auto &entry : std::filesystem::directory_iterator{directory}) {
+    auto name = entry.path().filename().string();
+    if (name.size() <= prefix.size() + 1 + extension.size() ||
+        !name.starts_with(prefix + "-") || !name.ends_with(extension)) {
+      continue;
+    }
+    auto index = std::string_view{name}.substr(
+        prefix.size() + 1, name.size() - prefix.size() - 1 - extension.size());
+    if (std::all_of(index.begin(), index.end(),
+                    [](char c) { return c >= '0' && c <= '9'; })) {
+      segments.push_back(entry.path());
+    }
+  }
+  std::sort(segments.begin(), segments.end());
+  return segments;
+}
+
+} // namespace amd_smi
+} // namespace rocprofsys
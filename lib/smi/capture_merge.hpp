@@ -0,0 +1,237 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/capture_format.hpp"
+#include "smi/capture_reader.hpp"
+#include "smi/capture_writer.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct merge_input
+ * @brief Capture of one node to merge.
+ */
+struct merge_input {
+  std::filesystem::path directory;
+  std::string prefix{"smi-capture"};
+};
+
+/**
+ * @struct merge_summary
+ * @brief Outcome of merge_captures().
+ */
+struct merge_summary {
+  /** First merged processor id of each input. */
+  std::vector<uint32_t> processor_base;
+  uint64_t records{0};  ///< Records written
+  uint64_t first_ns{0}; ///< Earliest system clock time
+  uint64_t last_ns{0};  ///< Latest system clock time
+  capture_stats output; ///< Counters of the output writer
+};
+
+namespace detail {
+
+/**
+ * @class merge_cursor
+ * @brief Walks one node's capture in system clock order, one decoded block
+ * at a time.
+ *
+ * A block holds whole sampling rounds and rounds never overlap, so sorting
+ * each block is enough to order the whole capture.
+ */
+class merge_cursor {
+public:
+  merge_cursor(const merge_input &input, uint32_t processor_base)
+      : m_reader{capture_reader::open_directory(input.directory,
+                                                input.prefix)},
+        m_base{processor_base} {
+    load();
+  }
+
+  /**
+   * @brief Processors in the capture: one past the highest processor id of
+   * its records, from the block processor ranges.
+   */
+  static uint32_t processor_count(const capture_reader &reader) {
+    uint32_t count{0};
+    for (std::size_t block = 0; block < reader.block_count(); ++block) {
+      const auto &header = reader.block_header(block);
+      if (header.record_count != 0) {
+        count = std::max(count, header.max_processor + 1);
+      }
+    }
+    return count;
+  }
+
+  const capture_reader &reader() const { return m_reader; }
+
+  bool done() const { return m_next == m_records.size(); }
+
+  const sample_record &front() const { return m_records[m_next]; }
+
+  void pop() {
+    ++m_next;
+    load();
+  }
+
+private:
+  void load() {
+    while (m_next == m_records.size() && m_block < m_reader.block_count()) {
+      auto offset = m_reader.block_header(m_block).realtime_offset_ns;
+      m_reader.read_block(m_block++, m_records);
+      for (auto &record : m_records) {
+        record.host_ns =
+            static_cast<uint64_t>(static_cast<int64_t>(record.host_ns) +
+                                  offset);
+        record.processor += m_base;
+      }
+      std::stable_sort(m_records.begin(), m_records.end(),
+                       [](const sample_record &a, const sample_record &b) {
+                         return a.host_ns < b.host_ns;
+                       });
+      m_next = 0;
+    }
+  }
+
+  capture_reader m_reader;
+  uint32_t m_base;
+  std::size_t m_block{0};
+  std::vector<sample_record> m_records; ///< Decoded block, time ordered
+  std::size_t m_next{0};                ///< Next record in m_records
+};
+
+} // namespace detail
+
+/**
+ * @brief Merges the captures of several nodes into one capture ordered by
+ * system clock time.
+ *
+ * Each node's record times are moved from its monotonic clock to its
+ * system clock with the offset stored in every block header, so nodes are
+ * aligned as well as their system clocks are synchronized (NTP or PTP).
+ * The inputs are merged k-way while streaming: memory holds one decoded
+ * block per input plus the output writer's blocks, however large the
+ * inputs are.
+ *
+ * The output is a regular capture whose times are system clock times, so
+ * capture_reader can index and query it. Processors are renumbered: input
+ * i's processors start at merge_summary::processor_base[i].
+ *
+ * A merge is offline and must not lose records, so the output has no disk
+ * budget: @p output's disk_budget is ignored and no merged segment is ever
+ * removed. Make sure the output directory has room for the whole merge.
+ *
+ * @param inputs Captures to merge.
+ * @param output Where to write the merged capture.
+ * @throws std::runtime_error if an input cannot be read, or if a batch of
+ * merged records could not be stored or written.
+ */
+inline merge_summary merge_captures(std::span<const merge_input> inputs,
+                                    capture_options output) {
+  merge_summary summary;
+  std::vector<std::unique_ptr<detail::merge_cursor>> cursors;
+  uint32_t base{0};
+  for (const auto &input : inputs) {
+    summary.processor_base.push_back(base);
+    cursors.push_back(std::make_unique<detail::merge_cursor>(input, base));
+    base += detail::merge_cursor::processor_count(cursors.back()->reader());
+  }
+
+  using entry = std::pair<uint64_t, std::size_t>; ///< Time, input
+  std::priority_queue<entry, std::vector<entry>, std::greater<>> heads;
+  for (std::size_t input = 0; input < cursors.size(); ++input) {
+    if (!cursors[input]->done()) {
+      heads.emplace(cursors[input]->front().host_ns, input);
+    }
+  }
+
+  output.wall_clock_records = true;
+  output.disk_budget = std::numeric_limits<std::size_t>::max();
+  capture_writer writer{output};
+  auto batch_size = std::min<std::size_t>(
+      256, capture_block_capacity(output.block_size));
+  std::vector<sample_record> batch;
+  auto write = [&] {
+    if (!writer.append_wait(batch)) {
+      throw std::runtime_error("Failed to store merged SMI records");
+    }
+    batch.clear();
+  };
+
+  while (!heads.empty()) {
+    auto input = heads.top().second;
+    heads.pop();
+    auto &cursor = *cursors[input];
+    const auto &record = cursor.front();
+    if (summary.records++ == 0) {
+      summary.first_ns = record.host_ns;
+    }
+    summary.last_ns = record.host_ns;
+    batch.push_back(record);
+    cursor.pop();
+    if (!cursor.done()) {
+      heads.emplace(cursor.front().host_ns, input);
+    }
+    if (batch.size() == batch_size) {
+      write();
+    }
+  }
+  if (!batch.empty()) {
+    write();
+  }
+  writer.flush();
+  summary.output = writer.stats();
+  if (summary.output.failed_blocks != 0) {
+    throw std::runtime_error(
+        "Failed to write merged SMI capture: " +
+        std::to_string(summary.output.failed_blocks) + " blocks lost, errno " +
+        std::to_string(summary.output.last_error));
+  }
+  return summary;
+}
+
+} // namespace amd_smi
+} // namespace rocprofsys
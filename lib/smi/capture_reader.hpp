@@ -0,0 +1,460 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/capture_format.hpp"
+#include "smi/common.hpp"
+#include "smi/sample_batch.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Clock of the bounds of a range_query.
+ */
+enum class query_clock {
+  host,   ///< Host monotonic nanoseconds, as stored in records
+  system, ///< System clock nanoseconds since the Unix epoch
+};
+
+/**
+ * @struct range_query
+ * @brief Aggregate of one metric of one processor over a time range.
+ *
+ * System-clock bounds are converted to host time per block, with the
+ * block's realtime_offset_ns, so wall-clock ranges such as "between 14:02
+ * and 14:05" select the records sampled in that interval.
+ */
+struct range_query {
+  uint32_t processor{0};
+  metric_column column{metric_column::current_socket_power};
+  uint64_t begin_ns{0};                                  ///< Inclusive
+  uint64_t end_ns{std::numeric_limits<uint64_t>::max()}; ///< Exclusive
+  query_clock clock{query_clock::host}; ///< Clock of begin_ns and end_ns
+  /** Only values in [min_value, max_value] are aggregated. */
+  uint64_t min_value{0};
+  uint64_t max_value{std::numeric_limits<uint64_t>::max()};
+  std::vector<double> quantiles{}; ///< Requested quantiles, in [0, 1]
+
+  /** @brief Sets a system-clock range [begin, end). */
+  range_query &between(std::chrono::system_clock::time_point begin,
+                       std::chrono::system_clock::time_point end) {
+    auto since_epoch = [](std::chrono::system_clock::time_point time) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    time.time_since_epoch())
+                    .count();
+      return ns > 0 ? static_cast<uint64_t>(ns) : uint64_t{0};
+    };
+    clock = query_clock::system;
+    begin_ns = since_epoch(begin);
+    end_ns = since_epoch(end);
+    return *this;
+  }
+};
+
+/**
+ * @struct range_result
+ * @brief Result of a range_query.
+ */
+struct range_result {
+  uint64_t count{0};
+  uint64_t sum{0};
+  uint64_t min{std::numeric_limits<uint64_t>::max()};
+  uint64_t max{0};
+  std::vector<uint64_t> quantiles{}; ///< One per requested quantile
+  uint64_t blocks_scanned{0};        ///< Blocks whose records were read
+  uint64_t blocks_skipped{0};        ///< Blocks excluded by the index
+
+  double mean() const {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+  }
+};
+
+/**
+ * @class capture_reader
+ * @brief Answers time-range queries over capture segments written by
+ * capture_writer.
+ *
+ * Segments are memory-mapped and only their block headers are read up
+ * front. A query reads the records of blocks whose time range, processor
+ * set and column bounds can match, and skips the others; the remaining
+ * blocks are split across threads. Quantiles are exact (nearest rank).
+ */
+class capture_reader {
+public:
+  /**
+   * @brief Maps segment files and indexes their blocks.
+   * @throws std::runtime_error if a file cannot be opened or mapped.
+   */
+  explicit capture_reader(const std::vector<std::filesystem::path> &segments) {
+    for (const auto &path : segments) {
+      m_files.emplace_back(path);
+    }
+    for (const auto &file : m_files) {
+      index(file);
+    }
+  }
+
+  /**
+   * @brief Opens every segment of a capture in @p directory, oldest first.
+   */
+  static capture_reader
+  open_directory(const std::filesystem::path &directory,
+                 const std::string &prefix = "smi-capture") {
+    return capture_reader{capture_segments(directory, prefix)};
+  }
+
+  /** @brief Number of valid blocks in the capture. */
+  std::size_t block_count() const { return m_blocks.size(); }
+
+  /** @brief Number of records in the capture. */
+  uint64_t record_count() const {
+    uint64_t count{0};
+    for (const auto &current : m_blocks) {
+      count += current.header.record_count;
+    }
+    return count;
+  }
+
+  /**
+   * @brief Evaluates several queries in one pass over the capture.
+   * @param queries Queries to evaluate.
+   * @param threads Worker threads; zero uses every core.
+   * @return One result per query.
+   */
+  std::vector<range_result> query(std::span<const range_query> queries,
+                                  unsigned threads = 0) const {
+    std::vector<range_result> results(queries.size());
+    std::vector<const block_ref *> blocks; ///< Blocks needed by any query
+    for (const auto &current : m_blocks) {
+      bool wanted = false;
+      for (std::size_t q = 0; q < queries.size(); ++q) {
+        if (may_match(current.header, queries[q])) {
+          ++results[q].blocks_scanned;
+          wanted = true;
+        } else {
+          ++results[q].blocks_skipped;
+        }
+      }
+      if (wanted) {
+        blocks.push_back(&current);
+      }
+    }
+
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(
+        blocks.size(), 1, threads));
+    std::vector<std::vector<partial>> partials(
+        threads, std::vector<partial>(queries.size()));
+    auto scan = [&](unsigned worker) {
+      for (std::size_t b = worker; b < blocks.size(); b += threads) {
+        scan_block(*blocks[b], queries, partials[worker]);
+      }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned worker = 1; worker < threads; ++worker) {
+      workers.emplace_back(scan, worker);
+    }
+    scan(0);
+    for (auto &worker : workers) {
+      worker.join();
+    }
+
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+      auto &result = results[q];
+      std::vector<uint64_t> values;
+      for (auto &worker : partials) {
+        const auto &part = worker[q];
+        result.count += part.count;
+        result.sum += part.sum;
+        result.min = std::min(result.min, part.min);
+        result.max = std::max(result.max, part.max);
+        values.insert(values.end(), part.values.begin(), part.values.end());
+      }
+      result.quantiles = nearest_rank(values, queries[q].quantiles);
+    }
+    return results;
+  }
+
+  /** @brief Evaluates one query. */
+  range_result query(const range_query &request, unsigned threads = 0) const {
+    return std::move(query(std::span{&request, 1}, threads).front());
+  }
+
+  /** @brief Header of block @p index, in capture order. */
+  const capture_block_header &block_header(std::size_t index) const {
+    return m_blocks[index].header;
+  }
+
+  /**
+   * @brief Decodes the records of block @p index into @p records, reusing
+   * its allocation.
+   */
+  void read_block(std::size_t index,
+                  std::vector<sample_record> &records) const {
+    const auto &current = m_blocks[index];
+    records.resize(current.header.record_count);
+    for (uint32_t i = 0; i < current.header.record_count; ++i) {
+      records[i] = load_record(current.records + i * capture_record_size);
+    }
+  }
+
+  /**
+   * @brief Calls @p visit with every record in [begin_ns, end_ns), block by
+   * block in capture order.
+   */
+  template <typename visitor_t>
+  void for_each_record(uint64_t begin_ns, uint64_t end_ns,
+                       visitor_t &&visit) const {
+    std::vector<sample_record> records;
+    for (std::size_t index = 0; index < m_blocks.size(); ++index) {
+      const auto &header = m_blocks[index].header;
+      if (header.last_host_ns < begin_ns || header.first_host_ns >= end_ns) {
+        continue;
+      }
+      read_block(index, records);
+      for (const auto &record : records) {
+        if (record.host_ns >= begin_ns && record.host_ns < end_ns) {
+          visit(record);
+        }
+      }
+    }
+  }
+
+private:
+  class mapped_file {
+  public:
+    explicit mapped_file(const std::filesystem::path &path) {
+      int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        detail::throw_errno("Failed to open capture segment " + path.string());
+      }
+      struct stat status {};
+      if (fstat(fd, &status) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        detail::throw_errno("Failed to stat capture segment " + path.string());
+      }
+      m_size = static_cast<std::size_t>(status.st_size);
+      if (m_size != 0) {
+        void *mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+          int error = errno;
+          close(fd);
+          errno = error;
+          detail::throw_errno("Failed to map capture segment " + path.string());
+        }
+        m_data = static_cast<const std::byte *>(mapped);
+      }
+      close(fd);
+    }
+
+    mapped_file(mapped_file &&other) noexcept
+        : m_data{std::exchange(other.m_data, nullptr)},
+          m_size{std::exchange(other.m_size, 0)} {}
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+    mapped_file &operator=(mapped_file &&) = delete;
+
+    ~mapped_file() {
+      if (m_data != nullptr) {
+        munmap(const_cast<std::byte *>(m_data), m_size);
+      }
+    }
+
+    std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+
+  private:
+    const std::byte *m_data{nullptr};
+    std::size_t m_size{0};
+  };
+
+  struct block_ref {
+    capture_block_header header;
+    const std::byte *records;
+  };
+
+  struct partial {
+    uint64_t count{0};
+    uint64_t sum{0};
+    uint64_t min{std::numeric_limits<uint64_t>::max()};
+    uint64_t max{0};
+    std::vector<uint64_t> values;
+  };
+
+  /**
+   * @brief Adds the valid blocks of a segment to the index. Every block of
+   * a segment has the size given by its first valid header.
+   */
+  void index(const mapped_file &file) {
+    auto bytes = file.bytes();
+    std::size_t block_size{0};
+    for (std::size_t offset = 0; offset + capture_header_size <= bytes.size();
+         offset += block_size != 0 ? block_size : capture_block_alignment) {
+      capture_block_header header;
+      std::memcpy(&header, bytes.data() + offset, sizeof(header));
+      if (!header.valid() || (block_size != 0 && header.block_size !=
+                                                     block_size) ||
+          offset + header.block_size > bytes.size()) {
+        continue;
+      }
+      block_size = header.block_size;
+      if (header.kind == static_cast<uint16_t>(capture_block_kind::samples)) {
+        m_blocks.push_back(
+            {header, bytes.data() + offset + capture_header_size});
+      }
+    }
+  }
+
+  struct host_range {
+    uint64_t begin_ns;
+    uint64_t end_ns;
+  };
+
+  /** @brief Converts system nanoseconds to host time with @p offset. */
+  static uint64_t to_host_ns(uint64_t system_ns, int64_t offset) {
+    if (system_ns == std::numeric_limits<uint64_t>::max()) {
+      return system_ns;
+    }
+    if (offset >= 0) {
+      auto magnitude = static_cast<uint64_t>(offset);
+      return system_ns > magnitude ? system_ns - magnitude : 0;
+    }
+    auto magnitude = static_cast<uint64_t>(-(offset + 1)) + 1;
+    return system_ns < std::numeric_limits<uint64_t>::max() - magnitude
+               ? system_ns + magnitude
+               : std::numeric_limits<uint64_t>::max();
+  }
+
+  /** @brief Bounds of @p request in the host time of one block. */
+  static host_range bounds(const capture_block_header &header,
+                           const range_query &request) {
+    if (request.clock == query_clock::host) {
+      return {request.begin_ns, request.end_ns};
+    }
+    return {to_host_ns(request.begin_ns, header.realtime_offset_ns),
+            to_host_ns(request.end_ns, header.realtime_offset_ns)};
+  }
+
+  static bool may_match(const capture_block_header &header,
+                        const range_query &request) {
+    auto column = static_cast<std::size_t>(request.column);
+    auto range = bounds(header, request);
+    return header.last_host_ns >= range.begin_ns &&
+           header.first_host_ns < range.end_ns &&
+           request.processor >= header.min_processor &&
+           request.processor <= header.max_processor &&
+           (request.processor >= 64 ||
+            (header.processors >> request.processor) & 1) &&
+           header.max_values[column] >= request.min_value &&
+           header.min_values[column] <= request.max_value;
+  }
+
+  static void scan_block(const block_ref &current,
+                         std::span<const range_query> queries,
+                         std::vector<partial> &partials) {
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+      const auto &request = queries[q];
+      if (!may_match(current.header, request)) {
+        continue;
+      }
+      auto &part = partials[q];
+      auto range = bounds(current.header, request);
+      bool keep_values = !request.quantiles.empty();
+      for (uint32_t i = 0; i < current.header.record_count; ++i) {
+        const std::byte *record = current.records + i * capture_record_size;
+        uint64_t host_ns;
+        uint32_t processor;
+        std::memcpy(&host_ns, record, 8);
+        std::memcpy(&processor, record + 16, 4);
+        auto value = load_column(record, request.column);
+        if (processor != request.processor || host_ns < range.begin_ns ||
+            host_ns >= range.end_ns || value < request.min_value ||
+            value > request.max_value) {
+          continue;
+        }
+        ++part.count;
+        part.sum += value;
+        part.min = std::min(part.min, value);
+        part.max = std::max(part.max, value);
+        if (keep_values) {
+          part.values.push_back(value);
+        }
+      }
+    }
+  }
+
+  static std::vector<uint64_t>
+  nearest_rank(std::vector<uint64_t> &values,
+               const std::vector<double> &quantiles) {
+    std::vector<uint64_t> result;
+    if (values.empty()) {
+      result.assign(quantiles.size(), 0);
+      return result;
+    }
+    for (double quantile : quantiles) {
+      auto rank = static_cast<std::size_t>(
+          std::ceil(std::clamp(quantile, 0.0, 1.0) * values.size()));
+      auto index = rank == 0 ? 0 : rank - 1;
+      std::nth_element(values.begin(), values.begin() + index, values.end());
+      result.push_back(values[index]);
+    }
+    return result;
+  }
+
+  std::vector<mapped_file> m_files;
+  std::vector<block_ref> m_blocks; ///< Valid sample blocks, capture order
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,670 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/capture_format.hpp"
+#include "smi/common.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <filesystem>
+#include <linux/io_uring.h>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct capture_options
+ * @brief Where and how a capture_writer stores its segments.
+ */
+struct capture_options {
+  std::filesystem::path directory;     ///< Created if missing
+  std::string prefix{"smi-capture"};   ///< Segment file name prefix
+  std::size_t block_size{1 << 20};     ///< Multiple of 4096
+  std::size_t queue_blocks{8};         ///< Blocks between sampler and disk
+  std::size_t segment_size{64 << 20};  ///< Segment rotation size
+  std::size_t disk_budget{1ull << 30}; ///< Total size of all segments
+  /** Longest time a partly filled block waits before it is written. */
+  std::chrono::milliseconds flush_interval{1000};
+  bool use_io_uring{true}; ///< Fall back to pwrite() when false or missing
+  /** Records already carry system clock times; no offset is recorded. */
+  bool wall_clock_records{false};
+};
+
+/**
+ * @struct capture_stats
+ * @brief Counters of a capture_writer.
+ */
+struct capture_stats {
+  uint64_t batches{0};          ///< Batches passed to append()
+  uint64_t dropped_batches{0};  ///< Batches dropped for lack of buffers
+  uint64_t blocks_written{0};   ///< Blocks on disk
+  uint64_t failed_blocks{0};    ///< Blocks whose write failed
+  uint64_t bytes_written{0};    ///< Bytes on disk, including removed ones
+  uint64_t segments_created{0}; ///< Segment files opened
+  uint64_t segments_removed{0}; ///< Segments deleted to fit the budget
+  int last_error{0};            ///< errno of the latest failure
+};
+
+namespace detail {
+
+/**
+ * @class io_ring
+ * @brief Minimal io_uring submission of file writes, without liburing.
+ */
+class io_ring {
+public:
+  /**
+   * @brief Sets up a ring of at least @p entries submissions.
+   * @throws std::runtime_error if io_uring or its write operation is
+   * unavailable.
+   */
+  explicit io_ring(unsigned entries) {
+    io_uring_params params{};
+    m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (m_fd < 0) {
+      throw_errno("Failed to set up io_uring");
+    }
+    m_entries = params.sq_entries;
+    m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+    }
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    m_sq = map(m_sq_size, IORING_OFF_SQ_RING);
+    m_cq = single_mmap ? m_sq : map(m_cq_size, IORING_OFF_CQ_RING);
+    m_sqes = static_cast<io_uring_sqe *>(map(m_sqes_size, IORING_OFF_SQES));
+    if (m_sq == nullptr || m_cq == nullptr || m_sqes == nullptr) {
+      int error = errno;
+      release();
+      errno = error;
+      throw_errno("Failed to map io_uring");
+    }
+
+    auto *sq = static_cast<char *>(m_sq);
+    auto *cq = static_cast<char *>(m_cq);
+    m_sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    m_cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    if (!supports_write()) {
+      int error = errno;
+      release();
+      errno = error;
+      throw_errno("io_uring does not support writes");
+    }
+  }
+
+  io_ring(const io_ring &) = delete;
+  io_ring &operator=(const io_ring &) = delete;
+
+  ~io_ring() { release(); }
+
+  /** @brief Writes that can be queued before submit(). */
+  unsigned capacity() const { return m_entries; }
+
+  /** @brief Queues a write; @p tag identifies its completion. */
+  void write(int fd, const void *data, unsigned size, uint64_t offset,
+             uint64_t tag) {
+    unsigned tail = *m_sq_tail;
+    unsigned index = tail & m_sq_mask;
+    io_uring_sqe &entry = m_sqes[index];
+    std::memset(&entry, 0, sizeof(entry));
+    entry.opcode = IORING_OP_WRITE;
+    entry.fd = fd;
+    entry.addr = reinterpret_cast<uint64_t>(data);
+    entry.len = size;
+    entry.off = offset;
+    entry.user_data = tag;
+    m_sq_array[index] = index;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++m_queued;
+  }
+
+  /**
+   * @brief Submits the queued writes with one system call and waits for
+   * all of them.
+   * @param complete Called with the tag and result (bytes or -errno) of
+   * every write.
+   */
+  template <typename callback_t> void submit(callback_t &&complete) {
+    unsigned to_submit = m_queued;
+    unsigned remaining = m_queued;
+    m_queued = 0;
+    while (remaining > 0) {
+      auto entered = syscall(__NR_io_uring_enter, m_fd, to_submit, remaining,
+                             IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (entered < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw_errno("Failed to submit io_uring writes");
+      }
+      to_submit -= std::min<unsigned>(to_submit, entered);
+      unsigned head = *m_cq_head;
+      unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail && remaining > 0; ++head, --remaining) {
+        const io_uring_cqe &done = m_cqes[head & m_cq_mask];
+        complete(done.user_data, done.res);
+      }
+      __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+    }
+  }
+
+private:
+  /**
+   * @brief Whether the kernel implements IORING_OP_WRITE.
+   *
+   * Kernels 5.1 to 5.5 set up rings but fail every IORING_OP_WRITE with
+   * -EINVAL; they also lack IORING_REGISTER_PROBE, which answers the same.
+   */
+  bool supports_write() {
+    constexpr unsigned op_count = 256;
+    std::vector<unsigned char> storage(sizeof(io_uring_probe) +
+                                       op_count * sizeof(io_uring_probe_op));
+    auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+    if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe,
+                op_count) < 0) {
+      return false;
+    }
+    if (probe->last_op < IORING_OP_WRITE ||
+        (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) == 0) {
+      errno = EOPNOTSUPP;
+      return false;
+    }
+    return true;
+  }
+
+  /** @brief Maps a ring region; null on failure. */
+  void *map(std::size_t size, uint64_t offset) {
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_fd, offset);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+  }
+
+  void release() {
+    if (m_sqes != nullptr) {
+      munmap(m_sqes, m_sqes_size);
+    }
+    if (m_cq != nullptr && m_cq != m_sq) {
+      munmap(m_cq, m_cq_size);
+    }
+    if (m_sq != nullptr) {
+      munmap(m_sq, m_sq_size);
+    }
+    close(m_fd);
+  }
+
+  int m_fd{-1};
+  unsigned m_entries{0};
+  unsigned m_queued{0}; ///< Writes queued since the last submit()
+  std::size_t m_sq_size{0};
+  std::size_t m_cq_size{0};
+  std::size_t m_sqes_size{0};
+  void *m_sq{nullptr};
+  void *m_cq{nullptr};
+  io_uring_sqe *m_sqes{nullptr};
+  unsigned *m_sq_tail{nullptr};
+  unsigned m_sq_mask{0};
+  unsigned *m_sq_array{nullptr};
+  unsigned *m_cq_head{nullptr};
+  unsigned *m_cq_tail{nullptr};
+  unsigned m_cq_mask{0};
+  io_uring_cqe *m_cqes{nullptr};
+};
+
+} // namespace detail
+
+/**
+ * @class capture_writer
+ * @brief Writes sample records to rotating segment files without blocking
+ * the sampler.
+ *
+ * append() copies a batch into an in-memory block and returns; full blocks
+ * are written by a writer thread as whole, 4 KiB-aligned blocks, several
+ * per io_uring submission when io_uring is available and with pwrite()
+ * otherwise. When every block is waiting for the disk, append() drops the
+ * batch and counts it instead of waiting.
+ *
+ * Segments rotate at capture_options::segment_size; the oldest segments
+ * are deleted to keep the capture within capture_options::disk_budget.
+ * Segments of an earlier capture with the same prefix are deleted at
+ * construction, so a reader never mixes the two captures.
+ */
+class capture_writer {
+public:
+  /**
+   * @brief Allocates the blocks, creates the directory, deletes the
+   * segments of an earlier capture and starts the writer thread.
+   * @throws std::invalid_argument if the sizes are inconsistent.
+   * @throws std::filesystem::filesystem_error if the directory cannot be
+   * created or an earlier segment cannot be deleted.
+   */
+  explicit capture_writer(capture_options options)
+      : m_options{std::move(options)} {
+    if (m_options.block_size % capture_block_alignment != 0 ||
+        capture_block_capacity(m_options.block_size) == 0 ||
+        m_options.queue_blocks == 0 ||
+        m_options.segment_size < m_options.block_size ||
+        m_options.disk_budget < m_options.segment_size) {
+      throw std::invalid_argument("Inconsistent capture options");
+    }
+    std::filesystem::create_directories(m_options.directory);
+    for (const auto &path :
+         capture_segments(m_options.directory, m_options.prefix)) {
+      std::filesystem::remove(path);
+    }
+    if (m_options.use_io_uring) {
+      try {
+        m_ring = std::make_unique<detail::io_ring>(
+            static_cast<unsigned>(m_options.queue_blocks));
+        m_uring = true;
+      } catch (const std::runtime_error &) {
+        // Not supported by this kernel or disabled; use pwrite().
+      }
+    }
+    for (std::size_t i = 0; i < m_options.queue_blocks; ++i) {
+      m_blocks.push_back(std::make_unique<block>(m_options.block_size));
+      m_free.push_back(m_blocks.back().get());
+    }
+    m_thread = std::thread([this] { run(); });
+  }
+
+  capture_writer(const capture_writer &) = delete;
+  capture_writer &operator=(const capture_writer &) = delete;
+
+  /** @brief Writes the buffered records and closes the capture. */
+  ~capture_writer() {
+    {
+      std::lock_guard lock{m_mutex};
+      seal();
+      m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+    for (auto fd : m_retired_fds) {
+      close(fd);
+    }
+    if (m_segment_fd >= 0) {
+      close(m_segment_fd);
+    }
+  }
+
+  /** @brief True if blocks are written through io_uring. */
+  bool using_io_uring() const { return m_uring; }
+
+  /**
+   * @brief Queues a batch of records, such as one sampling round.
+   *
+   * A batch is never split across blocks. Never waits for the disk.
+   * @return False if the batch was dropped.
+   */
+  bool append(std::span<const sample_record> records) {
+    return store(records, false);
+  }
+
+  /**
+   * @brief Like append(), but waits for a free block instead of dropping
+   * the batch; for offline writers such as merge_captures().
+   * @return False only if the batch does not fit in a block.
+   */
+  bool append_wait(std::span<const sample_record> records) {
+    return store(records, true);
+  }
+
+  /**
+   * @brief Waits until every record appended so far is on disk (or its
+   * write failed).
+   */
+  void flush() {
+    std::unique_lock lock{m_mutex};
+    seal();
+    auto target = m_sealed;
+    m_wake.notify_one();
+    m_done_cv.wait(lock, [&] { return m_done >= target; });
+  }
+
+  /** @brief Returns a copy of the counters. */
+  capture_stats stats() const {
+    std::lock_guard lock{m_mutex};
+    return m_stats;
+  }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  bool store(std::span<const sample_record> records, bool wait) {
+    if (records.empty()) {
+      return true;
+    }
+    std::unique_lock lock{m_mutex};
+    ++m_stats.batches;
+    auto capacity = capture_block_capacity(m_options.block_size);
+    if (records.size() > capacity) {
+      ++m_stats.dropped_batches;
+      return false;
+    }
+    if (m_current != nullptr &&
+        m_current->header.record_count + records.size() > capacity) {
+      seal();
+    }
+    if (m_current == nullptr) {
+      if (m_free.empty() && wait) {
+        m_done_cv.wait(lock, [this] { return !m_free.empty(); });
+      }
+      if (m_free.empty()) {
+        ++m_stats.dropped_batches;
+        return false;
+      }
+      m_current = m_free.front();
+      m_free.pop_front();
+      m_current->header = capture_block_header{};
+      m_current->opened = clock::now();
+    }
+    auto *out = m_current->records() +
+                m_current->header.record_count * capture_record_size;
+    for (const auto &record : records) {
+      store_record(out, record);
+      out += capture_record_size;
+      m_current->header.include(record);
+    }
+    return true;
+  }
+
+  struct block {
+    explicit block(std::size_t size)
+        : data{static_cast<std::byte *>(
+              std::aligned_alloc(capture_block_alignment, size))} {
+      if (data == nullptr) {
+        throw std::bad_alloc();
+      }
+    }
+    ~block() { std::free(data); }
+    block(const block &) = delete;
+    block &operator=(const block &) = delete;
+
+    std::byte *records() { return data + capture_header_size; }
+
+    std::byte *data;
+    capture_block_header header;
+    clock::time_point opened;
+    int fd{-1};         ///< Destination segment, set by the writer
+    uint64_t offset{0}; ///< Destination offset, set by the writer
+    int result{0};      ///< Bytes written or -errno
+  };
+
+  /** @brief Hands the current block to the writer. Needs m_mutex. */
+  void seal() {
+    if (m_current == nullptr) {
+      return;
+    }
+    if (m_current->header.record_count == 0) {
+      m_free.push_back(m_current);
+    } else {
+      auto &header = m_current->header;
+      header.payload_bytes =
+          static_cast<uint32_t>(header.record_count * capture_record_size);
+      header.block_size = static_cast<uint32_t>(m_options.block_size);
+      header.realtime_offset_ns =
+          m_options.wall_clock_records ? 0 : measure_realtime_offset_ns();
+      std::memset(m_current->data, 0, capture_header_size);
+      std::memcpy(m_current->data, &header, sizeof(header));
+      std::memset(m_current->records() + header.payload_bytes, 0,
+                  m_options.block_size - capture_header_size -
+                      header.payload_bytes);
+      m_full.push_back(m_current);
+      ++m_sealed;
+      m_wake.notify_one();
+    }
+    m_current = nullptr;
+  }
+
+  void run() {
+    std::vector<block *> group;
+    std::unique_lock lock{m_mutex};
+    for (;;) {
+      m_wake.wait_for(lock, m_options.flush_interval,
+                      [this] { return m_stopping || !m_full.empty(); });
+      if (m_current != nullptr &&
+          clock::now() - m_current->opened >= m_options.flush_interval) {
+        seal();
+      }
+      if (m_full.empty()) {
+        if (m_stopping) {
+          return;
+        }
+        continue;
+      }
+      std::size_t limit = m_uring ? m_ring->capacity() : 1;
+      group.clear();
+      while (!m_full.empty() && group.size() < limit) {
+        group.push_back(m_full.front());
+        m_full.pop_front();
+      }
+
+      lock.unlock();
+      capture_stats delta;
+      write_group(group, delta);
+      lock.lock();
+
+      for (auto *written : group) {
+        m_free.push_back(written);
+      }
+      m_stats.blocks_written += delta.blocks_written;
+      m_stats.failed_blocks += delta.failed_blocks;
+      m_stats.bytes_written += delta.bytes_written;
+      m_stats.segments_created += delta.segments_created;
+      m_stats.segments_removed += delta.segments_removed;
+      if (delta.last_error != 0) {
+        m_stats.last_error = delta.last_error;
+      }
+      m_done += group.size();
+      m_done_cv.notify_all();
+    }
+  }
+
+  /** @brief Places and writes blocks; runs on the writer thread only. */
+  void write_group(std::span<block *> group, capture_stats &delta) {
+    for (auto *current : group) {
+      place(*current, delta);
+    }
+    bool submitted{false};
+    if (m_uring) {
+      for (std::size_t i = 0; i < group.size(); ++i) {
+        if (group[i]->fd >= 0) {
+          m_ring->write(group[i]->fd, group[i]->data,
+                        static_cast<unsigned>(m_options.block_size),
+                        group[i]->offset, i);
+        }
+      }
+      try {
+        m_ring->submit(
+            [&](uint64_t tag, int result) { group[tag]->result = result; });
+        submitted = true;
+      } catch (const std::runtime_error &) {
+        // The ring state is unknown; use pwrite() from now on.
+        m_uring = false;
+      }
+    }
+    for (auto *current : group) {
+      if (current->fd < 0) {
+        // Not placed; result holds the error.
+      } else if (!submitted) {
+        current->result = write_block(*current, 0);
+      } else if (current->result == -EINVAL ||
+                 current->result == -EOPNOTSUPP) {
+        // The ring cannot write to this file; use pwrite() from now on.
+        m_uring = false;
+        current->result = write_block(*current, 0);
+      } else if (current->result >= 0 &&
+                 current->result < static_cast<int>(m_options.block_size)) {
+        // Short write: finish the block synchronously.
+        current->result =
+            write_block(*current, static_cast<std::size_t>(current->result));
+      }
+      if (current->result == static_cast<int>(m_options.block_size)) {
+        ++delta.blocks_written;
+        delta.bytes_written += m_options.block_size;
+      } else {
+        ++delta.failed_blocks;
+        if (current->result < 0) {
+          delta.last_error = -current->result;
+        }
+      }
+    }
+    for (auto fd : m_retired_fds) {
+      close(fd);
+    }
+    m_retired_fds.clear();
+  }
+
+  /** @brief Writes a block from byte @p written on with pwrite(). */
+  int write_block(const block &current, std::size_t written) const {
+    while (written < m_options.block_size) {
+      auto result = pwrite(current.fd, current.data + written,
+                           m_options.block_size - written,
+                           static_cast<off_t>(current.offset + written));
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return -errno;
+      }
+      written += static_cast<std::size_t>(result);
+    }
+    return static_cast<int>(written);
+  }
+
+  /** @brief Picks the segment and offset of a block, rotating as needed. */
+  void place(block &current, capture_stats &delta) {
+    current.fd = -1;
+    current.result = -EIO;
+    if (m_segment_fd < 0 ||
+        m_segment_offset + m_options.block_size > m_options.segment_size) {
+      if (!rotate(delta)) {
+        current.result = -delta.last_error;
+        return;
+      }
+    }
+    while (m_disk_bytes + m_options.block_size > m_options.disk_budget &&
+           m_segments.size() > 1) {
+      std::error_code ignored;
+      std::filesystem::remove(m_segments.front().path, ignored);
+      m_disk_bytes -= m_segments.front().bytes;
+      m_segments.pop_front();
+      ++delta.segments_removed;
+    }
+    current.fd = m_segment_fd;
+    current.offset = m_segment_offset;
+    m_segment_offset += m_options.block_size;
+    m_disk_bytes += m_options.block_size;
+    m_segments.back().bytes += m_options.block_size;
+  }
+
+  bool rotate(capture_stats &delta) {
+    auto path = m_options.directory /
+                capture_segment_name(m_options.prefix, m_segment_index);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+    if (fd < 0) {
+      delta.last_error = errno;
+      return false;
+    }
+    ++m_segment_index;
+    if (m_segment_fd >= 0) {
+      // Blocks of this group may still be writing to it.
+      m_retired_fds.push_back(m_segment_fd);
+    }
+    m_segment_fd = fd;
+    m_segment_offset = 0;
+    m_segments.push_back({std::move(path), 0});
+    ++delta.segments_created;
+    return true;
+  }
+
+  struct segment {
+    std::filesystem::path path;
+    std::size_t bytes;
+  };
+
+  capture_options m_options;
+  std::unique_ptr<detail::io_ring> m_ring;
+  std::atomic<bool> m_uring{false}; ///< Writes go through m_ring
+  std::vector<std::unique_ptr<block>> m_blocks;
+
+  mutable std::mutex m_mutex; ///< Guards the queues and the counters
+  std::condition_variable m_wake;
+  std::condition_variable m_done_cv;
+  std::deque<block *> m_free;   ///< Blocks ready to be filled
+  std::deque<block *> m_full;   ///< Sealed blocks waiting for the writer
+  block *m_current{nullptr};    ///< Block being filled by append()
+  uint64_t m_sealed{0};         ///< Blocks handed to the writer
+  uint64_t m_done{0};           ///< Blocks written or failed
+  bool m_stopping{false};
+  capture_stats m_stats;
+
+  // Writer thread state
+  int m_segment_fd{-1};
+  uint64_t m_segment_offset{0};
+  uint32_t m_segment_index{0};
+  std::size_t m_disk_bytes{0};
+  std::deque<segment> m_segments; ///< Oldest first
+  std::vector<int> m_retired_fds;
+  std::thread m_thread;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
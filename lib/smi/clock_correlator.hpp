@@ -0,0 +1,177 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct clock_fit
+ * @brief Linear mapping from a GPU clock counter to host monotonic time.
+ *
+ * host_ns = host_origin + offset_ns + slope * (counter - gpu_origin). Both
+ * domains are kept relative to an origin so the fit stays precise in double
+ * arithmetic however long the process runs.
+ */
+struct clock_fit {
+  uint64_t gpu_origin{0};  ///< Counter value of the first accepted point
+  uint64_t host_origin{0}; ///< Host time of the first accepted point
+  double slope{0.0};       ///< Host nanoseconds per counter tick
+  double offset_ns{0.0};   ///< Host time at gpu_origin, from host_origin
+  double residual_ns{0.0}; ///< RMS distance of the points from the fit
+  std::size_t points{0};   ///< Points in the fit
+
+  /**
+   * @brief Whether the fit can map counters: at least two points, spread
+   * over distinct counter values so the slope is positive.
+   */
+  bool valid() const { return points >= 2 && slope > 0.0; }
+
+  /** @brief Converts a GPU clock counter value to host nanoseconds. */
+  uint64_t to_host_ns(uint64_t counter) const {
+    auto ticks =
+        static_cast<double>(static_cast<int64_t>(counter - gpu_origin));
+    return host_origin +
+           static_cast<uint64_t>(std::llround(offset_ns + slope * ticks));
+  }
+};
+
+/**
+ * @class clock_correlator
+ * @brief Continuously fits a GPU clock domain against the host clock.
+ *
+ * Each accepted sample_timestamp contributes the midpoint of its host window
+ * paired with the GPU clock counter. Samples whose window is wider than
+ * max_uncertainty_ns (for example because the sampling thread was
+ * preempted during the driver call) are rejected. The fit is an ordinary
+ * least-squares line over the last window_size points, refreshed on every
+ * accepted point. A counter that goes backwards (GPU reset) restarts the
+ * fit.
+ */
+class clock_correlator {
+public:
+  /**
+   * @brief Constructs an empty correlator.
+   * @param window_size Number of recent points used by the fit.
+   * @param max_uncertainty_ns Widest host window accepted.
+   */
+  explicit clock_correlator(std::size_t window_size = 64,
+                            uint64_t max_uncertainty_ns = 1'000'000)
+      : m_window_size{window_size < 2 ? 2 : window_size},
+        m_max_uncertainty_ns{max_uncertainty_ns} {}
+
+  /**
+   * @brief Adds a timestamp pair and refits.
+   * @return False if the point was rejected.
+   */
+  bool add(const sample_timestamp &timestamp) {
+    if (timestamp.gpu_clock_counter == 0 ||
+        timestamp.host_end_ns < timestamp.host_begin_ns ||
+        timestamp.uncertainty_ns() > m_max_uncertainty_ns) {
+      return false;
+    }
+    if (m_points.empty() || timestamp.gpu_clock_counter < m_last_counter) {
+      m_points.clear();
+      m_next = 0;
+      m_fit = clock_fit{};
+      m_fit.gpu_origin = timestamp.gpu_clock_counter;
+      m_fit.host_origin = timestamp.host_ns();
+    }
+    m_last_counter = timestamp.gpu_clock_counter;
+
+    point current{
+        static_cast<double>(timestamp.gpu_clock_counter - m_fit.gpu_origin),
+        static_cast<double>(
+            static_cast<int64_t>(timestamp.host_ns() - m_fit.host_origin))};
+    if (m_points.size() < m_window_size) {
+      m_points.push_back(current);
+    } else {
+      m_points[m_next] = current;
+      m_next = (m_next + 1) % m_window_size;
+    }
+    refit();
+    return true;
+  }
+
+  /** @brief Current fit. */
+  const clock_fit &fit() const { return m_fit; }
+
+private:
+  struct point {
+    double gpu;
+    double host;
+  };
+
+  void refit() {
+    double count = static_cast<double>(m_points.size());
+    double mean_gpu{0.0};
+    double mean_host{0.0};
+    for (const auto &current : m_points) {
+      mean_gpu += current.gpu;
+      mean_host += current.host;
+    }
+    mean_gpu /= count;
+    mean_host /= count;
+
+    double covariance{0.0};
+    double variance{0.0};
+    for (const auto &current : m_points) {
+      covariance += (current.gpu - mean_gpu) * (current.host - mean_host);
+      variance += (current.gpu - mean_gpu) * (current.gpu - mean_gpu);
+    }
+    m_fit.slope = variance > 0.0 ? covariance / variance : 0.0;
+    m_fit.offset_ns = mean_host - m_fit.slope * mean_gpu;
+
+    double squares{0.0};
+    for (const auto &current : m_points) {
+      double error =
+          current.host - (m_fit.offset_ns + m_fit.slope * current.gpu);
+      squares += error * error;
+    }
+    m_fit.residual_ns = std::sqrt(squares / count);
+    m_fit.points = m_points.size();
+  }
+
+  std::size_t m_window_size;
+  uint64_t m_max_uncertainty_ns;
+  std::vector<point> m_points; ///< Ring buffer of the latest points
+  std::size_t m_next{0};       ///< Oldest point once the ring is full
+  uint64_t m_last_counter{0};
+  clock_fit m_fit{};
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
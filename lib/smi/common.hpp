@@ -1,7 +1,10 @@
 #pragma once
 
 #include <amd_smi/amdsmi.h>
+#include <cerrno>
+#include <cstring>
 #include <fmt/format.h>
+#include <stdexcept>
 #include <string>
 
 namespace rocprofsys {
@@ -23,5 +26,14 @@ inline void check_status(const amdsmi_status_t &status,
   }
 };
 
+namespace detail {
+
+/** @brief Throws std::runtime_error with @p what and the errno text. */
+[[noreturn]] inline void throw_errno(const std::string &what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+} // namespace detail
+
 } // namespace amd_smi
 } // namespace rocprofsys
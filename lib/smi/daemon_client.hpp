@@ -0,0 +1,263 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/data_collector.hpp"
+#include "smi/metrics_endpoint.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @class daemon_client
+ * @brief Receives samples from a sampling_daemon with a data_collector-like
+ * interface.
+ *
+ * Replacing a data_collector with a daemon_client keeps read(),
+ * read_metrics() and read_memory() but neither initializes the driver nor
+ * samples in this process. read() returns the latest record received for
+ * every processor; next_batch() gives every record, for clients that need
+ * the full series.
+ */
+class daemon_client {
+public:
+  /**
+   * @brief Connects to a daemon and subscribes.
+   * @param socket_path Unix socket of the daemon.
+   * @param request Processors, metrics, period and batch size to receive.
+   * @throws std::runtime_error if the daemon cannot be reached or rejects
+   * the subscription.
+   */
+  explicit daemon_client(const std::string &socket_path,
+                         const subscription &request = {})
+      : m_fd{connect_to(socket_path)} {
+    try {
+      subscribe(request);
+    } catch (...) {
+      close(m_fd);
+      throw;
+    }
+  }
+
+  daemon_client(const daemon_client &) = delete;
+  daemon_client &operator=(const daemon_client &) = delete;
+
+  ~daemon_client() { close(m_fd); }
+
+  /**
+   * @brief Replaces the subscription.
+   * @throws std::runtime_error if the daemon rejects it.
+   */
+  void subscribe(const subscription &request) {
+    auto encoded =
+        encode_frame(frame_type::subscribe, encode_subscription(request));
+    if (!detail::send_all(m_fd, encoded)) {
+      detail::throw_errno("Failed to send SMI subscription");
+    }
+    // Batches still in flight for the old subscription are kept.
+    for (;;) {
+      auto next = receive(std::nullopt);
+      if (next->type == frame_type::subscribed) {
+        std::string_view payload{next->payload};
+        auto count = detail::take<uint32_t>(payload);
+        m_samples.resize(count);
+        m_metrics.resize(count);
+        m_memory.resize(count);
+        return;
+      }
+      apply(*next);
+    }
+  }
+
+  /** @brief Number of processors sampled by the daemon. */
+  std::size_t processor_count() const { return m_samples.size(); }
+
+  /**
+   * @brief Returns the latest sample of every processor.
+   *
+   * Applies every frame received so far without blocking; blocks for the
+   * first samples frame only.
+   * @throws std::runtime_error if the connection is lost.
+   */
+  const std::vector<data_sample> &read() {
+    if (!m_received) {
+      apply(*receive(std::nullopt));
+    }
+    while (auto next = receive(std::chrono::milliseconds{0})) {
+      apply(*next);
+    }
+    return m_samples;
+  }
+
+  /**
+   * @brief Returns the latest metrics of one processor as of the last
+   * read() or next_batch(); unsubscribed columns are zero.
+   */
+  smi_metrics read_metrics(std::size_t id) const { return m_metrics[id]; }
+
+  /**
+   * @brief Returns the memory usage of one processor as of the last read()
+   * or next_batch(). Only VRAM usage is carried by the protocol; the other
+   * memory types and the sizes are zero.
+   */
+  memory_snapshot read_memory(std::size_t id) const { return m_memory[id]; }
+
+  /**
+   * @brief Waits for the next samples frame and returns its records.
+   * @param timeout Longest wait; an empty result means it expired.
+   * @throws std::runtime_error if the connection is lost.
+   */
+  std::vector<sample_record> next_batch(std::chrono::milliseconds timeout) {
+    while (auto next = receive(timeout)) {
+      if (next->type == frame_type::samples) {
+        return apply(*next);
+      }
+      apply(*next);
+    }
+    return {};
+  }
+
+private:
+  static int connect_to(const std::string &socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+      throw std::runtime_error("SMI daemon socket path is too long");
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      detail::throw_errno("Failed to create SMI client socket");
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) != 0) {
+      int error = errno;
+      close(fd);
+      errno = error;
+      detail::throw_errno("Failed to connect to SMI daemon");
+    }
+    return fd;
+  }
+
+  /**
+   * @brief Returns the next frame, waiting at most @p timeout (forever
+   * when empty).
+   */
+  std::optional<frame>
+  receive(std::optional<std::chrono::milliseconds> timeout) {
+    for (;;) {
+      if (auto next = m_reader.next()) {
+        return next;
+      }
+      pollfd fd{m_fd, POLLIN, 0};
+      int ready = poll(&fd, 1, timeout ? static_cast<int>(timeout->count())
+                                       : -1);
+      if (ready == 0) {
+        return std::nullopt;
+      }
+      if (ready < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        detail::throw_errno("Failed to wait for SMI daemon");
+      }
+      char buffer[4096];
+      auto received = recv(m_fd, buffer, sizeof(buffer), 0);
+      if (received <= 0) {
+        throw std::runtime_error("Connection to SMI daemon lost");
+      }
+      m_reader.feed({buffer, static_cast<std::size_t>(received)});
+    }
+  }
+
+  std::vector<sample_record> apply(const frame &next) {
+    if (next.type == frame_type::error) {
+      throw std::runtime_error("SMI daemon error: " + next.payload);
+    }
+    if (next.type != frame_type::samples) {
+      return {};
+    }
+    auto records = decode_samples(next.payload);
+    for (const auto &record : records) {
+      if (record.processor >= m_samples.size()) {
+        continue;
+      }
+      auto &metrics = m_metrics[record.processor];
+      metrics.current_socket_power =
+          record.value(metric_column::current_socket_power);
+      metrics.average_socket_power =
+          record.value(metric_column::average_socket_power);
+      auto vram_used = record.value(metric_column::memory_usage);
+      m_memory[record.processor].used[AMDSMI_MEM_TYPE_VRAM] = vram_used;
+      metrics.memory_usage = static_cast<uint32_t>(vram_used);
+      metrics.hotspot_temperature = static_cast<uint16_t>(
+          record.value(metric_column::hotspot_temperature));
+      metrics.edge_temperature =
+          static_cast<uint16_t>(record.value(metric_column::edge_temperature));
+      metrics.gfx_activity = record.value(metric_column::gfx_activity);
+      metrics.umc_activity = record.value(metric_column::umc_activity);
+      metrics.mm_activity = record.value(metric_column::mm_activity);
+
+      auto &sample = m_samples[record.processor];
+      sample.power = metrics.current_socket_power;
+      sample.temperature = metrics.hotspot_temperature;
+      sample.usage = metrics.gfx_activity;
+      sample.timestamp.host_begin_ns = record.host_ns;
+      sample.timestamp.host_end_ns = record.host_ns;
+      sample.timestamp.gpu_clock_counter = record.gpu_clock_counter;
+    }
+    m_received = true;
+    return records;
+  }
+
+  int m_fd;
+  frame_reader m_reader;
+  bool m_received{false}; ///< A samples frame has arrived
+  std::vector<data_sample> m_samples;
+  std::vector<smi_metrics> m_metrics;
+  std::vector<memory_snapshot> m_memory;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -11,10 +11,35 @@
 
 #pragma once
 
+#include "async_generator.hpp"
+#include "capture_writer.hpp"
+#include "clock_correlator.hpp"
+#include "derived_metrics.hpp"
+#include "event_engine.hpp"
+#include "metrics_endpoint.hpp"
+#include "node_aggregate.hpp"
+#include "processor_filter.hpp"
+#include "process_tracker.hpp"
+#include "prometheus_exposition.hpp"
+#include "round_signal.hpp"
+#include "sampler_overhead.hpp"
+#include "sampling_scheduler.hpp"
 #include "service.hpp"
+#include "supervised_reader.hpp"
+#include "throttle_tracker.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace rocprofsys {
 namespace amd_smi {
@@ -23,12 +48,14 @@ namespace amd_smi {
  * @struct data_sample
  * @brief Represents a single sample of processor metrics.
  *
- * Contains temperature, power, and usage data for a processor.
+ * Contains temperature, power, and usage data for a processor, and when the
+ * underlying driver read happened.
  */
 struct data_sample {
-  int64_t temperature; ///< Processor temperature in millidegrees Celsius
-  uint32_t power;      ///< Processor power in milliwatts
-  uint32_t usage;      ///< Processor usage (custom metric)
+  int64_t temperature;        ///< Processor temperature in millidegrees Celsius
+  uint32_t power;             ///< Processor power in milliwatts
+  uint32_t usage;             ///< Processor usage (custom metric)
+  sample_timestamp timestamp; ///< Host window and GPU clock of the read
 };
 
 /**
@@ -38,49 +65,757 @@ struct data_sample {
  * driver.
  *
  * The data_collector class initializes the SMI service, enumerates all
- * processors, and provides a method to read temperature and power metrics for
- * each processor.
+ * processors into a flat processor table, and provides a method to read
+ * temperature and power metrics for each processor.
  */
-template <typename driver_factory> struct data_collector {
+template <smi_driver_factory driver_factory> struct data_collector {
 
   using driver_t = driver_factory::driver_t;
 
   /**
-   * @brief Constructs a data_collector and initializes processor list.
+   * @brief Constructs a data_collector and initializes processor table.
+   * @param filter Processors to enumerate and sample; AMD GPUs by default.
    */
-  data_collector()
-      : m_smi_service(std::make_unique<service<driver_factory>>()) {
-    m_processors = m_smi_service->get_processors();
+  explicit data_collector(
+      processor_filter filter = processor_filter::amd_gpus())
+      : m_smi_service(
+            std::make_unique<service<driver_factory>>(std::move(filter))),
+        m_processors(m_smi_service->get_processor_table()),
+        m_events(m_processors.size()),
+        m_derived(standard_derived_metrics(), m_processors.size()),
+        m_node(m_processors.size()), m_exposition(m_processors.size()),
+        m_throttle(m_processors.size()),
+        m_published_derived(m_derived) {
+    m_processors.probe();
     std::cout << "Processors size " << m_processors.size() << std::endl;
     m_sample.resize(m_processors.size());
+    m_published.resize(m_processors.size());
+    m_published_metrics.resize(m_processors.size());
+    m_published_memory.resize(m_processors.size());
+    m_published_statuses.resize(m_processors.size(), AMDSMI_STATUS_NO_DATA);
+    m_clocks.resize(m_processors.size());
+    m_published_clocks.resize(m_processors.size());
   }
 
   /**
    * @brief Reads temperature and power metrics from all processors.
    * @return Reference to the vector of data_sample structs.
-   * @note If a processor read fails, the error is logged and the sample is not
-   * updated.
+   * @note If a processor read fails, its sample is not updated and
+   * read_statuses() reports the error. While the background scheduler is
+   * running, the samples it last published are returned instead of reading
+   * the driver. With a call deadline set, processors that miss it count as
+   * failed reads.
    */
   const std::vector<data_sample> &read() {
-    size_t id{0};
-    for (auto &item : m_processors) {
-      try {
-        m_sample[id++].power = item->get_power_info();
-        m_sample[id++].temperature = item->get_temperature_info();
-      } catch (std::runtime_error &error) {
-        std::cout << "Failed to read info for the processo id %d. Error: "
-                  << error.what() << std::endl;
+    if (!m_scheduler) {
+      if (m_reader) {
+        m_reader->read({});
+      } else {
+        m_processors.sample();
       }
+      complete_round({});
     }
+
+    std::lock_guard lock{m_published_mutex};
+    m_sample = m_published;
     return m_sample;
   }
 
+  /**
+   * @brief Starts sampling in the background at the rates of @p policy.
+   * @note Does nothing if the scheduler is already running.
+   * @throws std::system_error if sampling_policy::placement cannot be
+   * applied; read() keeps sampling synchronously.
+   */
+  void start(const sampling_policy &policy = {}) {
+    if (m_scheduler) {
+      return;
+    }
+    auto scheduler = std::make_unique<sampling_scheduler<driver_t>>(
+        m_processors, policy,
+        [this](const processor_table<driver_t> &,
+               std::span<const group_mask> due) { complete_round(due); });
+    scheduler->set_reader(m_reader.get());
+    scheduler->start();
+    m_scheduler = std::move(scheduler);
+  }
+
+  /**
+   * @brief Stops background sampling; read() samples synchronously again.
+   */
+  void stop() { m_scheduler.reset(); }
+
+  /**
+   * @brief Bounds the time a sampling round waits for driver calls.
+   *
+   * Each processor is then read on its own worker thread. Processors whose
+   * calls miss the deadline are missing from that round (their status is
+   * AMDSMI_STATUS_TIMEOUT) while the others publish on time; see
+   * read_health().
+   * @param deadline Per-round deadline; zero reads inline again.
+   * @param hang_threshold Consecutive missed rounds after which a processor
+   * is reported as hung.
+   * @note Must be called before start().
+   */
+  void set_call_deadline(std::chrono::nanoseconds deadline,
+                         uint32_t hang_threshold = 3) {
+    m_reader.reset();
+    if (deadline > std::chrono::nanoseconds::zero()) {
+      m_reader = std::make_unique<supervised_reader<driver_t>>(
+          m_processors, deadline, hang_threshold);
+    }
+  }
+
+  /**
+   * @brief Returns the status of the latest read of every processor, as of
+   * the latest published round.
+   *
+   * AMDSMI_STATUS_SUCCESS when the published sample is fresh; otherwise the
+   * driver error, AMDSMI_STATUS_TIMEOUT for a missed call deadline, or
+   * AMDSMI_STATUS_NO_DATA before the first read.
+   */
+  std::vector<amdsmi_status_t> read_statuses() {
+    std::lock_guard lock{m_published_mutex};
+    return m_published_statuses;
+  }
+
+  /**
+   * @brief Returns the driver call health of every processor.
+   *
+   * Empty statistics are returned while no call deadline is set.
+   */
+  std::vector<call_health> read_health() const {
+    return m_reader ? m_reader->health()
+                    : std::vector<call_health>(m_processors.size());
+  }
+
+  /**
+   * @brief Re-enumerates processors and applies the difference.
+   *
+   * Processors are matched by stable identity (PCI address when the driver
+   * reports it). Only new processors are probed; vanished processors are
+   * retired and drop out of sampling, events, derived metrics and node
+   * totals; processors that changed handle keep all their state. Rows keep
+   * their index, so processor ids stay valid. While the background
+   * scheduler runs, the change is applied on the scheduler thread between
+   * two ticks, so sampling does not pause; called from the scheduler
+   * thread itself (e.g. from a coroutine resumed by next_round()), it is
+   * applied directly.
+   * @return The rows that were added, retired or rebound.
+   * @throws std::runtime_error if processor enumeration fails.
+   */
+  enumeration_diff rescan() {
+    auto discovered = m_smi_service->discover();
+    if (!m_scheduler) {
+      return apply_enumeration(discovered);
+    }
+
+    std::promise<enumeration_diff> applied;
+    auto result = applied.get_future();
+    bool posted = m_scheduler->post_to_thread([&] {
+      try {
+        applied.set_value(apply_enumeration(discovered));
+      } catch (...) {
+        applied.set_exception(std::current_exception());
+      }
+    });
+    if (!posted) {
+      return apply_enumeration(discovered);
+    }
+    return result.get();
+  }
+
+  /**
+   * @brief Current sampling period multiplier of a processor.
+   *
+   * Greater than one only while the background scheduler runs with
+   * sampling_policy::adaptive enabled and the processor's metrics are stable.
+   */
+  uint32_t sampling_stride(size_t id) const {
+    return m_scheduler ? m_scheduler->stride(id) : 1;
+  }
+
+  /**
+   * @brief Measured cost of the background scheduler: CPU time per round,
+   * wakeup latency and the jitter of actual versus nominal tick times.
+   *
+   * CPU time is that of the scheduler thread plus, with set_call_deadline(),
+   * that of the workers issuing the driver calls.
+   *
+   * Empty while the scheduler is stopped. Thread placement and priority are
+   * set through sampling_policy::placement in start().
+   */
+  sampler_overhead read_overhead() const {
+    return m_scheduler ? m_scheduler->overhead() : sampler_overhead{};
+  }
+
+  /**
+   * @brief Records every round to disk through a capture_writer.
+   *
+   * Each round appends one record per processor read in that round. The
+   * sampling thread only copies the records into a buffer; a full buffer
+   * drops the round rather than delaying the sampler (see
+   * read_capture_stats()).
+   * @note Must be called before start(); replaces a previous capture.
+   * @throws std::invalid_argument if the options are inconsistent.
+   */
+  void start_capture(capture_options options) {
+    m_capture.reset();
+    m_capture = std::make_unique<capture_writer>(std::move(options));
+  }
+
+  /**
+   * @brief Writes the buffered records and closes the capture.
+   * @note Must not be called while the background scheduler runs.
+   */
+  void stop_capture() { m_capture.reset(); }
+
+  /** @brief Counters of the capture; empty while not capturing. */
+  capture_stats read_capture_stats() const {
+    return m_capture ? m_capture->stats() : capture_stats{};
+  }
+
+  /**
+   * @brief Samples the process list of every processor at most once per
+   * @p period, as part of the sampling rounds.
+   *
+   * Only processes that appeared, changed by at least @p thresholds or
+   * disappeared since the previous list are queued for
+   * read_process_changes(). Processors whose driver does not support process
+   * queries are skipped after the first attempt.
+   *
+   * Process lists are read on the sampling thread and are not bounded by
+   * set_call_deadline(): a get_process_list call that hangs stalls every
+   * round until it returns. To keep a processor that already hangs from
+   * stalling them, processors whose latest metric read timed out are not
+   * asked for their process list.
+   * @param period Minimum time between two process list reads; zero stops
+   * process sampling and forgets the known processes.
+   * @param thresholds Minimum movement reported as a change.
+   * @note Must be called before start(). Requires a driver with process list
+   * queries (process_driver).
+   */
+  void set_process_sampling(std::chrono::nanoseconds period,
+                            process_thresholds thresholds = {})
+    requires process_driver<driver_t>
+  {
+    std::lock_guard lock{m_process_mutex};
+    m_process_period = period;
+    m_next_process_ns = 0;
+    m_processes = process_tracker{m_processors.size(), thresholds};
+    m_process_unsupported.assign(m_processors.size(), false);
+    m_process_events.clear();
+  }
+
+  /** @brief Capacity of the queue drained by read_process_changes(). */
+  static constexpr size_t max_pending_process_events = 1 << 16;
+
+  /**
+   * @brief Removes and returns the process changes queued since the last
+   * call, oldest first.
+   *
+   * At most max_pending_process_events changes are queued; older ones are
+   * dropped when nobody drains the queue.
+   */
+  std::vector<process_event> read_process_changes() {
+    std::lock_guard lock{m_process_mutex};
+    std::vector<process_event> events(
+        std::make_move_iterator(m_process_events.begin()),
+        std::make_move_iterator(m_process_events.end()));
+    m_process_events.clear();
+    return events;
+  }
+
+  /**
+   * @brief Returns the latest usage of every known process, by processor and
+   * then by PID.
+   */
+  std::vector<process_usage> read_processes() const {
+    std::lock_guard lock{m_process_mutex};
+    return m_processes.snapshot();
+  }
+
+  /** @brief Capacity of the queue drained by read_throttle_events(). */
+  static constexpr size_t max_pending_throttle_events = 1 << 16;
+
+  /**
+   * @brief Removes and returns the throttle intervals that ended since the
+   * last call, oldest first.
+   *
+   * Intervals are tracked per processor and throttle_cause from the throttle
+   * status of the clocks metric group, so their resolution is the clocks
+   * sampling period. At most max_pending_throttle_events are queued; older
+   * ones are dropped when nobody drains the queue.
+   */
+  std::vector<throttle_event> read_throttle_events() {
+    std::lock_guard lock{m_published_mutex};
+    std::vector<throttle_event> events(m_throttle_events.begin(),
+                                       m_throttle_events.end());
+    m_throttle_events.clear();
+    return events;
+  }
+
+  /**
+   * @brief Returns the derived metrics of every processor.
+   *
+   * Values are as of the latest read(), or the latest scheduler round while
+   * the background scheduler runs. They are also exported on the metrics
+   * page; pass the result to sample_exporter::write_round() to export them.
+   */
+  derived_metrics read_derived() {
+    std::lock_guard lock{m_published_mutex};
+    return m_published_derived;
+  }
+
+  /**
+   * @brief Replaces the derived metric definitions.
+   * @note Must be called before start(); current derived values are reset.
+   */
+  void set_derived_metrics(std::vector<derived_metric> definitions) {
+    m_derived = derived_metrics{std::move(definitions), m_processors.size()};
+    m_published_derived = m_derived;
+  }
+
+  /**
+   * @brief Number of processors with published samples.
+   * @note Unlike get_processor_table(), safe to call while the scheduler
+   * runs or rescan() reconciles the table.
+   */
+  size_t published_count() {
+    std::lock_guard lock{m_published_mutex};
+    return m_published.size();
+  }
+
+  /**
+   * @brief Returns the latest published sample of one processor.
+   * @note Unlike read(), safe to call from several threads.
+   */
+  data_sample read_sample(size_t id) {
+    std::lock_guard lock{m_published_mutex};
+    return m_published[id];
+  }
+
+  /**
+   * @brief Returns the latest published metrics of one processor.
+   */
+  smi_metrics read_metrics(size_t id) {
+    std::lock_guard lock{m_published_mutex};
+    return m_published_metrics[id];
+  }
+
+  /**
+   * @brief Returns the usage and size of every memory type (VRAM, visible
+   * VRAM, GTT) of one processor.
+   *
+   * Usage is refreshed with the memory metric group, so it follows the
+   * memory period of the sampling policy while the scheduler runs.
+   */
+  memory_snapshot read_memory(size_t id) {
+    std::lock_guard lock{m_published_mutex};
+    return m_published_memory[id];
+  }
+
+  /**
+   * @brief Returns the fitted mapping from the GPU clock counter of a
+   * processor to host monotonic time.
+   *
+   * Use clock_fit::to_host_ns() to place GPU-side counters, such as
+   * data_sample::timestamp.gpu_clock_counter, on the host timeline.
+   */
+  clock_fit read_clock_fit(size_t id) {
+    std::lock_guard lock{m_published_mutex};
+    return m_published_clocks[id];
+  }
+
+  /**
+   * @brief Awaitable that resumes the caller after the next round is
+   * published, by read() or by the background scheduler.
+   *
+   * @code
+   * auto round = co_await collector.next_round();
+   * @endcode
+   */
+  round_signal::awaiter next_round() { return m_rounds.next_round(); }
+
+  /**
+   * @brief Sets how coroutines waiting on next_round() are resumed.
+   * @param resume Executor receiving each coroutine handle, e.g. one that
+   * posts it to an event loop; when empty, coroutines resume on the thread
+   * that published the round.
+   * @note Must be called before start().
+   */
+  void set_resume_executor(round_signal::executor resume) {
+    m_rounds.set_executor(std::move(resume));
+  }
+
+  /**
+   * @brief Asynchronous stream of the latest samples of one processor.
+   *
+   * Each value is the sample as of the round that resumed the stream. A
+   * consumer that takes longer than a round between next() calls misses
+   * the rounds published meanwhile; it is never sent a backlog.
+   *
+   * @code
+   * auto samples = collector.stream(0);
+   * while (auto sample = co_await samples.next()) { ... }
+   * @endcode
+   */
+  async_generator<smi_metrics> stream(size_t id) {
+    for (;;) {
+      co_await m_rounds.next_round();
+      co_yield read_metrics(id);
+    }
+  }
+
+  /**
+   * @brief Returns node totals and extremes as of the latest round.
+   *
+   * Lock-free and safe to call from any thread, including while the
+   * background scheduler runs.
+   */
+  node_snapshot read_node() const { return m_node.snapshot(); }
+
+  /**
+   * @brief Turns on rendering of the Prometheus page and renders it now, from
+   * the latest samples, so read_exposition() returns a complete page at once.
+   *
+   * Rounds only render the page while it is enabled or served (see
+   * serve_metrics()). Blocks until the scheduler thread has rendered the
+   * page when background sampling runs.
+   */
+  void enable_exposition() {
+    m_exposition_enabled = true;
+    render_now([this] { render_exposition({}); });
+  }
+
+  /**
+   * @brief Prometheus text-format page of the latest rendered round.
+   *
+   * Empty until enable_exposition() or serve_metrics() has been called.
+   * Safe to call from any thread.
+   */
+  std::shared_ptr<const std::string> read_exposition() const {
+    return m_exposition.page();
+  }
+
+  /**
+   * @brief Serves read_exposition() over HTTP at GET /metrics.
+   *
+   * Replaces a previous endpoint. Scrapes only copy the page rendered by
+   * the latest round and never call the driver.
+   * @param address Loopback TCP port or Unix socket path.
+   * @return The running endpoint, e.g. to query its bound port.
+   * @throws std::runtime_error if the address cannot be bound.
+   */
+  const metrics_endpoint &serve_metrics(const endpoint_address &address) {
+    m_endpoint.reset();
+    m_endpoint = std::make_unique<metrics_endpoint>(
+        address, [this] { return m_exposition.page(); });
+    if (!m_serving.exchange(true)) {
+      render_now([this] { render_exposition({}); });
+    }
+    return *m_endpoint;
+  }
+
+  /** @brief Stops the HTTP endpoint, if any. */
+  void stop_serving() {
+    m_serving = false;
+    m_endpoint.reset();
+  }
+
+  /**
+   * @brief Returns the engine that evaluates event rules on every sample.
+   * @note Rules must be added before start().
+   */
+  event_engine &get_event_engine() { return m_events; }
+
+  /**
+   * @brief Returns the flat table of processors sampled by this collector.
+   */
+  const processor_table<driver_t> &get_processor_table() const {
+    return m_processors;
+  }
+
+  ~data_collector() { stop(); }
+
 private:
+  void complete_round(std::span<const group_mask> due) {
+    m_events.evaluate(m_processors, due);
+    m_derived.update(m_processors, due);
+    m_node.update(m_processors, due);
+    render_exposition(due);
+    correlate_clocks(due);
+    m_throttle.update(m_processors, due, m_throttle_round);
+    if (m_capture) {
+      capture_round(due);
+    }
+    if constexpr (process_driver<driver_t>) {
+      if (m_process_period > std::chrono::nanoseconds::zero()) {
+        sample_processes();
+      }
+    }
+    {
+      std::lock_guard lock{m_published_mutex};
+      publish(m_published);
+      m_published_derived = m_derived;
+      for (const auto &event : m_throttle_round) {
+        if (m_throttle_events.size() == max_pending_throttle_events) {
+          m_throttle_events.pop_front();
+        }
+        m_throttle_events.push_back(event);
+      }
+      m_throttle_round.clear();
+      auto samples = m_processors.samples();
+      m_published_metrics.assign(samples.begin(), samples.end());
+      auto memory = m_processors.memory();
+      m_published_memory.assign(memory.begin(), memory.end());
+      auto statuses = m_processors.statuses();
+      m_published_statuses.assign(statuses.begin(), statuses.end());
+      for (size_t id = 0; id < m_clocks.size(); ++id) {
+        m_published_clocks[id] = m_clocks[id].fit();
+      }
+    }
+    m_rounds.publish();
+  }
+
+  /**
+   * @brief Runs @p task on the scheduler thread and waits for it, or runs it
+   * directly while sampling is synchronous.
+   */
+  template <typename task_t> void render_now(task_t &&task) {
+    if (!m_scheduler) {
+      task();
+      return;
+    }
+    std::promise<void> done;
+    auto finished = done.get_future();
+    bool posted = m_scheduler->post_to_thread([&] {
+      try {
+        task();
+        done.set_value();
+      } catch (...) {
+        done.set_exception(std::current_exception());
+      }
+    });
+    if (!posted) {
+      task();
+      return;
+    }
+    finished.get();
+  }
+
+  /**
+   * @brief Renders the page of a round while it is served or enabled; the
+   * first round after a pause renders every line.
+   */
+  void render_exposition(std::span<const group_mask> due) {
+    if (!m_serving && !m_exposition_enabled) {
+      m_exposition_stale = true;
+      return;
+    }
+    m_exposition.update(m_processors,
+                        m_exposition_stale ? std::span<const group_mask>{}
+                                           : due,
+                        m_node.snapshot(), &m_derived);
+    m_exposition_stale = false;
+  }
+
+  enumeration_diff
+  apply_enumeration(std::span<const discovered_processor> discovered) {
+    auto diff = m_processors.reconcile(discovered);
+    auto rows = m_processors.size();
+    m_events.resize(rows);
+    m_derived.resize(rows);
+    m_node.resize(rows);
+    m_clocks.resize(rows);
+    m_exposition.resize(rows);
+    m_throttle.resize(rows);
+
+    for (auto row : diff.retired) {
+      m_node.remove(row);
+      m_exposition.remove(row);
+    }
+    for (const auto *changed : {&diff.added, &diff.retired}) {
+      for (auto row : *changed) {
+        m_events.reset_row(row);
+        m_derived.reset_row(row);
+        m_throttle.reset_row(row);
+        m_clocks[row] = clock_correlator{};
+      }
+    }
+    if (m_reader) {
+      m_reader->resize(rows);
+    }
+    retire_processes(diff);
+    if (m_scheduler) {
+      m_scheduler->add_rows(diff.added);
+    }
+    m_node.publish();
+
+    std::lock_guard lock{m_published_mutex};
+    m_published.resize(rows);
+    m_published_metrics.resize(rows);
+    m_published_memory.resize(rows);
+    m_published_statuses.resize(rows, AMDSMI_STATUS_NO_DATA);
+    m_published_clocks.resize(rows);
+    for (const auto *changed : {&diff.added, &diff.retired}) {
+      for (auto row : *changed) {
+        m_published[row] = data_sample{};
+        m_published_metrics[row] = smi_metrics{};
+        m_published_memory[row] = memory_snapshot{};
+        m_published_statuses[row] = AMDSMI_STATUS_NO_DATA;
+        m_published_clocks[row] = clock_fit{};
+      }
+    }
+    m_published_derived = m_derived;
+    return diff;
+  }
+
+  void correlate_clocks(std::span<const group_mask> due) {
+    auto statuses = m_processors.statuses();
+    auto timestamps = m_processors.timestamps();
+    for (size_t id = 0; id < m_clocks.size(); ++id) {
+      bool read_gpu_metrics =
+          due.empty() || (due[id] & gpu_metrics_groups) != 0;
+      if (read_gpu_metrics && statuses[id] == AMDSMI_STATUS_SUCCESS) {
+        m_clocks[id].add(timestamps[id]);
+      }
+    }
+  }
+
+  void capture_round(std::span<const group_mask> due) {
+    auto statuses = m_processors.statuses();
+    auto capabilities = m_processors.capabilities();
+    auto samples = m_processors.samples();
+    auto timestamps = m_processors.timestamps();
+    auto memory = m_processors.memory();
+    m_capture_records.clear();
+    for (size_t id = 0; id < m_processors.size(); ++id) {
+      if ((due.empty() || due[id] != 0) && capabilities[id] != 0 &&
+          statuses[id] == AMDSMI_STATUS_SUCCESS) {
+        m_capture_records.push_back(to_sample_record(
+            static_cast<uint32_t>(id), samples[id],
+            memory[id].used[AMDSMI_MEM_TYPE_VRAM], timestamps[id]));
+      }
+    }
+    m_capture->append(m_capture_records);
+  }
+
+  void sample_processes() {
+    auto now = host_timestamp_ns();
+    if (now < m_next_process_ns) {
+      return;
+    }
+    m_next_process_ns =
+        now + static_cast<uint64_t>(m_process_period.count());
+
+    auto capabilities = m_processors.capabilities();
+    auto statuses = m_processors.statuses();
+    m_process_round.clear();
+    for (size_t id = 0; id < m_processors.size(); ++id) {
+      if (capabilities[id] == 0 || m_process_unsupported[id] ||
+          statuses[id] == AMDSMI_STATUS_TIMEOUT) {
+        continue;
+      }
+      auto status = m_processors.read_processes(id, m_process_list);
+      if (status == AMDSMI_STATUS_NOT_SUPPORTED) {
+        m_process_unsupported[id] = true;
+        continue;
+      }
+      if (status != AMDSMI_STATUS_SUCCESS) {
+        continue; // keep the known processes until a list is read
+      }
+      std::lock_guard lock{m_process_mutex};
+      m_processes.update(id, m_process_list, now, m_process_round);
+    }
+    std::lock_guard lock{m_process_mutex};
+    queue_process_events();
+  }
+
+  void retire_processes(const enumeration_diff &diff) {
+    std::lock_guard lock{m_process_mutex};
+    m_processes.resize(m_processors.size());
+    m_process_unsupported.resize(m_processors.size(), false);
+    for (auto row : diff.added) {
+      m_process_unsupported[row] = false;
+    }
+    auto now = host_timestamp_ns();
+    for (auto row : diff.retired) {
+      m_processes.reset_row(row, now, m_process_round);
+    }
+    queue_process_events();
+  }
+
+  /** @note Called with m_process_mutex held. */
+  void queue_process_events() {
+    for (auto &event : m_process_round) {
+      if (m_process_events.size() == max_pending_process_events) {
+        m_process_events.pop_front();
+      }
+      m_process_events.push_back(std::move(event));
+    }
+    m_process_round.clear();
+  }
+
+  void publish(std::vector<data_sample> &target) const {
+    auto statuses = m_processors.statuses();
+    auto capabilities = m_processors.capabilities();
+    auto samples = m_processors.samples();
+    auto timestamps = m_processors.timestamps();
+    for (size_t id = 0; id < m_processors.size(); ++id) {
+      if (capabilities[id] == 0) {
+        continue;
+      }
+      if (statuses[id] != AMDSMI_STATUS_SUCCESS) {
+        continue; // reported by read_statuses()
+      }
+      target[id].power = samples[id].current_socket_power;
+      target[id].temperature = samples[id].hotspot_temperature;
+      target[id].usage = samples[id].gfx_activity;
+      target[id].timestamp = timestamps[id];
+    }
+  }
+
   std::vector<data_sample> m_sample; ///< Samples for each processor
   std::unique_ptr<service<driver_factory>>
-      m_smi_service; ///< SMI service instance
-  std::vector<std::shared_ptr<processor<driver_t>>>
-      m_processors; ///< List of processors
+      m_smi_service;                      ///< SMI service instance
+  processor_table<driver_t> m_processors; ///< Table of processors
+  event_engine m_events;                  ///< Rules evaluated per sample
+  derived_metrics m_derived;              ///< Derived values per sample
+  node_aggregate m_node;                  ///< Node totals per round
+  std::vector<clock_correlator> m_clocks; ///< GPU clock fit per processor
+  prometheus_exposition m_exposition;     ///< Page served by m_endpoint
+  std::atomic<bool> m_serving{false};     ///< Whether m_endpoint is set
+  std::atomic<bool> m_exposition_enabled{false}; ///< enable_exposition()
+  bool m_exposition_stale{true}; ///< Lines skipped while not wanted
+  throttle_tracker m_throttle;            ///< Open throttle intervals
+  std::vector<throttle_event> m_throttle_round; ///< Closed this round
+
+  std::mutex m_published_mutex; ///< Guards the results of the latest round
+  std::vector<data_sample> m_published;
+  derived_metrics m_published_derived;
+  std::vector<smi_metrics> m_published_metrics;
+  std::vector<memory_snapshot> m_published_memory;
+  std::vector<amdsmi_status_t> m_published_statuses;
+  std::vector<clock_fit> m_published_clocks;
+  std::deque<throttle_event> m_throttle_events; ///< Undrained intervals
+  round_signal m_rounds; ///< Wakes coroutines awaiting next_round()
+  std::unique_ptr<supervised_reader<driver_t>>
+      m_reader; ///< Deadline-bounded reads, if a call deadline is set
+  std::unique_ptr<sampling_scheduler<driver_t>>
+      m_scheduler; ///< Background sampler, if started
+  std::unique_ptr<capture_writer> m_capture; ///< Disk capture, if recording
+  std::vector<sample_record> m_capture_records; ///< Records of one round
+  std::unique_ptr<metrics_endpoint> m_endpoint; ///< HTTP server, if serving
+
+  mutable std::mutex m_process_mutex; ///< Guards process state and queue
+  std::chrono::nanoseconds m_process_period{0}; ///< Zero while not sampling
+  uint64_t m_next_process_ns{0}; ///< Host time of the next list read
+  process_tracker m_processes;   ///< Known processes per processor
+  std::vector<bool> m_process_unsupported; ///< Rows without process lists
+  std::vector<amdsmi_proc_info_t> m_process_list; ///< Driver list buffer
+  std::vector<process_event> m_process_round;     ///< Changes of one round
+  std::deque<process_event> m_process_events;     ///< Undrained changes
 };
 
 } // namespace amd_smi
@@ -0,0 +1,377 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sample_batch.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Set of metric columns, one bit per metric_column.
+ */
+using column_set = uint32_t;
+
+constexpr column_set column_bit(metric_column column) {
+  return column_set{1} << static_cast<std::size_t>(column);
+}
+
+/**
+ * @brief Capabilities a processor needs to report every column of @p columns.
+ */
+constexpr capability_mask column_capabilities(column_set columns) {
+  capability_mask mask{0};
+  for (std::size_t column = 0; column < metric_column_count; ++column) {
+    if (columns & (column_set{1} << column)) {
+      mask |= column_capability(static_cast<metric_column>(column));
+    }
+  }
+  return mask;
+}
+
+/**
+ * @brief How the values of a derived metric combine into a node value.
+ */
+enum class node_aggregation {
+  sum,  ///< Additive quantities such as power
+  mean, ///< Ratios such as performance per watt
+  max,  ///< Worst case, such as a temperature gradient
+};
+
+/**
+ * @struct derived_metric
+ * @brief Declarative definition of a metric computed from a sample.
+ *
+ * compute is only called when at least one of the columns in inputs changed
+ * since the previous sample of the processor, and only on processors with
+ * every capability in required. Unsupported inputs read as zero, so without
+ * that check a missing sensor would produce a plausible but wrong value.
+ */
+struct derived_metric {
+  std::string name; ///< Letters, digits and '_'; see valid_derived_name()
+  column_set inputs;
+  std::function<double(const smi_metrics &)> compute;
+  node_aggregation aggregation{node_aggregation::sum};
+  /** Capabilities a processor needs; zero requires those of every input. */
+  capability_mask required{0};
+
+  /** @brief Capabilities a processor needs for this metric. */
+  capability_mask requirement() const {
+    return required != 0 ? required : column_capabilities(inputs);
+  }
+};
+
+/**
+ * @brief Whether @p name can be used as is in a Prometheus metric name, a
+ * CSV header and a JSON key: non-empty, letters, digits and '_', not
+ * starting with a digit.
+ */
+inline bool valid_derived_name(std::string_view name) {
+  auto letter = [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  };
+  return !name.empty() && letter(name.front()) &&
+         std::all_of(name.begin(), name.end(), [&](char c) {
+           return letter(c) || (c >= '0' && c <= '9');
+         });
+}
+
+/**
+ * @brief Derived metrics computed by data_collector by default.
+ *
+ * - perf_per_watt: GFX activity (%) per watt of socket power; node mean.
+ * - activity_weighted_power: socket power (W) scaled by GFX activity; node
+ *   sum.
+ * - thermal_headroom: hotspot minus edge temperature (degrees C); node max.
+ */
+inline std::vector<derived_metric> standard_derived_metrics() {
+  return {
+      {"perf_per_watt",
+       column_bit(metric_column::gfx_activity) |
+           column_bit(metric_column::current_socket_power),
+       [](const smi_metrics &sample) {
+         return sample.current_socket_power == 0
+                    ? 0.0
+                    : static_cast<double>(sample.gfx_activity) /
+                          sample.current_socket_power;
+       },
+       node_aggregation::mean,
+       capability::gfx_activity | capability::current_socket_power},
+      {"activity_weighted_power",
+       column_bit(metric_column::gfx_activity) |
+           column_bit(metric_column::current_socket_power),
+       [](const smi_metrics &sample) {
+         return static_cast<double>(sample.current_socket_power) *
+                sample.gfx_activity / 100.0;
+       },
+       node_aggregation::sum,
+       capability::gfx_activity | capability::current_socket_power},
+      {"thermal_headroom",
+       column_bit(metric_column::hotspot_temperature) |
+           column_bit(metric_column::edge_temperature),
+       [](const smi_metrics &sample) {
+         return static_cast<double>(sample.hotspot_temperature) -
+                sample.edge_temperature;
+       },
+       node_aggregation::max,
+       capability::hotspot_temperature | capability::edge_temperature},
+  };
+}
+
+/**
+ * @class derived_metrics
+ * @brief Incrementally maintained derived values of every processor.
+ *
+ * For each new sample the set of changed columns is found with one pass over
+ * the scalar columns, and only definitions whose inputs intersect it are
+ * recomputed. Node values are aggregated from the per-processor values on
+ * request, following each definition's node_aggregation, so no running
+ * total accumulates rounding error. A processor lacking a capability a
+ * definition requires has no value for it: supported() is false, value() is
+ * NaN and node values leave the processor out. Copies share the
+ * definitions, so a snapshot only copies the values.
+ */
+class derived_metrics {
+public:
+  /**
+   * @brief Constructs the stage for @p rows processors.
+   * @param definitions The derived metrics to compute.
+   * @param rows Number of processors.
+   * @throws std::invalid_argument if a name is not a valid_derived_name().
+   */
+  derived_metrics(std::vector<derived_metric> definitions, std::size_t rows)
+      : m_definitions{std::make_shared<const std::vector<derived_metric>>(
+            std::move(definitions))},
+        m_rows{rows}, m_inputs(rows, smi_metrics{}), m_seen(rows, 0),
+        m_capabilities(rows, capability::all),
+        m_values(rows * m_definitions->size(), 0.0) {
+    for (const auto &current : *m_definitions) {
+      if (!valid_derived_name(current.name)) {
+        throw std::invalid_argument("Invalid derived metric name: " +
+                                    current.name);
+      }
+    }
+  }
+
+  /** @brief Number of derived metrics. */
+  std::size_t size() const { return m_definitions->size(); }
+
+  /** @brief Number of processors. */
+  std::size_t rows() const { return m_rows; }
+
+  /** @brief Definition of a derived metric. */
+  const derived_metric &definition(std::size_t metric) const {
+    return (*m_definitions)[metric];
+  }
+
+  /**
+   * @brief Whether a processor has every capability a derived metric
+   * requires.
+   */
+  bool supported(std::size_t row, std::size_t metric) const {
+    auto required = definition(metric).requirement();
+    return (m_capabilities[row] & required) == required;
+  }
+
+  /**
+   * @brief Latest value of a derived metric of a processor; NaN when the
+   * processor does not support it.
+   */
+  double value(std::size_t row, std::size_t metric) const {
+    return m_values[row * size() + metric];
+  }
+
+  /** @brief Latest values of every derived metric of a processor. */
+  std::span<const double> values(std::size_t row) const {
+    return {m_values.data() + row * size(), size()};
+  }
+
+  /**
+   * @brief Whether any processor with samples supports a derived metric,
+   * i.e. whether node_value() aggregates anything.
+   */
+  bool node_supported(std::size_t metric) const {
+    for (std::size_t row = 0; row < m_rows; ++row) {
+      if (m_seen[row] && supported(row, metric)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Node value of a derived metric: the sum, mean or maximum of the
+   * processors with samples that support it, as set by its
+   * node_aggregation.
+   */
+  double node_value(std::size_t metric) const {
+    double result{0.0};
+    std::size_t count{0};
+    for (std::size_t row = 0; row < m_rows; ++row) {
+      if (!m_seen[row] || !supported(row, metric)) {
+        continue;
+      }
+      double current = value(row, metric);
+      if (definition(metric).aggregation == node_aggregation::max) {
+        result = count == 0 ? current : std::max(result, current);
+      } else {
+        result += current;
+      }
+      ++count;
+    }
+    if (definition(metric).aggregation == node_aggregation::mean &&
+        count != 0) {
+      result /= static_cast<double>(count);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Grows the stage to @p rows processors.
+   */
+  void resize(std::size_t rows) {
+    if (rows <= m_rows) {
+      return;
+    }
+    m_inputs.resize(rows, smi_metrics{});
+    m_seen.resize(rows, 0);
+    m_capabilities.resize(rows, capability::all);
+    m_values.resize(rows * size(), 0.0);
+    m_rows = rows;
+  }
+
+  /**
+   * @brief Drops the values of a row, removing it from the node values.
+   */
+  void reset_row(std::size_t row) {
+    std::fill_n(m_values.begin() + static_cast<std::ptrdiff_t>(row * size()),
+                size(), 0.0);
+    m_seen[row] = 0;
+    m_capabilities[row] = capability::all;
+  }
+
+  /** @brief Number of compute calls made so far. */
+  uint64_t evaluations() const { return m_evaluations; }
+
+  /**
+   * @brief Feeds a new sample of a processor.
+   * @param capabilities Metrics the processor supports, e.g. from
+   * processor_table::capabilities(); all of them by default.
+   * @return Number of derived metrics recomputed.
+   */
+  std::size_t update(std::size_t row, const smi_metrics &sample,
+                     capability_mask capabilities = capability::all) {
+    column_set changed{~column_set{0}};
+    if (m_seen[row] && m_capabilities[row] == capabilities) {
+      changed = 0;
+      for (std::size_t column = 0; column < metric_column_count; ++column) {
+        auto metric = static_cast<metric_column>(column);
+        if (metric_value(sample, metric) !=
+            metric_value(m_inputs[row], metric)) {
+          changed |= column_bit(metric);
+        }
+      }
+    }
+    m_inputs[row] = sample;
+    m_seen[row] = 1;
+    m_capabilities[row] = capabilities;
+    if (changed == 0) {
+      return 0;
+    }
+
+    std::size_t recomputed{0};
+    for (std::size_t metric = 0; metric < size(); ++metric) {
+      const auto &current = definition(metric);
+      if ((current.inputs & changed) == 0) {
+        continue;
+      }
+      if (!supported(row, metric)) {
+        m_values[row * size() + metric] =
+            std::numeric_limits<double>::quiet_NaN();
+        continue;
+      }
+      m_values[row * size() + metric] = current.compute(sample);
+      ++recomputed;
+    }
+    m_evaluations += recomputed;
+    return recomputed;
+  }
+
+  /**
+   * @brief Feeds every row of a table that was read successfully.
+   * @param table The sampled table.
+   * @param refreshed Groups refreshed per row; all rows when empty.
+   * @return Number of derived metrics recomputed.
+   */
+  template <typename driver>
+  std::size_t update(const processor_table<driver> &table,
+                     std::span<const group_mask> refreshed = {}) {
+    auto statuses = table.statuses();
+    auto capabilities = table.capabilities();
+    auto samples = table.samples();
+    std::size_t recomputed{0};
+    for (std::size_t row = 0; row < std::min(table.size(), m_rows); ++row) {
+      bool read = refreshed.empty() || refreshed[row] != 0;
+      if (read && statuses[row] == AMDSMI_STATUS_SUCCESS) {
+        recomputed += update(row, samples[row], capabilities[row]);
+      }
+    }
+    return recomputed;
+  }
+
+private:
+  std::shared_ptr<const std::vector<derived_metric>> m_definitions;
+  std::size_t m_rows;
+  /** Sample the values were computed on */
+  std::vector<smi_metrics> m_inputs;
+  std::vector<uint8_t> m_seen;                 ///< Whether m_inputs is valid
+  std::vector<capability_mask> m_capabilities; ///< Of the latest sample
+  std::vector<double> m_values;                ///< [row * size() + metric]
+  uint64_t m_evaluations{0};
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,199 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <amd_smi/amdsmi.h>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Driver calls needed to initialize the library and enumerate
+ * processors.
+ */
+template <typename driver_t>
+concept enumeration_driver =
+    requires(driver_t &api, amdsmi_version_t *version, uint32_t *count,
+             amdsmi_socket_handle socket_handle,
+             amdsmi_socket_handle *socket_handles,
+             amdsmi_processor_handle processor_handle,
+             amdsmi_processor_handle *processor_handles,
+             processor_type_t *processor_type) {
+      { api.init() } -> std::same_as<amdsmi_status_t>;
+      { api.get_version(version) } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_socket_handles(count, socket_handles)
+      } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_processor_handles(socket_handle, count, processor_handles)
+      } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_processor_type(processor_handle, processor_type)
+      } -> std::same_as<amdsmi_status_t>;
+    };
+
+/**
+ * @brief Driver calls needed to probe and sample the metrics of a processor.
+ */
+template <typename driver_t>
+concept metrics_driver =
+    requires(driver_t &api, amdsmi_processor_handle processor_handle,
+             amdsmi_power_info_t *power_info,
+             amdsmi_engine_usage_t *engine_usage,
+             amdsmi_memory_type_t memory_type, uint64_t *memory,
+             amdsmi_temperature_type_t sensor_type,
+             amdsmi_temperature_metric_t temperature_metric,
+             int64_t *temperature, amdsmi_gpu_metrics_t *gpu_metrics) {
+      {
+        api.get_power_info(processor_handle, power_info)
+      } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_gpu_activity(processor_handle, engine_usage)
+      } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_memory_usage(processor_handle, memory_type, memory)
+      } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_temperature_metric(processor_handle, sensor_type,
+                                   temperature_metric, temperature)
+      } -> std::same_as<amdsmi_status_t>;
+      {
+        api.get_gpu_metrics_info(processor_handle, gpu_metrics)
+      } -> std::same_as<amdsmi_status_t>;
+    };
+
+/**
+ * @brief Optional driver call reporting the size of each memory type.
+ */
+template <typename driver_t>
+concept memory_total_driver =
+    requires(driver_t &api, amdsmi_processor_handle processor_handle,
+             amdsmi_memory_type_t memory_type, uint64_t *memory) {
+      {
+        api.get_memory_total(processor_handle, memory_type, memory)
+      } -> std::same_as<amdsmi_status_t>;
+    };
+
+/**
+ * @brief Optional driver call giving a processor a stable identity (its PCI
+ * address) that survives GPU resets and handle changes.
+ */
+template <typename driver_t>
+concept identity_driver =
+    requires(driver_t &api, amdsmi_processor_handle processor_handle,
+             amdsmi_bdf_t *bdf) {
+      {
+        api.get_device_bdf(processor_handle, bdf)
+      } -> std::same_as<amdsmi_status_t>;
+    };
+
+/**
+ * @brief Optional driver call listing the processes that use a processor.
+ */
+template <typename driver_t>
+concept process_driver =
+    requires(driver_t &api, amdsmi_processor_handle processor_handle,
+             uint32_t *max_processes, amdsmi_proc_info_t *processes) {
+      {
+        api.get_process_list(processor_handle, max_processes, processes)
+      } -> std::same_as<amdsmi_status_t>;
+    };
+
+/**
+ * @brief Complete driver interface used by service and processor.
+ */
+template <typename driver_t>
+concept smi_driver = enumeration_driver<driver_t> && metrics_driver<driver_t>;
+
+/**
+ * @brief A driver without state, whose calls can be bound at compile time.
+ *
+ * Stateless drivers are never heap allocated or reference counted; every
+ * driver_binding to them is an empty object.
+ */
+template <typename driver_t>
+concept stateless_driver =
+    std::is_empty_v<driver_t> &&
+    std::is_trivially_default_constructible_v<driver_t>;
+
+/**
+ * @brief A factory that names its driver type and knows how to create it.
+ *
+ * create_driver() returns either a driver by value (stateless drivers) or a
+ * shared pointer to one (stateful drivers such as test mocks).
+ */
+template <typename factory_t>
+concept smi_driver_factory = requires {
+  typename factory_t::driver_t;
+  factory_t::create_driver();
+};
+
+/**
+ * @class driver_binding
+ * @tparam driver_t The driver interface type.
+ * @brief Handle through which service and processors reach the driver.
+ *
+ * For stateful drivers the binding shares ownership of the driver instance.
+ * For stateless drivers it is empty and calls resolve at compile time.
+ */
+template <typename driver_t, bool = stateless_driver<driver_t>>
+class driver_binding {
+public:
+  template <typename other_t>
+    requires std::convertible_to<other_t *, driver_t *>
+  driver_binding(std::shared_ptr<other_t> driver_api)
+      : m_driver_api{std::move(driver_api)} {}
+
+  driver_t *operator->() const { return m_driver_api.get(); }
+  driver_t &operator*() const { return *m_driver_api; }
+
+private:
+  std::shared_ptr<driver_t> m_driver_api;
+};
+
+template <typename driver_t> class driver_binding<driver_t, true> {
+public:
+  driver_binding() = default;
+  driver_binding(driver_t) {}
+  driver_binding(const std::shared_ptr<driver_t> &) {}
+
+  driver_t *operator->() const { return &m_driver_api; }
+  driver_t &operator*() const { return m_driver_api; }
+
+private:
+  [[no_unique_address]] mutable driver_t m_driver_api;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,351 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/common.hpp"
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sample_batch.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Condition checked by an event_rule.
+ */
+enum class rule_condition : uint8_t {
+  above,     ///< Value greater than the threshold
+  below,     ///< Value less than the threshold
+  rate_above ///< Change per second since the previous sample greater than
+             ///< the threshold
+};
+
+/**
+ * @brief Direction of a rule transition.
+ */
+enum class event_edge : uint8_t {
+  raised, ///< The condition became true
+  cleared ///< The condition stopped being true, past the hysteresis band
+};
+
+/**
+ * @struct event_rule
+ * @brief Threshold rule evaluated on every sample of every processor.
+ *
+ * A raised rule only clears once the value is back past the threshold by
+ * more than the hysteresis, so a value hovering around the limit does not
+ * produce a stream of events.
+ */
+struct event_rule {
+  metric_column metric;
+  rule_condition condition;
+  uint32_t threshold;
+  uint32_t hysteresis{0};
+};
+
+/**
+ * @struct smi_event
+ * @brief A rule transition observed on one processor.
+ */
+struct smi_event {
+  std::size_t rule; ///< Identifier returned by event_engine::add_rule()
+  std::size_t row;  ///< Processor table row
+  event_edge edge;  ///< Raised or cleared
+  uint32_t value;   ///< Metric value (or change per second, for rate rules)
+};
+
+/**
+ * @class event_engine
+ * @brief Evaluates threshold, rate-of-change and hysteresis rules inline with
+ * sampling.
+ *
+ * Rules are evaluated on the sampling thread right after a processor is read,
+ * so a crossing is reported within the sample period that observed it. A
+ * rule is skipped on processors that do not support its metric, whose value
+ * reads as zero. Rate rules divide the change by the host time between the
+ * two samples, so their threshold does not depend on the sampling rate.
+ * Each
+ * transition is delivered to the rule's callback (on the sampling thread) and
+ * queued for other threads, which can block on notification_fd() with
+ * poll()/epoll and then collect the queue with take_events().
+ *
+ * Per rule and sample the cost is one field load, one comparison and one
+ * state byte; the queue lock is only taken when a transition happens.
+ * At most max_queued_events are queued; the oldest are dropped (and counted
+ * in dropped_events()) when nobody calls take_events().
+ * Rules must be registered before sampling starts.
+ */
+class event_engine {
+public:
+  using callback = std::function<void(const smi_event &)>;
+
+  /** @brief Capacity of the queue drained by take_events(). */
+  static constexpr std::size_t max_queued_events = 1 << 16;
+
+  /**
+   * @brief Constructs an engine for @p rows processors.
+   * @throws std::runtime_error if the eventfd cannot be created.
+   */
+  explicit event_engine(std::size_t rows)
+      : m_rows{rows}, m_event_fd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+    if (m_event_fd < 0) {
+      detail::throw_errno("Failed to create eventfd");
+    }
+  }
+
+  event_engine(const event_engine &) = delete;
+  event_engine &operator=(const event_engine &) = delete;
+
+  ~event_engine() { close(m_event_fd); }
+
+  /**
+   * @brief Registers a rule.
+   * @param rule The rule.
+   * @param on_event Optional callback run on the sampling thread.
+   * @return Identifier of the rule, reported in smi_event::rule.
+   */
+  std::size_t add_rule(const event_rule &rule, callback on_event = {}) {
+    m_rules.push_back(rule);
+    m_callbacks.push_back(std::move(on_event));
+    m_active.resize(m_rules.size() * m_rows, 0);
+    m_previous.resize(m_rules.size() * m_rows, 0);
+    m_previous_ns.resize(m_rules.size() * m_rows, 0);
+    m_has_previous.resize(m_rules.size() * m_rows, 0);
+    return m_rules.size() - 1;
+  }
+
+  /**
+   * @brief Grows the engine to @p rows processors, keeping rule state.
+   */
+  void resize(std::size_t rows) {
+    if (rows <= m_rows) {
+      return;
+    }
+    auto widen = [&](auto &state) {
+      std::remove_reference_t<decltype(state)> widened(m_rules.size() * rows,
+                                                       0);
+      for (std::size_t rule = 0; rule < m_rules.size(); ++rule) {
+        std::copy_n(state.begin() + rule * m_rows, m_rows,
+                    widened.begin() + rule * rows);
+      }
+      state = std::move(widened);
+    };
+    widen(m_active);
+    widen(m_previous);
+    widen(m_previous_ns);
+    widen(m_has_previous);
+    m_rows = rows;
+  }
+
+  /**
+   * @brief Forgets the rule state of a row, e.g. for a replaced processor.
+   */
+  void reset_row(std::size_t row) {
+    for (std::size_t rule = 0; rule < m_rules.size(); ++rule) {
+      m_active[rule * m_rows + row] = 0;
+      m_has_previous[rule * m_rows + row] = 0;
+    }
+  }
+
+  /** @brief Number of registered rules. */
+  std::size_t rule_count() const { return m_rules.size(); }
+
+  /**
+   * @brief Whether a rule is currently raised for a row.
+   */
+  bool active(std::size_t rule, std::size_t row) const {
+    return m_active[rule * m_rows + row] != 0;
+  }
+
+  /**
+   * @brief Evaluates every rule on a new sample of a row.
+   * @param row Processor table row.
+   * @param sample The sample.
+   * @param time When the sample was taken; rate rules use its host time.
+   * @param refreshed Groups refreshed by the sample; rules on other metrics
+   * are skipped so stale values are not evaluated twice.
+   * @param capabilities Metrics the processor supports; rules on other
+   * metrics are skipped.
+   * @return Number of transitions.
+   */
+  std::size_t evaluate(std::size_t row, const smi_metrics &sample,
+                       const sample_timestamp &time,
+                       group_mask refreshed = all_metric_groups,
+                       capability_mask capabilities = capability::all) {
+    std::size_t transitions{0};
+    for (std::size_t rule = 0; rule < m_rules.size(); ++rule) {
+      const auto &current = m_rules[rule];
+      if ((refreshed & group_bit(column_group(current.metric))) == 0 ||
+          (capabilities & column_capability(current.metric)) == 0) {
+        continue;
+      }
+      std::size_t slot = rule * m_rows + row;
+      uint32_t value = metric_value(sample, current.metric);
+      uint32_t observed = value;
+
+      if (current.condition == rule_condition::rate_above) {
+        uint64_t now = time.host_ns();
+        uint64_t previous = m_previous[slot];
+        uint64_t elapsed = now - m_previous_ns[slot];
+        bool first = !m_has_previous[slot] || now <= m_previous_ns[slot];
+        m_previous[slot] = value;
+        m_previous_ns[slot] = now;
+        m_has_previous[slot] = 1;
+        if (first) {
+          continue;
+        }
+        uint64_t change =
+            value > previous ? value - previous : previous - value;
+        observed = static_cast<uint32_t>(
+            std::min<uint64_t>(change * 1'000'000'000 / elapsed,
+                               std::numeric_limits<uint32_t>::max()));
+      }
+
+      // Widened so threshold +/- hysteresis cannot wrap around.
+      uint64_t level{observed};
+      uint64_t threshold{current.threshold};
+      bool raise = current.condition == rule_condition::below
+                       ? level < threshold
+                       : level > threshold;
+      bool clear = current.condition == rule_condition::below
+                       ? level > threshold + current.hysteresis
+                       : level + current.hysteresis < threshold;
+
+      if (!m_active[slot] && raise) {
+        m_active[slot] = 1;
+        notify({rule, row, event_edge::raised, observed});
+        ++transitions;
+      } else if (m_active[slot] && clear) {
+        m_active[slot] = 0;
+        notify({rule, row, event_edge::cleared, observed});
+        ++transitions;
+      }
+    }
+    return transitions;
+  }
+
+  /**
+   * @brief Evaluates every row of a table that was read successfully.
+   * @param table The sampled table.
+   * @param refreshed Groups refreshed per row; all groups when empty.
+   * @return Number of transitions.
+   */
+  template <typename driver>
+  std::size_t evaluate(const processor_table<driver> &table,
+                       std::span<const group_mask> refreshed = {}) {
+    auto statuses = table.statuses();
+    auto capabilities = table.capabilities();
+    auto samples = table.samples();
+    auto timestamps = table.timestamps();
+    std::size_t transitions{0};
+    for (std::size_t row = 0; row < std::min(table.size(), m_rows); ++row) {
+      group_mask groups =
+          refreshed.empty() ? all_metric_groups : refreshed[row];
+      if (groups != 0 && statuses[row] == AMDSMI_STATUS_SUCCESS) {
+        transitions += evaluate(row, samples[row], timestamps[row], groups,
+                                capabilities[row]);
+      }
+    }
+    return transitions;
+  }
+
+  /**
+   * @brief File descriptor that becomes readable when events are queued.
+   */
+  int notification_fd() const { return m_event_fd; }
+
+  /**
+   * @brief Removes and returns all queued events; resets the notification.
+   */
+  std::vector<smi_event> take_events() {
+    uint64_t counter{0};
+    std::lock_guard lock{m_queue_mutex};
+    [[maybe_unused]] auto result = read(m_event_fd, &counter, sizeof(counter));
+    std::vector<smi_event> events(m_queue.begin(), m_queue.end());
+    m_queue.clear();
+    return events;
+  }
+
+  /**
+   * @brief Events dropped from the queue because it was full.
+   */
+  uint64_t dropped_events() const {
+    std::lock_guard lock{m_queue_mutex};
+    return m_dropped_events;
+  }
+
+private:
+  void notify(const smi_event &event) {
+    if (m_callbacks[event.rule]) {
+      m_callbacks[event.rule](event);
+    }
+    std::lock_guard lock{m_queue_mutex};
+    if (m_queue.size() == max_queued_events) {
+      m_queue.pop_front();
+      ++m_dropped_events;
+    }
+    m_queue.push_back(event);
+    uint64_t increment{1};
+    [[maybe_unused]] auto result =
+        write(m_event_fd, &increment, sizeof(increment));
+  }
+
+  std::size_t m_rows;
+  int m_event_fd;
+  std::vector<event_rule> m_rules;
+  std::vector<callback> m_callbacks;
+  std::vector<uint8_t> m_active;       ///< [rule * rows + row]
+  std::vector<uint32_t> m_previous;    ///< Last value, for rate rules
+  std::vector<uint64_t> m_previous_ns; ///< Host time of m_previous
+  std::vector<uint8_t> m_has_previous; ///< Whether m_previous is valid
+  mutable std::mutex m_queue_mutex;
+  std::deque<smi_event> m_queue; ///< Oldest first
+  uint64_t m_dropped_events{0};
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
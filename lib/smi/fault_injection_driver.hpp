@@ -0,0 +1,445 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/driver.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Driver calls a fault_rule can target.
+ */
+enum class driver_call : uint8_t {
+  init,
+  get_version,
+  get_socket_handles,
+  get_processor_handles,
+  get_processor_type,
+  get_power_info,
+  get_gpu_activity,
+  get_memory_usage,
+  get_memory_total,
+  get_temperature_metric,
+  get_gpu_metrics_info,
+  get_device_bdf,
+  get_process_list,
+  count
+};
+
+/**
+ * @brief Bitmask of driver calls, one bit per driver_call.
+ */
+using call_mask = uint32_t;
+
+constexpr call_mask call_bit(driver_call call) {
+  return call_mask{1} << static_cast<uint8_t>(call);
+}
+
+/** @brief Calls made while sampling, as opposed to enumeration. */
+constexpr call_mask sampling_calls =
+    call_bit(driver_call::get_power_info) |
+    call_bit(driver_call::get_gpu_activity) |
+    call_bit(driver_call::get_memory_usage) |
+    call_bit(driver_call::get_memory_total) |
+    call_bit(driver_call::get_temperature_metric) |
+    call_bit(driver_call::get_gpu_metrics_info) |
+    call_bit(driver_call::get_process_list);
+
+constexpr call_mask all_driver_calls =
+    (call_mask{1} << static_cast<uint8_t>(driver_call::count)) - 1;
+
+/**
+ * @brief Misbehavior injected by a fault_rule.
+ */
+enum class fault_kind : uint8_t {
+  error,     ///< Fail the call with fault_rule::status, skipping the driver
+  latency,   ///< Delay the call by fault_rule::duration
+  hang,      ///< Block until released, or for fault_rule::duration
+  corruption ///< Overwrite bytes of a successful amdsmi_gpu_metrics_t read
+};
+
+/**
+ * @struct fault_rule
+ * @brief When and how a fault_injection_driver misbehaves.
+ *
+ * A rule counts the calls it targets. After the first @p skip of them it
+ * fires on every @p every-th call (schedule) and, independently, with
+ * @p probability on each call, until it has fired @p limit times.
+ */
+struct fault_rule {
+  fault_kind kind{fault_kind::error};
+  call_mask calls{sampling_calls}; ///< Targeted calls
+  double probability{0.0};         ///< Chance of firing per targeted call
+  uint64_t every{0};               ///< Fire on every N-th call; 0 disables
+  uint64_t skip{0};                ///< Targeted calls before the rule arms
+  uint64_t limit{0};               ///< Maximum firings; 0 is unlimited
+  amdsmi_status_t status{AMDSMI_STATUS_BUSY}; ///< Returned by error faults
+  /** Delay of latency faults; bound of hang faults (zero: until released). */
+  std::chrono::nanoseconds duration{std::chrono::milliseconds{10}};
+  uint32_t corrupt_bytes{16}; ///< Bytes overwritten by corruption faults
+};
+
+/**
+ * @struct fault_config
+ * @brief Rules of a fault_injection_driver and the seed of its random draws.
+ */
+struct fault_config {
+  std::vector<fault_rule> rules;
+  uint64_t seed{1}; ///< Same seed and call sequence, same faults
+};
+
+/**
+ * @struct fault_stats
+ * @brief Calls seen and faults injected by a fault_injection_driver.
+ */
+struct fault_stats {
+  uint64_t calls{0};       ///< Calls through the driver
+  uint64_t errors{0};      ///< Calls failed without reaching the driver
+  uint64_t delays{0};      ///< Calls delayed
+  uint64_t hangs{0};       ///< Calls blocked
+  uint64_t corruptions{0}; ///< GPU metrics reads corrupted
+};
+
+/**
+ * @class fault_injection_driver
+ * @tparam driver_t The wrapped driver interface type.
+ * @brief Driver that forwards to another driver while injecting errors,
+ * latency spikes, hangs and corrupted GPU metrics.
+ *
+ * Wraps any driver, stateless (amd_smi_driver) or stateful (a mock or a
+ * simulated driver), and provides exactly the optional calls the wrapped
+ * driver provides. Rules are evaluated in order on every call; all rules
+ * that fire apply, with an error fault replacing the driver call. Random
+ * draws come from one seeded generator, so a single-threaded call sequence
+ * faults reproducibly.
+ *
+ * The wrapper is stateful and is shared like a mock (see
+ * fault_injection_factory). Calls may come from several threads, e.g.
+ * supervised_reader workers. Hung calls return once release_hangs() is
+ * called. A supervised_reader destroyed during an unbounded hang detaches
+ * the hung worker, which keeps the wrapper alive until it is released.
+ */
+template <typename driver_t> class fault_injection_driver {
+public:
+  /**
+   * @brief Wraps @p inner.
+   * @param inner Binding to the wrapped driver.
+   * @param config Fault rules and random seed.
+   */
+  explicit fault_injection_driver(driver_binding<driver_t> inner,
+                                  fault_config config = {})
+      : m_inner{std::move(inner)}, m_rules{std::move(config.rules)},
+        m_matched(m_rules.size(), 0), m_fired(m_rules.size(), 0),
+        m_random{config.seed} {}
+
+  fault_injection_driver(const fault_injection_driver &) = delete;
+  fault_injection_driver &operator=(const fault_injection_driver &) = delete;
+
+  ~fault_injection_driver() { release_hangs(); }
+
+  /**
+   * @brief Returns blocked calls and makes later hang faults return at once.
+   */
+  void release_hangs() {
+    std::lock_guard lock{m_mutex};
+    m_released = true;
+    m_release.notify_all();
+  }
+
+  /** @brief Counters of calls and injected faults. */
+  fault_stats stats() const {
+    std::lock_guard lock{m_mutex};
+    return m_stats;
+  }
+
+  amdsmi_status_t init()
+    requires requires(driver_t &api) { api.init(); }
+  {
+    return inject(driver_call::init, [&] { return m_inner->init(); });
+  }
+
+  amdsmi_status_t init(uint64_t init_flags)
+    requires requires(driver_t &api, uint64_t flags) { api.init(flags); }
+  {
+    return inject(driver_call::init,
+                  [&] { return m_inner->init(init_flags); });
+  }
+
+  amdsmi_status_t get_version(amdsmi_version_t *version) {
+    return inject(driver_call::get_version,
+                  [&] { return m_inner->get_version(version); });
+  }
+
+  amdsmi_status_t get_socket_handles(uint32_t *socket_count,
+                                     amdsmi_socket_handle *socket_handles) {
+    return inject(driver_call::get_socket_handles, [&] {
+      return m_inner->get_socket_handles(socket_count, socket_handles);
+    });
+  }
+
+  amdsmi_status_t
+  get_processor_handles(amdsmi_socket_handle socket_handle,
+                        uint32_t *processor_count,
+                        amdsmi_processor_handle *processor_handles) {
+    return inject(driver_call::get_processor_handles, [&] {
+      return m_inner->get_processor_handles(socket_handle, processor_count,
+                                            processor_handles);
+    });
+  }
+
+  amdsmi_status_t get_processor_type(amdsmi_processor_handle processor_handle,
+                                     processor_type_t *processor_type) {
+    return inject(driver_call::get_processor_type, [&] {
+      return m_inner->get_processor_type(processor_handle, processor_type);
+    });
+  }
+
+  amdsmi_status_t get_power_info(amdsmi_processor_handle processor_handle,
+                                 amdsmi_power_info_t *info) {
+    return inject(driver_call::get_power_info, [&] {
+      return m_inner->get_power_info(processor_handle, info);
+    });
+  }
+
+  amdsmi_status_t get_gpu_activity(amdsmi_processor_handle processor_handle,
+                                   amdsmi_engine_usage_t *info) {
+    return inject(driver_call::get_gpu_activity, [&] {
+      return m_inner->get_gpu_activity(processor_handle, info);
+    });
+  }
+
+  amdsmi_status_t get_memory_usage(amdsmi_processor_handle processor_handle,
+                                   amdsmi_memory_type_t type,
+                                   uint64_t *used) {
+    return inject(driver_call::get_memory_usage, [&] {
+      return m_inner->get_memory_usage(processor_handle, type, used);
+    });
+  }
+
+  amdsmi_status_t get_memory_total(amdsmi_processor_handle processor_handle,
+                                   amdsmi_memory_type_t type, uint64_t *total)
+    requires memory_total_driver<driver_t>
+  {
+    return inject(driver_call::get_memory_total, [&] {
+      return m_inner->get_memory_total(processor_handle, type, total);
+    });
+  }
+
+  amdsmi_status_t
+  get_temperature_metric(amdsmi_processor_handle processor_handle,
+                         amdsmi_temperature_type_t sensor_type,
+                         amdsmi_temperature_metric_t metric,
+                         int64_t *temperature) {
+    return inject(driver_call::get_temperature_metric, [&] {
+      return m_inner->get_temperature_metric(processor_handle, sensor_type,
+                                             metric, temperature);
+    });
+  }
+
+  amdsmi_status_t
+  get_gpu_metrics_info(amdsmi_processor_handle processor_handle,
+                       amdsmi_gpu_metrics_t *metrics) {
+    return inject(
+        driver_call::get_gpu_metrics_info,
+        [&] {
+          return m_inner->get_gpu_metrics_info(processor_handle, metrics);
+        },
+        metrics);
+  }
+
+  amdsmi_status_t get_device_bdf(amdsmi_processor_handle processor_handle,
+                                 amdsmi_bdf_t *bdf)
+    requires identity_driver<driver_t>
+  {
+    return inject(driver_call::get_device_bdf, [&] {
+      return m_inner->get_device_bdf(processor_handle, bdf);
+    });
+  }
+
+  amdsmi_status_t get_process_list(amdsmi_processor_handle processor_handle,
+                                   uint32_t *max_processes,
+                                   amdsmi_proc_info_t *processes)
+    requires process_driver<driver_t>
+  {
+    return inject(driver_call::get_process_list, [&] {
+      return m_inner->get_process_list(processor_handle, max_processes,
+                                       processes);
+    });
+  }
+
+private:
+  /** @brief Faults chosen for one call. */
+  struct plan {
+    bool fail{false};
+    amdsmi_status_t status{AMDSMI_STATUS_SUCCESS};
+    std::chrono::nanoseconds delay{0};
+    bool hang{false};
+    std::chrono::nanoseconds hang_bound{0};
+    uint32_t corrupt_bytes{0};
+    uint64_t corrupt_seed{0};
+  };
+
+  template <typename call_t>
+  amdsmi_status_t inject(driver_call call, call_t &&forward,
+                         amdsmi_gpu_metrics_t *metrics = nullptr) {
+    auto chosen = choose(call, metrics != nullptr);
+    if (chosen.delay > std::chrono::nanoseconds::zero()) {
+      std::this_thread::sleep_for(chosen.delay);
+    }
+    if (chosen.hang) {
+      std::unique_lock lock{m_mutex};
+      auto released = [this] { return m_released; };
+      if (chosen.hang_bound > std::chrono::nanoseconds::zero()) {
+        m_release.wait_for(lock, chosen.hang_bound, released);
+      } else {
+        m_release.wait(lock, released);
+      }
+    }
+    if (chosen.fail) {
+      return chosen.status;
+    }
+    auto status = forward();
+    if (status == AMDSMI_STATUS_SUCCESS && chosen.corrupt_bytes != 0) {
+      corrupt(*metrics, chosen.corrupt_bytes, chosen.corrupt_seed);
+      std::lock_guard lock{m_mutex};
+      ++m_stats.corruptions;
+    }
+    return status;
+  }
+
+  plan choose(driver_call call, bool corruptible) {
+    plan chosen;
+    std::lock_guard lock{m_mutex};
+    ++m_stats.calls;
+    for (std::size_t index = 0; index < m_rules.size(); ++index) {
+      const auto &rule = m_rules[index];
+      if ((rule.calls & call_bit(call)) == 0 ||
+          (rule.kind == fault_kind::corruption && !corruptible)) {
+        continue;
+      }
+      auto matched = ++m_matched[index];
+      if (matched <= rule.skip ||
+          (rule.limit != 0 && m_fired[index] >= rule.limit)) {
+        continue;
+      }
+      bool scheduled =
+          rule.every != 0 && (matched - rule.skip) % rule.every == 0;
+      bool drawn = rule.probability > 0.0 &&
+                   std::uniform_real_distribution<double>{}(m_random) <
+                       rule.probability;
+      if (!scheduled && !drawn) {
+        continue;
+      }
+      ++m_fired[index];
+      switch (rule.kind) {
+      case fault_kind::error:
+        if (!chosen.fail) {
+          chosen.fail = true;
+          chosen.status = rule.status;
+          ++m_stats.errors;
+        }
+        break;
+      case fault_kind::latency:
+        chosen.delay += rule.duration;
+        ++m_stats.delays;
+        break;
+      case fault_kind::hang:
+        if (!m_released) {
+          chosen.hang = true;
+          chosen.hang_bound = rule.duration;
+          ++m_stats.hangs;
+        }
+        break;
+      case fault_kind::corruption:
+        chosen.corrupt_bytes =
+            std::max(chosen.corrupt_bytes, rule.corrupt_bytes);
+        chosen.corrupt_seed = m_random();
+        break;
+      }
+    }
+    return chosen;
+  }
+
+  static void corrupt(amdsmi_gpu_metrics_t &metrics, uint32_t count,
+                      uint64_t seed) {
+    std::mt19937_64 random{seed};
+    std::uniform_int_distribution<std::size_t> offset{0, sizeof(metrics) - 1};
+    auto *bytes = reinterpret_cast<unsigned char *>(&metrics);
+    for (uint32_t i = 0; i < count; ++i) {
+      bytes[offset(random)] = static_cast<unsigned char>(random());
+    }
+  }
+
+  driver_binding<driver_t> m_inner;
+  std::vector<fault_rule> m_rules;
+
+  mutable std::mutex m_mutex; ///< Guards everything below
+  std::condition_variable m_release;
+  bool m_released{false};
+  std::vector<uint64_t> m_matched; ///< Targeted calls per rule
+  std::vector<uint64_t> m_fired;   ///< Firings per rule
+  std::mt19937_64 m_random;
+  fault_stats m_stats;
+};
+
+/**
+ * @brief Factory of fault_injection_driver instances wrapping the drivers of
+ * @p base_factory, for use with service and data_collector.
+ * @tparam base_factory Factory of the wrapped driver.
+ * @tparam configure Returns the fault rules of each created driver.
+ * @note The created driver is not reachable to call release_hangs(), so
+ * hang rules used through the factory should set a duration.
+ */
+template <smi_driver_factory base_factory, fault_config (*configure)()>
+struct fault_injection_factory {
+  using driver_t = fault_injection_driver<typename base_factory::driver_t>;
+
+  static std::shared_ptr<driver_t> create_driver() {
+    return std::make_shared<driver_t>(base_factory::create_driver(),
+                                      configure());
+  }
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
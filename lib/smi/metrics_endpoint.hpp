@@ -0,0 +1,363 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/common.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fmt/format.h>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct endpoint_address
+ * @brief Where a local endpoint listens.
+ */
+struct endpoint_address {
+  std::string unix_path{}; ///< Unix socket path; TCP is used when empty
+  uint16_t port{9400};     ///< TCP port on 127.0.0.1; zero picks a free one
+};
+
+namespace detail {
+
+/**
+ * @brief Removes the socket left at @p local by a process that exited
+ * without unlinking it.
+ *
+ * Only a socket nobody accepts on is removed: any other file, or a socket
+ * another endpoint still listens on, is left alone.
+ * @throws std::runtime_error if the path is taken.
+ */
+inline void remove_stale_socket(const sockaddr_un &local) {
+  struct stat status{};
+  if (lstat(local.sun_path, &status) != 0) {
+    if (errno == ENOENT) {
+      return;
+    }
+    throw_errno("Failed to inspect endpoint socket path");
+  }
+  if (!S_ISSOCK(status.st_mode)) {
+    errno = EEXIST;
+    throw_errno("Endpoint socket path is not a socket");
+  }
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe < 0) {
+    throw_errno("Failed to create endpoint socket");
+  }
+  int connected =
+      connect(probe, reinterpret_cast<const sockaddr *>(&local), sizeof(local));
+  int error = connected == 0 ? EADDRINUSE : errno;
+  close(probe);
+  if (error != ECONNREFUSED) {
+    errno = error;
+    throw_errno("Endpoint socket is in use");
+  }
+  if (unlink(local.sun_path) != 0 && errno != ENOENT) {
+    throw_errno("Failed to remove stale endpoint socket");
+  }
+}
+
+/**
+ * @brief Opens a listening stream socket at @p address.
+ *
+ * A Unix socket left behind by an exited process is replaced; see
+ * remove_stale_socket().
+ * @throws std::runtime_error if the socket cannot be bound.
+ */
+inline int listen_on(const endpoint_address &address) {
+  int domain = address.unix_path.empty() ? AF_INET : AF_UNIX;
+  int fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    throw_errno("Failed to create endpoint socket");
+  }
+  int bound{-1};
+  if (domain == AF_UNIX) {
+    sockaddr_un local{};
+    local.sun_family = AF_UNIX;
+    if (address.unix_path.size() >= sizeof(local.sun_path)) {
+      close(fd);
+      throw std::runtime_error("Endpoint socket path is too long");
+    }
+    std::memcpy(local.sun_path, address.unix_path.c_str(),
+                address.unix_path.size() + 1);
+    try {
+      remove_stale_socket(local);
+    } catch (...) {
+      close(fd);
+      throw;
+    }
+    bound = bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local));
+  } else {
+    int reuse{1};
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(address.port);
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bound = bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local));
+  }
+  if (bound != 0 || listen(fd, 16) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    throw_errno("Failed to listen on endpoint");
+  }
+  return fd;
+}
+
+/** @brief Sends all of @p data; gives up on the first error. */
+inline bool send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    auto sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (sent <= 0) {
+      if (sent < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data.remove_prefix(static_cast<std::size_t>(sent));
+  }
+  return true;
+}
+
+} // namespace detail
+
+/**
+ * @class metrics_endpoint
+ * @brief Minimal HTTP/1.0 server answering GET /metrics with a pre-rendered
+ * page.
+ *
+ * Listens on 127.0.0.1 or on a Unix socket, never on external interfaces.
+ * One background thread accepts connections and answers each with the
+ * page returned by the page source, then closes it; any other path gets a
+ * 404. The page source is expected to return a ready buffer (see
+ * prometheus_exposition::page()), so serving a scrape copies bytes only.
+ *
+ * Client sockets are non-blocking, and each connection gets client_timeout
+ * to send its request and take the whole answer. A client that is slower
+ * is dropped, so it cannot stall other scrapes or the destructor.
+ */
+class metrics_endpoint {
+public:
+  using page_source = std::function<std::shared_ptr<const std::string>()>;
+
+  /** Time one connection may take from accept to the last byte sent. */
+  static constexpr std::chrono::milliseconds client_timeout{1000};
+
+  /**
+   * @brief Binds the endpoint and starts serving.
+   * @throws std::runtime_error if the address cannot be bound.
+   */
+  metrics_endpoint(endpoint_address address, page_source source)
+      : m_address{std::move(address)}, m_source{std::move(source)},
+        m_listen_fd{detail::listen_on(m_address)},
+        m_wake_fd{eventfd(0, EFD_CLOEXEC)} {
+    if (m_wake_fd < 0) {
+      close(m_listen_fd);
+      detail::throw_errno("Failed to create eventfd");
+    }
+    m_thread = std::thread([this] { run(); });
+  }
+
+  metrics_endpoint(const metrics_endpoint &) = delete;
+  metrics_endpoint &operator=(const metrics_endpoint &) = delete;
+
+  ~metrics_endpoint() {
+    uint64_t wake{1};
+    [[maybe_unused]] auto written = write(m_wake_fd, &wake, sizeof(wake));
+    m_thread.join();
+    close(m_listen_fd);
+    close(m_wake_fd);
+    if (!m_address.unix_path.empty()) {
+      unlink(m_address.unix_path.c_str());
+    }
+  }
+
+  /** @brief Bound TCP port, or zero for a Unix socket. */
+  uint16_t port() const {
+    sockaddr_in local{};
+    socklen_t length = sizeof(local);
+    if (!m_address.unix_path.empty() ||
+        getsockname(m_listen_fd, reinterpret_cast<sockaddr *>(&local),
+                    &length) != 0) {
+      return 0;
+    }
+    return ntohs(local.sin_port);
+  }
+
+  /** @brief Number of requests answered so far. */
+  uint64_t requests() const { return m_requests; }
+
+private:
+  void run() {
+    pollfd fds[2] = {{m_listen_fd, POLLIN, 0}, {m_wake_fd, POLLIN, 0}};
+    for (;;) {
+      if (poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[1].revents != 0) {
+        return;
+      }
+      int client = accept4(m_listen_fd, nullptr, nullptr,
+                           SOCK_CLOEXEC | SOCK_NONBLOCK);
+      if (client >= 0) {
+        serve(client);
+        close(client);
+      }
+    }
+  }
+
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Waits until @p client is ready for @p events.
+   * @return False on timeout, error, or when the endpoint is stopping.
+   */
+  bool wait_client(int client, short events, clock::time_point deadline) {
+    for (;;) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - clock::now());
+      if (remaining.count() <= 0) {
+        return false;
+      }
+      pollfd fds[2] = {{client, events, 0}, {m_wake_fd, POLLIN, 0}};
+      int ready = poll(fds, 2, static_cast<int>(remaining.count()));
+      if (ready < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ready <= 0 || fds[1].revents != 0) {
+        return false;
+      }
+      return (fds[0].revents & (events | POLLHUP | POLLERR)) != 0;
+    }
+  }
+
+  /** @brief Sends all of @p data before @p deadline. */
+  bool send_before(int client, std::string_view data,
+                   clock::time_point deadline) {
+    while (!data.empty()) {
+      auto sent = send(client, data.data(), data.size(), MSG_NOSIGNAL);
+      if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        if (!wait_client(client, POLLOUT, deadline)) {
+          return false;
+        }
+        continue;
+      }
+      if (sent <= 0) {
+        if (sent < 0 && errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      data.remove_prefix(static_cast<std::size_t>(sent));
+    }
+    return true;
+  }
+
+  void serve(int client) {
+    auto deadline = clock::now() + client_timeout;
+
+    // Only the request line matters; read until the end of the headers.
+    char buffer[4096];
+    std::size_t length{0};
+    while (length < sizeof(buffer)) {
+      auto received = recv(client, buffer + length, sizeof(buffer) - length, 0);
+      if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        if (!wait_client(client, POLLIN, deadline)) {
+          break;
+        }
+        continue;
+      }
+      if (received < 0 && errno == EINTR) {
+        continue;
+      }
+      if (received <= 0) {
+        break;
+      }
+      length += static_cast<std::size_t>(received);
+      if (std::string_view{buffer, length}.find("\r\n\r\n") !=
+          std::string_view::npos) {
+        break;
+      }
+    }
+    std::string_view request{buffer, length};
+    ++m_requests;
+
+    if (!request.starts_with("GET /metrics ") &&
+        !request.starts_with("GET /metrics?")) {
+      send_before(client,
+                  "HTTP/1.0 404 Not Found\r\n"
+                  "Content-Length: 0\r\n\r\n",
+                  deadline);
+      return;
+    }
+    auto page = m_source();
+    std::string_view body = page ? std::string_view{*page} : "";
+    auto header = fmt::format("HTTP/1.0 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: {}\r\n\r\n",
+                              body.size());
+    if (send_before(client, header, deadline)) {
+      send_before(client, body, deadline);
+    }
+  }
+
+  endpoint_address m_address;
+  page_source m_source;
+  int m_listen_fd;
+  int m_wake_fd;
+  std::atomic<uint64_t> m_requests{0};
+  std::thread m_thread;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,269 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @class seqlock
+ * @tparam value_t Trivially copyable value.
+ * @brief Single-writer, multi-reader cell with lock-free reads.
+ *
+ * The writer bumps a sequence number to odd, stores the value and bumps it
+ * back to even; readers retry if the sequence changed while they copied.
+ * The value is kept in atomic words so concurrent copies are well defined.
+ */
+template <typename value_t> class seqlock {
+  static_assert(std::is_trivially_copyable_v<value_t>,
+                "seqlock requires a trivially copyable value!");
+
+public:
+  /** @brief Publishes a new value. Only one thread may store. */
+  void store(const value_t &value) {
+    std::array<uint64_t, word_count> words{};
+    std::memcpy(words.data(), &value, sizeof(value_t));
+
+    auto sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < word_count; ++i) {
+      m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /** @brief Returns a consistent copy of the latest value. */
+  value_t load() const {
+    std::array<uint64_t, word_count> words{};
+    for (;;) {
+      auto before = m_sequence.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      for (std::size_t i = 0; i < word_count; ++i) {
+        words[i] = m_words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_sequence.load(std::memory_order_relaxed) == before) {
+        break;
+      }
+    }
+    value_t value;
+    std::memcpy(&value, words.data(), sizeof(value_t));
+    return value;
+  }
+
+private:
+  static constexpr std::size_t word_count =
+      (sizeof(value_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> m_sequence{0};
+  std::array<std::atomic<uint64_t>, word_count> m_words{};
+};
+
+/**
+ * @struct node_snapshot
+ * @brief Totals and extremes over every sampled processor of the node.
+ */
+struct node_snapshot {
+  uint64_t round;                   ///< Number of rounds aggregated so far
+  uint64_t total_socket_power;      ///< Sum of current socket power in watts
+  uint64_t total_memory_usage;      ///< Sum of VRAM usage in bytes
+  double mean_gfx_activity;         ///< Mean GFX activity in %
+  double mean_umc_activity;         ///< Mean UMC activity in %
+  uint32_t processor_count;         ///< Processors with at least one sample
+  uint16_t max_hotspot_temperature; ///< Hottest hotspot in degrees C
+};
+
+/**
+ * @class node_aggregate
+ * @brief Node totals kept up to date incrementally, once per round.
+ *
+ * Each processor's last contribution is remembered, so a new sample only
+ * adjusts the sums by its difference. The maximum hotspot temperature is
+ * rescanned only when the processor holding it cools down. The result is
+ * published through a seqlock, so snapshot() is a cheap lock-free read from
+ * any thread.
+ */
+class node_aggregate {
+public:
+  /**
+   * @brief Constructs an empty aggregate for @p rows processors.
+   */
+  explicit node_aggregate(std::size_t rows)
+      : m_contributions(rows, smi_metrics{}), m_vram_used(rows, 0),
+        m_included(rows, 0) {
+    m_published.store(m_current);
+  }
+
+  /**
+   * @brief Replaces the contribution of one processor.
+   * @param row Processor table row.
+   * @param sample Latest scalar metrics of the processor.
+   * @param vram_used VRAM in use in bytes, from the processor's
+   * memory_snapshot; smi_metrics::memory_usage is too narrow for GPUs with
+   * 4 GiB or more in use.
+   * @note Call publish() to make the change visible to snapshot().
+   */
+  void apply(std::size_t row, const smi_metrics &sample, uint64_t vram_used) {
+    auto &previous = m_contributions[row];
+    if (!m_included[row]) {
+      m_included[row] = 1;
+      ++m_current.processor_count;
+      previous = smi_metrics{};
+      m_vram_used[row] = 0;
+    }
+
+    m_current.total_socket_power +=
+        uint64_t{sample.current_socket_power} - previous.current_socket_power;
+    m_current.total_memory_usage += vram_used - m_vram_used[row];
+    m_vram_used[row] = vram_used;
+    m_gfx_activity_sum +=
+        uint64_t{sample.gfx_activity} - previous.gfx_activity;
+    m_umc_activity_sum +=
+        uint64_t{sample.umc_activity} - previous.umc_activity;
+
+    bool was_hottest =
+        previous.hotspot_temperature == m_current.max_hotspot_temperature;
+    if (sample.hotspot_temperature >= m_current.max_hotspot_temperature) {
+      m_current.max_hotspot_temperature = sample.hotspot_temperature;
+    } else if (was_hottest) {
+      m_rescan_hotspot = true;
+    }
+    previous = sample;
+  }
+
+  /**
+   * @brief Grows the aggregate to @p rows processors.
+   */
+  void resize(std::size_t rows) {
+    if (rows > m_contributions.size()) {
+      m_contributions.resize(rows, smi_metrics{});
+      m_vram_used.resize(rows, 0);
+      m_included.resize(rows, 0);
+    }
+  }
+
+  /**
+   * @brief Removes the contribution of a processor that went away.
+   * @note Call publish() to make the change visible to snapshot().
+   */
+  void remove(std::size_t row) {
+    if (!m_included[row]) {
+      return;
+    }
+    const auto &previous = m_contributions[row];
+    m_current.total_socket_power -= previous.current_socket_power;
+    m_current.total_memory_usage -= m_vram_used[row];
+    m_gfx_activity_sum -= previous.gfx_activity;
+    m_umc_activity_sum -= previous.umc_activity;
+    --m_current.processor_count;
+    m_included[row] = 0;
+    m_rescan_hotspot = true;
+  }
+
+  /**
+   * @brief Completes a round and publishes the new snapshot.
+   */
+  void publish() {
+    if (m_rescan_hotspot) {
+      uint16_t hottest{0};
+      for (std::size_t row = 0; row < m_contributions.size(); ++row) {
+        if (m_included[row]) {
+          hottest = std::max(hottest, m_contributions[row].hotspot_temperature);
+        }
+      }
+      m_current.max_hotspot_temperature = hottest;
+      m_rescan_hotspot = false;
+    }
+
+    auto count = m_current.processor_count;
+    m_current.mean_gfx_activity =
+        count == 0 ? 0.0 : static_cast<double>(m_gfx_activity_sum) / count;
+    m_current.mean_umc_activity =
+        count == 0 ? 0.0 : static_cast<double>(m_umc_activity_sum) / count;
+    ++m_current.round;
+    m_published.store(m_current);
+  }
+
+  /**
+   * @brief Applies every row of a table that was read successfully and
+   * publishes the round.
+   * @param table The sampled table.
+   * @param refreshed Groups refreshed per row; all rows when empty.
+   */
+  template <typename driver>
+  void update(const processor_table<driver> &table,
+              std::span<const group_mask> refreshed = {}) {
+    auto statuses = table.statuses();
+    auto samples = table.samples();
+    auto memory = table.memory();
+    auto rows = std::min(table.size(), m_contributions.size());
+    for (std::size_t row = 0; row < rows; ++row) {
+      bool read = refreshed.empty() || refreshed[row] != 0;
+      if (read && statuses[row] == AMDSMI_STATUS_SUCCESS) {
+        apply(row, samples[row], memory[row].used[AMDSMI_MEM_TYPE_VRAM]);
+      }
+    }
+    publish();
+  }
+
+  /**
+   * @brief Returns the latest published snapshot. Safe from any thread.
+   */
+  node_snapshot snapshot() const { return m_published.load(); }
+
+private:
+  std::vector<smi_metrics> m_contributions; ///< Last sample applied per row
+  std::vector<uint64_t> m_vram_used;        ///< Last VRAM bytes per row
+  std::vector<uint8_t> m_included;          ///< Whether a row has a sample
+  uint64_t m_gfx_activity_sum{0};
+  uint64_t m_umc_activity_sum{0};
+  bool m_rescan_hotspot{false};
+  node_snapshot m_current{};
+  seqlock<node_snapshot> m_published;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
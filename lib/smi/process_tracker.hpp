@@ -0,0 +1,265 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct process_usage
+ * @brief GPU usage of one process on one processor.
+ */
+struct process_usage {
+  uint32_t processor{0};    ///< Row of the processor table
+  uint32_t pid{0};          ///< Process ID
+  uint64_t vram_bytes{0};   ///< VRAM allocated by the process
+  uint64_t gtt_bytes{0};    ///< GTT (GPU-mapped system) memory
+  uint64_t cpu_bytes{0};    ///< CPU-visible memory
+  uint64_t gfx_ns{0};       ///< Accumulated graphics engine time
+  uint64_t enc_ns{0};       ///< Accumulated encoder engine time
+  uint32_t cu_occupancy{0}; ///< Compute units in use
+  std::string name;         ///< Process name, as reported by the driver
+};
+
+/**
+ * @brief Kind of change reported for a process.
+ */
+enum class process_change : uint8_t {
+  appeared,   ///< Not present in the previous list
+  changed,    ///< Usage moved by at least the thresholds
+  disappeared ///< No longer in the list; usage is the last one seen
+};
+
+/**
+ * @struct process_event
+ * @brief One change of the process list of a processor.
+ */
+struct process_event {
+  process_change change{process_change::appeared};
+  uint64_t host_ns{0}; ///< Host time of the list read
+  process_usage usage;
+};
+
+/**
+ * @struct process_thresholds
+ * @brief Minimum movement for a running process to be reported as changed.
+ *
+ * Movement is measured from the usage last reported for the process, so
+ * slow growth is reported once it adds up to a threshold.
+ */
+struct process_thresholds {
+  uint64_t memory_bytes{1 << 20};  ///< VRAM, GTT or CPU memory delta
+  uint64_t engine_ns{100'000'000}; ///< Engine time accumulated
+};
+
+/**
+ * @class process_tracker
+ * @brief Turns successive process lists of each processor into changes.
+ *
+ * The tracker keeps the processes of every processor sorted by PID and
+ * merges each new list against them in one pass, so a round costs a sort of
+ * the new list and emits events only for processes that appeared, changed
+ * or disappeared. Process names are copied when a process first appears.
+ *
+ * Not thread-safe; callers serialize updates and snapshots.
+ */
+class process_tracker {
+public:
+  /**
+   * @brief Constructs a tracker without any known process.
+   * @param processor_count Number of processors (rows of the table).
+   * @param thresholds Minimum movement reported as a change.
+   */
+  explicit process_tracker(std::size_t processor_count = 0,
+                           process_thresholds thresholds = {})
+      : m_rows(processor_count), m_thresholds{thresholds} {}
+
+  /** @brief Number of processors tracked. */
+  std::size_t size() const { return m_rows.size(); }
+
+  /** @brief Adds rows for processors appended to the table. */
+  void resize(std::size_t rows) {
+    if (rows > m_rows.size()) {
+      m_rows.resize(rows);
+    }
+  }
+
+  /**
+   * @brief Merges the latest process list of one processor.
+   * @param processor Row of the processor table.
+   * @param processes Processes reported by the driver, in any order.
+   * @param host_ns Host time of the read.
+   * @param events Receives the changes; appended to.
+   * @return Number of events appended.
+   */
+  std::size_t update(std::size_t processor,
+                     std::span<const amdsmi_proc_info_t> processes,
+                     uint64_t host_ns, std::vector<process_event> &events) {
+    auto &known = m_rows[processor];
+    auto before = events.size();
+
+    m_order.resize(processes.size());
+    for (std::size_t i = 0; i < processes.size(); ++i) {
+      m_order[i] = &processes[i];
+    }
+    std::sort(m_order.begin(), m_order.end(), [](auto *lhs, auto *rhs) {
+      return lhs->pid < rhs->pid;
+    });
+
+    m_next.clear();
+    auto current = known.begin();
+    for (std::size_t i = 0; i < m_order.size(); ++i) {
+      const auto &info = *m_order[i];
+      if (i + 1 < m_order.size() && m_order[i + 1]->pid == info.pid) {
+        continue; // listed twice by the driver; keep one entry
+      }
+      while (current != known.end() && current->usage.pid < info.pid) {
+        emit(events, process_change::disappeared, host_ns, current->usage);
+        ++current;
+      }
+      if (current != known.end() && current->usage.pid == info.pid) {
+        auto &entry = m_next.emplace_back(std::move(*current));
+        ++current;
+        assign(entry.usage, info);
+        if (moved(entry)) {
+          entry.reported = entry.usage;
+          emit(events, process_change::changed, host_ns, entry.usage);
+        }
+        continue;
+      }
+      auto &entry = m_next.emplace_back();
+      entry.usage.processor = static_cast<uint32_t>(processor);
+      entry.usage.pid = info.pid;
+      entry.usage.name.assign(info.name,
+                              strnlen(info.name, sizeof(info.name)));
+      assign(entry.usage, info);
+      entry.reported = entry.usage;
+      emit(events, process_change::appeared, host_ns, entry.usage);
+    }
+    for (; current != known.end(); ++current) {
+      emit(events, process_change::disappeared, host_ns, current->usage);
+    }
+    known.swap(m_next);
+    return events.size() - before;
+  }
+
+  /**
+   * @brief Forgets every process of a retired or replaced processor.
+   * @return Number of disappeared events appended to @p events.
+   */
+  std::size_t reset_row(std::size_t processor, uint64_t host_ns,
+                        std::vector<process_event> &events) {
+    auto &known = m_rows[processor];
+    for (const auto &entry : known) {
+      emit(events, process_change::disappeared, host_ns, entry.usage);
+    }
+    auto count = known.size();
+    known.clear();
+    return count;
+  }
+
+  /** @brief Number of processes currently known across all processors. */
+  std::size_t process_count() const {
+    std::size_t count{0};
+    for (const auto &known : m_rows) {
+      count += known.size();
+    }
+    return count;
+  }
+
+  /**
+   * @brief Returns the latest usage of every known process, by processor and
+   * then by PID.
+   */
+  std::vector<process_usage> snapshot() const {
+    std::vector<process_usage> usage;
+    usage.reserve(process_count());
+    for (const auto &known : m_rows) {
+      for (const auto &entry : known) {
+        usage.push_back(entry.usage);
+      }
+    }
+    return usage;
+  }
+
+private:
+  struct tracked_process {
+    process_usage usage;    ///< Latest values
+    process_usage reported; ///< Values of the latest event; name unused
+  };
+
+  static void assign(process_usage &usage, const amdsmi_proc_info_t &info) {
+    usage.vram_bytes = info.memory_usage.vram_mem;
+    usage.gtt_bytes = info.memory_usage.gtt_mem;
+    usage.cpu_bytes = info.memory_usage.cpu_mem;
+    usage.gfx_ns = info.engine_usage.gfx;
+    usage.enc_ns = info.engine_usage.enc;
+    usage.cu_occupancy = info.cu_occupancy;
+  }
+
+  static uint64_t distance(uint64_t lhs, uint64_t rhs) {
+    return lhs > rhs ? lhs - rhs : rhs - lhs;
+  }
+
+  bool moved(const tracked_process &entry) const {
+    const auto &now = entry.usage;
+    const auto &then = entry.reported;
+    return now.cu_occupancy != then.cu_occupancy ||
+           distance(now.vram_bytes, then.vram_bytes) >=
+               m_thresholds.memory_bytes ||
+           distance(now.gtt_bytes, then.gtt_bytes) >=
+               m_thresholds.memory_bytes ||
+           distance(now.cpu_bytes, then.cpu_bytes) >=
+               m_thresholds.memory_bytes ||
+           distance(now.gfx_ns, then.gfx_ns) >= m_thresholds.engine_ns ||
+           distance(now.enc_ns, then.enc_ns) >= m_thresholds.engine_ns;
+  }
+
+  static void emit(std::vector<process_event> &events, process_change change,
+                   uint64_t host_ns, const process_usage &usage) {
+    events.push_back({change, host_ns, usage});
+  }
+
+  std::vector<std::vector<tracked_process>> m_rows; ///< Sorted by PID
+  process_thresholds m_thresholds;
+  std::vector<const amdsmi_proc_info_t *> m_order; ///< New list by PID
+  std::vector<tracked_process> m_next;             ///< Merge output
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -28,20 +28,28 @@
 
 #pragma once
 
+#include "smi/driver.hpp"
+
 #include <algorithm>
 #include <amd_smi/amdsmi.h>
+#include <array>
 #include <bitset>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace rocprofsys {
 namespace amd_smi {
@@ -58,6 +66,12 @@ constexpr auto metric_value_not_supported = 0xffff;
 #define AMDSMI_MAX_NUM_XCP 8
 #endif
 
+/**
+ * @brief Number of memory types reported per processor (VRAM, CPU-visible
+ * VRAM and GTT), indexed by amdsmi_memory_type_t.
+ */
+constexpr std::size_t memory_type_count = AMDSMI_MEM_TYPE_LAST + 1;
+
 struct supported_metrics {
   uint32_t current_socket_power : 1;
   uint32_t average_socket_power : 1;
@@ -69,12 +83,42 @@ struct supported_metrics {
   uint32_t mm_activity : 1;
   uint32_t vcn_xcp_stats : 1;
   uint32_t jpeg_xcp_stats : 1;
+  uint32_t gfx_clock : 1;
+  uint32_t memory_clock : 1;
+  uint32_t throttle_status : 1;
+  uint32_t throttle_from_residency : 1;      ///< From residency accumulators
+  uint32_t memory_types : memory_type_count; ///< Bit per amdsmi_memory_type_t
   struct {
     std::bitset<AMDSMI_MAX_NUM_VCN> vcn_activity;
     std::bitset<AMDSMI_MAX_NUM_JPEG_ENGINES> jpeg_activity;
   } xcp_metrics[AMDSMI_MAX_NUM_XCP];
 };
 
+/**
+ * @struct throttle_residency
+ * @brief Violation residency accumulators of one GPU metrics sample.
+ *
+ * Processors without an ASIC-independent throttle status (MI300 with GPU
+ * metrics v1.4 and later) instead count, per throttler, the firmware ticks
+ * during which it was active; accumulation_counter counts every tick. A
+ * throttler was active between two samples if its accumulator moved.
+ */
+struct throttle_residency {
+  uint64_t accumulation_counter;
+  uint64_t prochot;
+  uint64_t ppt;
+  uint64_t socket_thermal;
+  uint64_t vr_thermal;
+  uint64_t hbm_thermal;
+};
+
+/**
+ * @struct smi_metrics
+ * @brief Scalar metrics of one processor sample.
+ *
+ * Per-XCP media engine activity is not part of this record; it is packed
+ * separately according to the processor's xcp_engine_layout.
+ */
 struct smi_metrics {
   uint32_t current_socket_power;
   uint32_t average_socket_power;
@@ -84,12 +128,342 @@ struct smi_metrics {
   uint32_t gfx_activity;
   uint32_t umc_activity;
   uint32_t mm_activity;
-  struct {
-    uint16_t vcn_activity[AMDSMI_MAX_NUM_VCN];
-    uint16_t jpeg_activity[AMDSMI_MAX_NUM_JPEG_ENGINES];
-  } xcp_metrics[AMDSMI_MAX_NUM_XCP];
+  uint16_t gfx_clock;           ///< Current GFX clock in MHz
+  uint16_t memory_clock;        ///< Current memory (UCLK) clock in MHz
+  uint64_t throttle_status;     ///< ASIC-independent throttler bits
+  throttle_residency residency; ///< Accumulators throttle_status came from
 };
 
+/**
+ * @struct memory_snapshot
+ * @brief Usage and size of every memory type of one processor.
+ *
+ * Both arrays are indexed by amdsmi_memory_type_t. Sizes are read once when
+ * the processor is probed; usage is refreshed with the memory metric group.
+ * Types the processor does not report stay zero.
+ */
+struct memory_snapshot {
+  std::array<uint64_t, memory_type_count> used{};  ///< Bytes in use
+  std::array<uint64_t, memory_type_count> total{}; ///< Bytes available
+
+  uint64_t used_bytes(amdsmi_memory_type_t type) const { return used[type]; }
+  uint64_t total_bytes(amdsmi_memory_type_t type) const {
+    return total[type];
+  }
+};
+
+/**
+ * @brief Current host time in nanoseconds on the monotonic (steady) clock.
+ */
+inline uint64_t host_timestamp_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+/**
+ * @struct sample_timestamp
+ * @brief When a sample was taken, in both the host and the GPU clock domain.
+ *
+ * The host timestamps bracket the driver call, so the sample was taken
+ * somewhere inside [host_begin_ns, host_end_ns]. gpu_clock_counter is the
+ * firmware system_clock_counter reported with the metrics, or zero when the
+ * GPU metrics table was not read.
+ */
+struct sample_timestamp {
+  uint64_t host_begin_ns;     ///< Monotonic host time before the driver call
+  uint64_t host_end_ns;       ///< Monotonic host time after the driver call
+  uint64_t gpu_clock_counter; ///< Firmware system clock counter
+
+  /** @brief Midpoint of the host window. */
+  uint64_t host_ns() const {
+    return host_begin_ns + (host_end_ns - host_begin_ns) / 2;
+  }
+
+  /** @brief Width of the host window in nanoseconds. */
+  uint64_t uncertainty_ns() const { return host_end_ns - host_begin_ns; }
+};
+
+/**
+ * @brief Media engine types reported per XCP.
+ */
+enum class xcp_engine_kind : uint8_t { vcn, jpeg };
+
+/**
+ * @struct xcp_engine_slot
+ * @brief Identifies one supported media engine of one XCP.
+ */
+struct xcp_engine_slot {
+  uint8_t xcp;
+  xcp_engine_kind kind;
+  uint8_t engine;
+};
+
+/**
+ * @class xcp_engine_layout
+ * @brief Dense packing of the media engines a processor supports.
+ *
+ * Built once from the supported_metrics bitsets. Slot i of the layout maps to
+ * value i of a packed activity array, so a sample only carries the engines
+ * that exist: XCP-major order, VCN engines before JPEG engines.
+ */
+class xcp_engine_layout {
+public:
+  xcp_engine_layout() = default;
+
+  /**
+   * @brief Builds the layout from the engines marked supported.
+   * @param supported Probe result of the processor.
+   */
+  explicit xcp_engine_layout(const supported_metrics &supported) {
+    for (std::size_t xcp = 0; xcp < AMDSMI_MAX_NUM_XCP; ++xcp) {
+      const auto &engines = supported.xcp_metrics[xcp];
+      for (std::size_t engine = 0; engine < engines.vcn_activity.size();
+           ++engine) {
+        if (engines.vcn_activity[engine]) {
+          add(xcp, xcp_engine_kind::vcn, engine);
+        }
+      }
+      for (std::size_t engine = 0; engine < engines.jpeg_activity.size();
+           ++engine) {
+        if (engines.jpeg_activity[engine]) {
+          add(xcp, xcp_engine_kind::jpeg, engine);
+        }
+      }
+    }
+  }
+
+  /** @brief Number of packed engine values per sample. */
+  std::size_t size() const { return m_slots.size(); }
+
+  /** @brief Engine described by each packed value. */
+  std::span<const xcp_engine_slot> slots() const { return m_slots; }
+
+  /**
+   * @brief Copies the activity of the supported engines into @p activity.
+   * @param gpu_metrics Raw GPU metrics read from the driver.
+   * @param activity Destination holding at least size() values.
+   */
+  void gather(const amdsmi_gpu_metrics_t &gpu_metrics,
+              std::span<uint16_t> activity) const {
+    const auto *base = reinterpret_cast<const unsigned char *>(&gpu_metrics);
+    for (std::size_t index = 0; index < m_offsets.size(); ++index) {
+      std::memcpy(&activity[index], base + m_offsets[index], sizeof(uint16_t));
+    }
+  }
+
+private:
+  void add(std::size_t xcp, xcp_engine_kind kind, std::size_t engine) {
+    m_slots.push_back({static_cast<uint8_t>(xcp), kind,
+                       static_cast<uint8_t>(engine)});
+    std::size_t engines_offset =
+        kind == xcp_engine_kind::vcn
+            ? offsetof(amdsmi_gpu_xcp_metrics_t, vcn_busy)
+            : offsetof(amdsmi_gpu_xcp_metrics_t, jpeg_busy);
+    m_offsets.push_back(static_cast<uint32_t>(
+        offsetof(amdsmi_gpu_metrics_t, xcp_stats) +
+        xcp * sizeof(amdsmi_gpu_xcp_metrics_t) + engines_offset +
+        engine * sizeof(uint16_t)));
+  }
+
+  std::vector<xcp_engine_slot> m_slots;
+  std::vector<uint32_t> m_offsets; ///< Byte offsets into amdsmi_gpu_metrics_t
+};
+
+/**
+ * @brief Compact bitmask of the scalar metrics a processor supports.
+ *
+ * Mirrors the single-bit fields of supported_metrics so per-processor
+ * capabilities can be stored densely and tested without touching the
+ * per-XCP engine bitsets.
+ */
+using capability_mask = uint32_t;
+
+namespace capability {
+constexpr capability_mask current_socket_power = 1u << 0;
+constexpr capability_mask average_socket_power = 1u << 1;
+constexpr capability_mask memory_usage = 1u << 2;
+constexpr capability_mask hotspot_temperature = 1u << 3;
+constexpr capability_mask edge_temperature = 1u << 4;
+constexpr capability_mask gfx_activity = 1u << 5;
+constexpr capability_mask umc_activity = 1u << 6;
+constexpr capability_mask mm_activity = 1u << 7;
+constexpr capability_mask vcn_xcp_stats = 1u << 8;
+constexpr capability_mask jpeg_xcp_stats = 1u << 9;
+constexpr capability_mask gfx_clock = 1u << 10;
+constexpr capability_mask memory_clock = 1u << 11;
+constexpr capability_mask throttle_status = 1u << 12;
+constexpr capability_mask all = (1u << 13) - 1;
+} // namespace capability
+
+/**
+ * @brief Metrics that are sampled together at a common rate.
+ */
+enum class metric_group : uint8_t {
+  power,
+  thermal,
+  memory,
+  activity,
+  xcp_engines,
+  clocks
+};
+
+constexpr std::size_t metric_group_count = 6;
+
+/**
+ * @brief Bitmask of metric groups, one bit per metric_group.
+ */
+using group_mask = uint8_t;
+
+constexpr group_mask group_bit(metric_group group) {
+  return static_cast<group_mask>(1u << static_cast<uint8_t>(group));
+}
+
+constexpr group_mask all_metric_groups = (1u << metric_group_count) - 1;
+
+/**
+ * @brief Groups served by a single get_gpu_metrics_info call.
+ */
+constexpr group_mask gpu_metrics_groups =
+    all_metric_groups & ~group_bit(metric_group::memory);
+
+/**
+ * @brief Capabilities of which a processor needs at least one for @p group to
+ * be worth sampling.
+ */
+constexpr capability_mask group_capabilities(metric_group group) {
+  switch (group) {
+  case metric_group::power:
+    return capability::current_socket_power | capability::average_socket_power;
+  case metric_group::thermal:
+    return capability::hotspot_temperature | capability::edge_temperature;
+  case metric_group::memory:
+    return capability::memory_usage;
+  case metric_group::activity:
+    return capability::gfx_activity | capability::umc_activity |
+           capability::mm_activity;
+  case metric_group::xcp_engines:
+    return capability::vcn_xcp_stats | capability::jpeg_xcp_stats;
+  case metric_group::clocks:
+    return capability::gfx_clock | capability::memory_clock |
+           capability::throttle_status;
+  }
+  return 0;
+}
+
+/**
+ * @brief Packs the scalar fields of supported_metrics into a capability_mask.
+ */
+inline capability_mask to_capability_mask(const supported_metrics &metrics) {
+  capability_mask mask{0};
+  auto set = [&mask](bool flag, capability_mask bit) {
+    if (flag)
+      mask |= bit;
+  };
+  set(metrics.current_socket_power, capability::current_socket_power);
+  set(metrics.average_socket_power, capability::average_socket_power);
+  set(metrics.memory_usage, capability::memory_usage);
+  set(metrics.hotspot_temperature, capability::hotspot_temperature);
+  set(metrics.edge_temperature, capability::edge_temperature);
+  set(metrics.gfx_activity, capability::gfx_activity);
+  set(metrics.umc_activity, capability::umc_activity);
+  set(metrics.mm_activity, capability::mm_activity);
+  set(metrics.vcn_xcp_stats, capability::vcn_xcp_stats);
+  set(metrics.jpeg_xcp_stats, capability::jpeg_xcp_stats);
+  set(metrics.gfx_clock, capability::gfx_clock);
+  set(metrics.memory_clock, capability::memory_clock);
+  set(metrics.throttle_status, capability::throttle_status);
+  return mask;
+}
+
+/**
+ * @brief Current GFX clock of a GPU metrics sample in MHz.
+ *
+ * Partitioned processors (MI300 with GPU metrics v1.4 and later) leave
+ * current_gfxclk unsupported and report one clock per XCC instead; their
+ * fastest valid XCC clock is used then.
+ * @return The clock, or metric_value_not_supported if neither is reported.
+ */
+inline uint16_t current_gfx_clock(const amdsmi_gpu_metrics_t &gpu_metrics) {
+  if (gpu_metrics.current_gfxclk != metric_value_not_supported) {
+    return gpu_metrics.current_gfxclk;
+  }
+  uint16_t fastest{0};
+  bool any{false};
+  for (auto clock : gpu_metrics.current_gfxclks) {
+    if (clock != metric_value_not_supported) {
+      fastest = std::max(fastest, clock);
+      any = true;
+    }
+  }
+  return any ? fastest : static_cast<uint16_t>(metric_value_not_supported);
+}
+
+/**
+ * @brief ASIC-independent throttle status bits reported for each violation
+ * residency accumulator.
+ */
+namespace residency_throttler {
+constexpr uint64_t ppt = uint64_t{1} << 0;             ///< PPT0
+constexpr uint64_t hbm_thermal = uint64_t{1} << 34;    ///< TEMP_MEM
+constexpr uint64_t socket_thermal = uint64_t{1} << 36; ///< TEMP_HOTSPOT
+constexpr uint64_t vr_thermal = uint64_t{1} << 44;     ///< VRHOT0
+constexpr uint64_t prochot = uint64_t{1} << 49;        ///< PROCHOT_GFX
+} // namespace residency_throttler
+
+/**
+ * @brief Violation residency accumulators of a GPU metrics sample.
+ */
+inline throttle_residency
+read_throttle_residency(const amdsmi_gpu_metrics_t &gpu_metrics) {
+  return {gpu_metrics.accumulation_counter, gpu_metrics.prochot_residency_acc,
+          gpu_metrics.ppt_residency_acc, gpu_metrics.socket_thm_residency_acc,
+          gpu_metrics.vr_thm_residency_acc, gpu_metrics.hbm_thm_residency_acc};
+}
+
+/**
+ * @brief Throttle status implied by the residency accumulators of two
+ * consecutive samples.
+ *
+ * Each throttler whose accumulator moved sets its residency_throttler bit.
+ * Accumulators the processor does not report stay at UINT64_MAX and never
+ * set a bit.
+ * @param previous Accumulators of the previous sample; all zero before the
+ * first one.
+ * @param current Accumulators of the new sample.
+ * @param last_status Status derived for the previous sample, kept when the
+ * firmware has not accumulated since.
+ * @return The derived status; zero without a previous sample or after the
+ * accumulation counter was reset.
+ */
+inline uint64_t residency_throttle_status(const throttle_residency &previous,
+                                          const throttle_residency &current,
+                                          uint64_t last_status) {
+  if (previous.accumulation_counter == 0 ||
+      current.accumulation_counter < previous.accumulation_counter) {
+    return 0;
+  }
+  if (current.accumulation_counter == previous.accumulation_counter) {
+    return last_status;
+  }
+  uint64_t status{0};
+  auto accumulated = [&status](uint64_t before, uint64_t after, uint64_t bit) {
+    if (after != std::numeric_limits<uint64_t>::max() && after > before) {
+      status |= bit;
+    }
+  };
+  accumulated(previous.prochot, current.prochot, residency_throttler::prochot);
+  accumulated(previous.ppt, current.ppt, residency_throttler::ppt);
+  accumulated(previous.socket_thermal, current.socket_thermal,
+              residency_throttler::socket_thermal);
+  accumulated(previous.vr_thermal, current.vr_thermal,
+              residency_throttler::vr_thermal);
+  accumulated(previous.hbm_thermal, current.hbm_thermal,
+              residency_throttler::hbm_thermal);
+  return status;
+}
+
 template <typename BitsetT>
 static std::string bitset_to_index_list(const BitsetT &bs) {
   std::stringstream ss;
@@ -105,6 +479,306 @@ static std::string bitset_to_index_list(const BitsetT &bs) {
   return ss.str();
 }
 
+/**
+ * @brief Probes which metrics a processor reports.
+ * @tparam driver The driver interface type used to communicate with the
+ * processor.
+ * @param driver_api Driver interface used for the probe.
+ * @param processor_handle The processor handle to probe.
+ * @return Bitfield of the metrics the processor supports.
+ */
+template <metrics_driver driver>
+supported_metrics
+probe_supported_metrics(driver &driver_api,
+                        amdsmi_processor_handle processor_handle) {
+  supported_metrics supported{};
+
+  amdsmi_power_info_t socker_power_info;
+  auto driver_call_result_success =
+      driver_api.get_power_info(processor_handle, &socker_power_info) ==
+      AMDSMI_STATUS_SUCCESS;
+
+  supported.average_socket_power =
+      driver_call_result_success &&
+      socker_power_info.average_socket_power != metric_value_not_supported;
+  supported.current_socket_power =
+      driver_call_result_success &&
+      socker_power_info.current_socket_power != metric_value_not_supported;
+
+  amdsmi_engine_usage_t info;
+  driver_call_result_success =
+      driver_api.get_gpu_activity(processor_handle, &info) ==
+      AMDSMI_STATUS_SUCCESS;
+  supported.gfx_activity = driver_call_result_success;
+  supported.mm_activity = driver_call_result_success;
+  supported.umc_activity = driver_call_result_success;
+
+  for (std::size_t type = 0; type < memory_type_count; ++type) {
+    uint64_t memory_usage;
+    if (driver_api.get_memory_usage(processor_handle,
+                                    static_cast<amdsmi_memory_type_t>(type),
+                                    &memory_usage) == AMDSMI_STATUS_SUCCESS) {
+      supported.memory_types |= 1u << type;
+    }
+  }
+  supported.memory_usage =
+      (supported.memory_types & (1u << AMDSMI_MEM_TYPE_VRAM)) != 0;
+
+  int64_t temperature;
+  driver_call_result_success =
+      driver_api.get_temperature_metric(
+          processor_handle, AMDSMI_TEMPERATURE_TYPE_HOTSPOT,
+          AMDSMI_TEMP_CURRENT, &temperature) == AMDSMI_STATUS_SUCCESS;
+  supported.hotspot_temperature =
+      driver_call_result_success && temperature != metric_value_not_supported;
+
+  driver_call_result_success =
+      driver_api.get_temperature_metric(
+          processor_handle, AMDSMI_TEMPERATURE_TYPE_EDGE, AMDSMI_TEMP_CURRENT,
+          &temperature) == AMDSMI_STATUS_SUCCESS;
+  supported.edge_temperature =
+      driver_call_result_success && temperature != metric_value_not_supported;
+
+  amdsmi_gpu_metrics_t gpu_metrics;
+  driver_call_result_success =
+      driver_api.get_gpu_metrics_info(processor_handle, &gpu_metrics) ==
+      AMDSMI_STATUS_SUCCESS;
+  std::for_each(
+      std::begin(gpu_metrics.xcp_stats), std::end(gpu_metrics.xcp_stats),
+      [&, xcp_index = 0](const amdsmi_gpu_xcp_metrics_t &xcp_stats) mutable {
+        std::for_each(
+            std::begin(xcp_stats.jpeg_busy), std::end(xcp_stats.jpeg_busy),
+            [&, index = 0](const auto &engine_busy_value) mutable {
+              supported.xcp_metrics[xcp_index].jpeg_activity[index++] =
+                  driver_call_result_success &&
+                  engine_busy_value != metric_value_not_supported;
+            });
+        std::for_each(
+            std::begin(xcp_stats.vcn_busy), std::end(xcp_stats.vcn_busy),
+            [&, index = 0](const auto &engine_busy_value) mutable {
+              supported.xcp_metrics[xcp_index].vcn_activity[index++] =
+                  driver_call_result_success &&
+                  engine_busy_value != metric_value_not_supported;
+            });
+        xcp_index++;
+      });
+
+  supported.gfx_clock =
+      driver_call_result_success &&
+      current_gfx_clock(gpu_metrics) != metric_value_not_supported;
+  supported.memory_clock =
+      driver_call_result_success &&
+      gpu_metrics.current_uclk != metric_value_not_supported;
+  supported.throttle_status =
+      driver_call_result_success &&
+      gpu_metrics.indep_throttle_status !=
+          std::numeric_limits<uint64_t>::max();
+  supported.throttle_from_residency =
+      driver_call_result_success && !supported.throttle_status &&
+      gpu_metrics.accumulation_counter !=
+          std::numeric_limits<uint64_t>::max();
+  supported.throttle_status =
+      supported.throttle_status || supported.throttle_from_residency;
+
+  supported.vcn_xcp_stats = std::any_of(
+      std::begin(supported.xcp_metrics), std::end(supported.xcp_metrics),
+      [](const auto &engines) { return engines.vcn_activity.any(); });
+  supported.jpeg_xcp_stats = std::any_of(
+      std::begin(supported.xcp_metrics), std::end(supported.xcp_metrics),
+      [](const auto &engines) { return engines.jpeg_activity.any(); });
+  return supported;
+}
+
+/**
+ * @brief Reads the usage of every memory type a processor supports, one
+ * driver call per type.
+ *
+ * amdsmi has no call returning several memory types at once, so a processor
+ * reporting VRAM, visible VRAM and GTT costs three calls per memory read.
+ * The memory group runs on a long period (500 ms by default), where the
+ * 10 ms groups make 50 gpu_metrics calls, so reading every type at that
+ * rate is kept rather than splitting the types over several cadences.
+ * @param driver_api Driver interface used for the read.
+ * @param processor_handle The processor handle to read.
+ * @param supported Probe result; only types in memory_types are read.
+ * @param memory Destination; types whose read fails keep their value.
+ * @return AMDSMI_STATUS_SUCCESS, the status of the first failed read, or
+ * AMDSMI_STATUS_NOT_SUPPORTED when no type is supported.
+ */
+template <metrics_driver driver>
+amdsmi_status_t read_memory_usage(driver &driver_api,
+                                  amdsmi_processor_handle processor_handle,
+                                  const supported_metrics &supported,
+                                  memory_snapshot &memory) {
+  if (supported.memory_types == 0) {
+    return AMDSMI_STATUS_NOT_SUPPORTED;
+  }
+  auto driver_call_result = AMDSMI_STATUS_SUCCESS;
+  for (std::size_t type = 0; type < memory_type_count; ++type) {
+    if ((supported.memory_types & (1u << type)) == 0) {
+      continue;
+    }
+    uint64_t used;
+    auto status = driver_api.get_memory_usage(
+        processor_handle, static_cast<amdsmi_memory_type_t>(type), &used);
+    if (status == AMDSMI_STATUS_SUCCESS) {
+      memory.used[type] = used;
+    } else if (driver_call_result == AMDSMI_STATUS_SUCCESS) {
+      driver_call_result = status;
+    }
+  }
+  return driver_call_result;
+}
+
+/**
+ * @brief Reads the supported metrics of a processor into @p metrics.
+ * @tparam driver The driver interface type used to communicate with the
+ * processor.
+ * @param driver_api Driver interface used for the read.
+ * @param processor_handle The processor handle to read.
+ * @param supported Metrics the processor supports; others are left untouched.
+ * @param metrics Destination for the sampled values. Should hold the previous
+ * sample of the processor, which a throttle status derived from residency
+ * accumulators is computed against.
+ * @param xcp_layout Supported media engines to copy into @p xcp_activity.
+ * @param xcp_activity Destination for the packed engine activity; must hold
+ * xcp_layout.size() values.
+ * @param groups Metric groups to read. The GPU metrics call is skipped when
+ * only the memory group is requested.
+ * @param timestamp Optional destination for the host window around the GPU
+ * metrics call (or the memory reads, when they are the only calls) and the
+ * GPU clock counter.
+ * @param memory Optional destination for the usage of every supported memory
+ * type; without it only VRAM usage is read.
+ * @return Status of the GPU metrics call, or of the memory reads when they are
+ * the only calls made; on failure @p metrics and @p xcp_activity are untouched.
+ */
+template <metrics_driver driver>
+amdsmi_status_t read_smi_metrics(driver &driver_api,
+                                 amdsmi_processor_handle processor_handle,
+                                 const supported_metrics &supported,
+                                 smi_metrics &metrics,
+                                 const xcp_engine_layout &xcp_layout,
+                                 std::span<uint16_t> xcp_activity,
+                                 group_mask groups = all_metric_groups,
+                                 sample_timestamp *timestamp = nullptr,
+                                 memory_snapshot *memory = nullptr) {
+  auto wants = [groups](metric_group group) {
+    return (groups & group_bit(group)) != 0;
+  };
+
+  sample_timestamp stamp{};
+  auto timed = [&stamp](auto &&driver_call) {
+    stamp.host_begin_ns = host_timestamp_ns();
+    auto driver_call_result = driver_call();
+    stamp.host_end_ns = host_timestamp_ns();
+    return driver_call_result;
+  };
+
+  amdsmi_gpu_metrics_t gpu_metrics;
+  const bool read_gpu_metrics = (groups & gpu_metrics_groups) != 0;
+  if (read_gpu_metrics) {
+    auto driver_call_result = timed([&] {
+      return driver_api.get_gpu_metrics_info(processor_handle, &gpu_metrics);
+    });
+    if (driver_call_result != AMDSMI_STATUS_SUCCESS) {
+      return driver_call_result;
+    }
+    stamp.gpu_clock_counter = gpu_metrics.system_clock_counter;
+  }
+
+  auto populate_metrics = [](auto flag, const auto &source, auto &destination) {
+    if (flag)
+      destination = source;
+  };
+
+  if (wants(metric_group::memory)) {
+    uint64_t memory_usage = std::numeric_limits<uint64_t>::max();
+    auto read_memory = [&] {
+      if (memory == nullptr) {
+        return driver_api.get_memory_usage(
+            processor_handle, AMDSMI_MEM_TYPE_VRAM, &memory_usage);
+      }
+      auto driver_call_result =
+          read_memory_usage(driver_api, processor_handle, supported, *memory);
+      memory_usage = memory->used[AMDSMI_MEM_TYPE_VRAM];
+      return driver_call_result;
+    };
+    auto driver_call_result =
+        read_gpu_metrics ? read_memory() : timed(read_memory);
+    if (driver_call_result != AMDSMI_STATUS_SUCCESS) {
+      if (!read_gpu_metrics) {
+        return driver_call_result;
+      }
+      std::cout << "Failed to read SMI data! AMD SMI Error code: "
+                << driver_call_result << std::endl;
+    }
+    populate_metrics(supported.memory_usage, memory_usage,
+                     metrics.memory_usage);
+  }
+
+  if (wants(metric_group::power)) {
+    populate_metrics(supported.average_socket_power,
+                     gpu_metrics.average_socket_power,
+                     metrics.average_socket_power);
+    populate_metrics(supported.current_socket_power,
+                     gpu_metrics.current_socket_power,
+                     metrics.current_socket_power);
+  }
+  if (wants(metric_group::activity)) {
+    populate_metrics(supported.gfx_activity, gpu_metrics.average_gfx_activity,
+                     metrics.gfx_activity);
+    populate_metrics(supported.umc_activity, gpu_metrics.average_umc_activity,
+                     metrics.umc_activity);
+    populate_metrics(supported.mm_activity, gpu_metrics.average_mm_activity,
+                     metrics.mm_activity);
+  }
+  if (wants(metric_group::thermal)) {
+    populate_metrics(supported.edge_temperature, gpu_metrics.temperature_edge,
+                     metrics.edge_temperature);
+    populate_metrics(supported.hotspot_temperature,
+                     gpu_metrics.temperature_hotspot,
+                     metrics.hotspot_temperature);
+  }
+  if (wants(metric_group::clocks)) {
+    populate_metrics(supported.gfx_clock, current_gfx_clock(gpu_metrics),
+                     metrics.gfx_clock);
+    populate_metrics(supported.memory_clock, gpu_metrics.current_uclk,
+                     metrics.memory_clock);
+    if (supported.throttle_from_residency) {
+      auto residency = read_throttle_residency(gpu_metrics);
+      metrics.throttle_status = residency_throttle_status(
+          metrics.residency, residency, metrics.throttle_status);
+      metrics.residency = residency;
+    } else {
+      populate_metrics(supported.throttle_status,
+                       gpu_metrics.indep_throttle_status,
+                       metrics.throttle_status);
+    }
+  }
+  if (wants(metric_group::xcp_engines)) {
+    xcp_layout.gather(gpu_metrics, xcp_activity);
+  }
+  if (timestamp != nullptr) {
+    *timestamp = stamp;
+  }
+
+  return AMDSMI_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Reads the supported scalar metrics of a processor into @p metrics.
+ * @return Status of the GPU metrics call; on failure @p metrics is untouched.
+ */
+template <metrics_driver driver>
+amdsmi_status_t read_smi_metrics(driver &driver_api,
+                                 amdsmi_processor_handle processor_handle,
+                                 const supported_metrics &supported,
+                                 smi_metrics &metrics) {
+  return read_smi_metrics(driver_api, processor_handle, supported, metrics,
+                          xcp_engine_layout{}, {});
+}
+
 /**
  * @class processor
  * @tparam driver The driver interface type used to communicate with the
@@ -112,128 +786,34 @@ static std::string bitset_to_index_list(const BitsetT &bs) {
  * @brief Encapsulates operations for a single AMD SMI processor.
  *
  * The processor class provides methods to query processor type, power
- * information, and temperature metrics. It is constructed with a shared pointer
- * to a driver, a processor handle, and the processor type.
+ * information, and temperature metrics. It is constructed with a driver
+ * binding, a processor handle, and the processor type.
  */
 template <typename driver> struct processor {
   /**
    * @brief Constructs a processor object.
-   * @param _driver Shared pointer to the driver interface.
+   * @param _driver Binding to the driver interface.
    * @param handle The processor handle.
    * @param processor_type The type of the processor.
    */
-  processor(std::shared_ptr<driver> _driver, amdsmi_processor_handle handle,
+  processor(driver_binding<driver> _driver, amdsmi_processor_handle handle,
             processor_type_t processor_type)
       : m_driver_api{_driver}, m_processor_handle{handle},
         m_processor_type{processor_type} {}
 
+  /**
+   * @brief Returns the metrics supported by this processor.
+   *
+   * The driver is probed on the first call only; later calls return the
+   * cached result.
+   */
   supported_metrics get_supported_metrics() {
-    static auto fetch_supported_metrics = [&] {
-      amdsmi_power_info_t socker_power_info;
-      auto driver_call_result_success =
-          m_driver_api->get_power_info(
-              m_processor_handle, &socker_power_info) == AMDSMI_STATUS_SUCCESS;
-
-      m_supported_metrics.average_socket_power =
-          driver_call_result_success &&
-          socker_power_info.average_socket_power != metric_value_not_supported;
-      m_supported_metrics.current_socket_power =
-          driver_call_result_success &&
-          socker_power_info.current_socket_power != metric_value_not_supported;
-
-      amdsmi_engine_usage_t info;
-      driver_call_result_success =
-          m_driver_api->get_gpu_activity(m_processor_handle, &info) ==
-          AMDSMI_STATUS_SUCCESS;
-      ;
-      m_supported_metrics.gfx_activity = driver_call_result_success;
-      m_supported_metrics.mm_activity = driver_call_result_success;
-      m_supported_metrics.umc_activity = driver_call_result_success;
-
-      uint64_t memory_usage;
-      driver_call_result_success = m_driver_api->get_memory_usage(
-                                       m_processor_handle, AMDSMI_MEM_TYPE_VRAM,
-                                       &memory_usage) == AMDSMI_STATUS_SUCCESS;
-      m_supported_metrics.memory_usage = driver_call_result_success;
-
-      int64_t temperature;
-      driver_call_result_success =
-          m_driver_api->get_temperature_metric(
-              m_processor_handle, AMDSMI_TEMPERATURE_TYPE_HOTSPOT,
-              AMDSMI_TEMP_CURRENT, &temperature) == AMDSMI_STATUS_SUCCESS;
-      m_supported_metrics.hotspot_temperature =
-          driver_call_result_success &&
-          temperature != metric_value_not_supported;
-
-      driver_call_result_success =
-          m_driver_api->get_temperature_metric(
-              m_processor_handle, AMDSMI_TEMPERATURE_TYPE_EDGE,
-              AMDSMI_TEMP_CURRENT, &temperature) == AMDSMI_STATUS_SUCCESS;
-      m_supported_metrics.edge_temperature =
-          driver_call_result_success &&
-          temperature != metric_value_not_supported;
-
-      amdsmi_gpu_metrics_t gpu_metrics;
-      driver_call_result_success =
-          m_driver_api->get_gpu_metrics_info(
-              m_processor_handle, &gpu_metrics) == AMDSMI_STATUS_SUCCESS;
-      std::for_each(
-          std::begin(gpu_metrics.xcp_stats), std::end(gpu_metrics.xcp_stats),
-          [&,
-           xcp_index = 0](const amdsmi_gpu_xcp_metrics_t &xcp_stats) mutable {
-            std::for_each(
-                std::begin(xcp_stats.jpeg_busy), std::end(xcp_stats.jpeg_busy),
-                [&, index = 0](const auto &engine_busy_value) mutable {
-                  m_supported_metrics.xcp_metrics[xcp_index]
-                      .jpeg_activity[index++] =
-                      driver_call_result_success &&
-                      engine_busy_value != metric_value_not_supported;
-                });
-            std::for_each(
-                std::begin(xcp_stats.vcn_busy), std::end(xcp_stats.vcn_busy),
-                [&, index = 0](const auto &engine_busy_value) mutable {
-                  m_supported_metrics.xcp_metrics[xcp_index]
-                      .vcn_activity[index++] =
-                      driver_call_result_success &&
-                      engine_busy_value != metric_value_not_supported;
-                });
-            xcp_index++;
-          });
-      // std::for_each(std::begin(gpu_metrics.jpeg_activity),
-      //               std::end(gpu_metrics.jpeg_activity),
-      //               [&, index = 0](const auto val) mutable {
-      //                 m_supported_metrics.jpeg_activity_engine[index++] =
-      //                     driver_call_result == AMDSMI_STATUS_SUCCESS &&
-      //                     val != metric_value_not_supported;
-      //               });
-
-      m_supported_metrics.jpeg_xcp_stats = std::any_of(
-          std::begin(gpu_metrics.xcp_stats), std::end(gpu_metrics.xcp_stats),
-          [](const amdsmi_gpu_xcp_metrics_t &xcp_stats) {
-            return std::any_of(std::begin(xcp_stats.jpeg_busy),
-                               std::end(xcp_stats.jpeg_busy),
-                               [index = 0](const auto &item) mutable {
-                                 std::cout << std::dec << index++
-                                           << ". XCP JPEG Engine " << std::hex
-                                           << item << std::endl;
-                                 return item != metric_value_not_supported;
-                               });
-          });
-      m_supported_metrics.vcn_xcp_stats = std::any_of(
-          std::begin(gpu_metrics.xcp_stats), std::end(gpu_metrics.xcp_stats),
-          [&](const amdsmi_gpu_xcp_metrics_t &xcp_stats) {
-            return std::any_of(
-                std::begin(xcp_stats.vcn_busy), std::end(xcp_stats.vcn_busy),
-                [&, index = 0](const auto &item) mutable {
-                  std::cout << std::dec << index++ << ". XCP VCN Engine "
-                            << std::hex << item << ", VCN Engine"
-                            << gpu_metrics.vcn_activity[0] << std::endl;
-                  return item != metric_value_not_supported;
-                });
-          });
-      return true;
-    }();
-
+    if (!m_supported_metrics_probed) {
+      m_supported_metrics =
+          probe_supported_metrics(*m_driver_api, m_processor_handle);
+      m_xcp_layout = xcp_engine_layout{m_supported_metrics};
+      m_supported_metrics_probed = true;
+    }
     return m_supported_metrics;
   }
 
@@ -243,54 +823,46 @@ template <typename driver> struct processor {
    */
   processor_type_t get_processor_type() { return m_processor_type; }
 
-  smi_metrics get_smi_metrics() {
-    amdsmi_gpu_metrics_t gpu_metrics;
+  /**
+   * @brief Returns the handle of the processor.
+   * @return The processor handle.
+   */
+  amdsmi_processor_handle get_processor_handle() { return m_processor_handle; }
+
+  /**
+   * @brief Returns the packing of the supported XCP media engines.
+   * @note Empty until get_supported_metrics() has probed the processor.
+   */
+  const xcp_engine_layout &get_xcp_engine_layout() { return m_xcp_layout; }
+
+  smi_metrics get_smi_metrics() { return get_smi_metrics({}); }
+
+  /**
+   * @brief Reads the supported metrics and the packed XCP engine activity.
+   * @param xcp_activity Destination for get_xcp_engine_layout().size()
+   * activity values, or empty to skip the engines.
+   * @param timestamp Optional destination for when the sample was taken.
+   * @throws std::invalid_argument if @p xcp_activity is too small.
+   * @throws std::runtime_error if the GPU metrics cannot be read.
+   */
+  smi_metrics get_smi_metrics(std::span<uint16_t> xcp_activity,
+                              sample_timestamp *timestamp = nullptr) {
+    static const xcp_engine_layout no_engines{};
+    if (!xcp_activity.empty() && xcp_activity.size() < m_xcp_layout.size()) {
+      throw std::invalid_argument("XCP activity buffer is too small!");
+    }
+    const auto &layout = xcp_activity.empty() ? no_engines : m_xcp_layout;
+
+    smi_metrics metrics = m_last_metrics;
     auto driver_call_result =
-        m_driver_api->get_gpu_metrics_info(m_processor_handle, &gpu_metrics);
+        read_smi_metrics(*m_driver_api, m_processor_handle,
+                         m_supported_metrics, metrics, layout, xcp_activity,
+                         all_metric_groups, timestamp);
     if (driver_call_result != AMDSMI_STATUS_SUCCESS) {
       throw std::runtime_error("Failed to read SMI data! AMD SMI Error code: " +
                                std::to_string(driver_call_result));
     }
-
-    uint64_t memory_usage = std::numeric_limits<uint64_t>::max();
-    driver_call_result = m_driver_api->get_gpu_memory_usage(
-        m_processor_handle, AMDSMI_MEM_TYPE_VRAM, &memory_usage);
-    if (driver_call_result != AMDSMI_STATUS_SUCCESS) {
-      std::cout << "Failed to read SMI data! AMD SMI Error code: "
-                << driver_call_result << std::endl;
-    }
-
-    auto populate_metrics = [](auto flag, const auto &source,
-                               auto &destination) {
-      if (flag)
-        destination = source;
-    };
-
-    smi_metrics metrics;
-
-    populate_metrics(m_supported_metrics.average_socket_power,
-                     gpu_metrics.average_socket_power,
-                     metrics.average_socket_power);
-    populate_metrics(m_supported_metrics.current_socket_power,
-                     gpu_metrics.current_socket_power,
-                     metrics.current_socket_power);
-    populate_metrics(m_supported_metrics.memory_usage, memory_usage,
-                     metrics.memory_usage);
-    populate_metrics(m_supported_metrics.gfx_activity,
-                     gpu_metrics.average_gfx_activity, metrics.gfx_activity);
-    populate_metrics(m_supported_metrics.umc_activity,
-                     gpu_metrics.average_umc_activity, metrics.umc_activity);
-    populate_metrics(m_supported_metrics.mm_activity,
-                     gpu_metrics.average_mm_activity, metrics.mm_activity);
-    populate_metrics(m_supported_metrics.edge_temperature,
-                     gpu_metrics.temperature_edge, metrics.edge_temperature);
-    populate_metrics(m_supported_metrics.hotspot_temperature,
-                     gpu_metrics.temperature_hotspot,
-                     metrics.hotspot_temperature);
-
-    // uint32_t vcn_activity  : 1;
-    // uint32_t jpeg_activity : 1;
-
+    m_last_metrics = metrics;
     return metrics;
   }
 
@@ -321,6 +893,13 @@ template <typename driver> struct processor {
     std::cout << "  " << std::setw(25) << "mm_activity"
               << ": " << (bool)metrics.mm_activity << '\n';
 
+    std::cout << "  " << std::setw(25) << "gfx_clock"
+              << ": " << (bool)metrics.gfx_clock << '\n';
+    std::cout << "  " << std::setw(25) << "memory_clock"
+              << ": " << (bool)metrics.memory_clock << '\n';
+    std::cout << "  " << std::setw(25) << "throttle_status"
+              << ": " << (bool)metrics.throttle_status << '\n';
+
     std::cout << "  " << std::setw(25) << "vcn_xcp_stats" << ": "
               << (bool)metrics.vcn_xcp_stats << '\n';
     std::for_each(
@@ -339,8 +918,11 @@ template <typename driver> struct processor {
   }
 
 private:
-  supported_metrics m_supported_metrics;
-  std::shared_ptr<driver> m_driver_api;
+  supported_metrics m_supported_metrics{};
+  xcp_engine_layout m_xcp_layout{};
+  bool m_supported_metrics_probed{false};
+  smi_metrics m_last_metrics{}; ///< Baseline of the next read
+  [[no_unique_address]] driver_binding<driver> m_driver_api;
   amdsmi_processor_handle m_processor_handle;
   processor_type_t m_processor_type;
 };
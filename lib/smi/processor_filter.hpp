@@ -0,0 +1,120 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <cstdint>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Returns the driver init flag that brings up processors of @p type.
+ */
+constexpr uint64_t processor_type_init_flag(processor_type_t type) {
+  switch (type) {
+  case AMDSMI_PROCESSOR_TYPE_AMD_GPU:
+    return AMDSMI_INIT_AMD_GPUS;
+  case AMDSMI_PROCESSOR_TYPE_AMD_CPU:
+  case AMDSMI_PROCESSOR_TYPE_AMD_CPU_CORE:
+    return AMDSMI_INIT_AMD_CPUS;
+  case AMDSMI_PROCESSOR_TYPE_NON_AMD_GPU:
+    return AMDSMI_INIT_NON_AMD_GPUS;
+  case AMDSMI_PROCESSOR_TYPE_NON_AMD_CPU:
+    return AMDSMI_INIT_NON_AMD_CPUS;
+  case AMDSMI_PROCESSOR_TYPE_AMD_APU:
+    return AMDSMI_INIT_AMD_APUS;
+  default:
+    return AMDSMI_INIT_ALL_PROCESSORS;
+  }
+}
+
+/**
+ * @struct processor_filter
+ * @brief Selects the processors enumerated by the service.
+ *
+ * An empty list accepts everything. Sockets are indexed in driver order;
+ * devices are indexed per processor type across all sockets, so device 1
+ * of type GPU is the second GPU found. Rejected processors are never added
+ * to a processor table and therefore never probed or sampled.
+ */
+struct processor_filter {
+  std::vector<processor_type_t> types{}; ///< Accepted processor types.
+  std::vector<uint32_t> sockets{};       ///< Accepted socket indices.
+  std::vector<uint32_t> devices{};       ///< Accepted per-type device indices.
+
+  /** @brief Filter accepting only AMD GPUs, the processors we sample. */
+  static processor_filter amd_gpus() {
+    return {.types = {AMDSMI_PROCESSOR_TYPE_AMD_GPU}};
+  }
+
+  /** @brief True if processors on socket @p socket may be accepted. */
+  bool accepts_socket(uint32_t socket) const {
+    return contains(sockets, socket);
+  }
+
+  /** @brief True if processors of @p type may be accepted. */
+  bool accepts_type(processor_type_t type) const {
+    return contains(types, type);
+  }
+
+  /**
+   * @brief True if the @p device-th processor of @p type is accepted.
+   */
+  bool accepts(processor_type_t type, uint32_t device) const {
+    return accepts_type(type) && contains(devices, device);
+  }
+
+  /**
+   * @brief Driver init flags covering the accepted types.
+   * @return AMDSMI_INIT_ALL_PROCESSORS when every type is accepted.
+   */
+  uint64_t init_flags() const {
+    if (types.empty()) {
+      return AMDSMI_INIT_ALL_PROCESSORS;
+    }
+    uint64_t flags{0};
+    for (auto type : types) {
+      flags |= processor_type_init_flag(type);
+    }
+    return flags;
+  }
+
+private:
+  template <typename value_t>
+  static bool contains(const std::vector<value_t> &accepted, value_t value) {
+    return accepted.empty() ||
+           std::find(accepted.begin(), accepted.end(), value) != accepted.end();
+  }
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
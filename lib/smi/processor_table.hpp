@@ -0,0 +1,529 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/driver.hpp"
+#include "smi/processor.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Default identity of a processor: the bits of its handle.
+ */
+inline uint64_t handle_identity(amdsmi_processor_handle handle) {
+  uint64_t identity{0};
+  std::memcpy(&identity, &handle, std::min(sizeof(identity), sizeof(handle)));
+  return identity;
+}
+
+/**
+ * @struct discovered_processor
+ * @brief One processor found by an enumeration pass.
+ */
+struct discovered_processor {
+  amdsmi_processor_handle handle;
+  processor_type_t type;
+  uint64_t identity; ///< Stable across re-enumerations (e.g. PCI address)
+};
+
+/**
+ * @struct enumeration_diff
+ * @brief Rows changed by processor_table::reconcile().
+ */
+struct enumeration_diff {
+  std::vector<std::size_t> added;   ///< New or returning rows, now probed
+  std::vector<std::size_t> retired; ///< Rows whose processor vanished
+  std::vector<std::size_t> rebound; ///< Known rows with a new handle
+
+  bool empty() const {
+    return added.empty() && retired.empty() && rebound.empty();
+  }
+};
+
+/**
+ * @struct row_read
+ * @brief Self-contained copy of one row's read, for running the driver call
+ * away from the table.
+ *
+ * processor_table::prepare_read() copies in everything the call needs,
+ * perform_read() touches only this struct and the driver, and
+ * commit_read() copies the result back into the table.
+ */
+struct row_read {
+  amdsmi_processor_handle handle{};
+  supported_metrics supported{};
+  xcp_engine_layout xcp_layout{};
+  smi_metrics sample{};                 ///< Starts as the row's latest sample
+  memory_snapshot memory{};             ///< Starts as the row's memory
+  std::vector<uint16_t> xcp_activity{}; ///< Starts as the row's activity
+  sample_timestamp timestamp{};
+  group_mask groups{0};
+  amdsmi_status_t status{AMDSMI_STATUS_NO_DATA};
+};
+
+/**
+ * @brief Most processes processor_table::read_processes() lists for one
+ * processor; bounds the buffer when the driver keeps asking for more.
+ */
+constexpr std::size_t max_listed_processes = 1 << 16;
+
+/**
+ * @class processor_table
+ * @tparam driver The driver interface type used to communicate with the
+ * processors.
+ * @brief Flat, structure-of-arrays table of all enumerated processors.
+ *
+ * Row i of every column describes the same processor. Hot columns (handles,
+ * capability masks, latest samples and read statuses) are kept in separate
+ * dense arrays so sampling and aggregation are linear scans. The full
+ * supported_metrics probe result is kept in a cold column and only consulted
+ * while reading a row. A single driver binding is shared by all rows.
+ *
+ * Per-XCP media engine activity of all rows is packed back to back into one
+ * flat array; each row only owns the slots of the engines it supports.
+ *
+ * Rows are never removed, so row indices stay valid for every structure
+ * indexed by them. A processor that vanishes on re-enumeration is retired
+ * (its capabilities are cleared) and its row is reused if a processor with
+ * the same identity comes back.
+ */
+template <typename driver> struct processor_table {
+  /**
+   * @brief Constructs an empty table bound to a driver.
+   * @param driver_api Binding to the driver interface.
+   */
+  explicit processor_table(driver_binding<driver> driver_api)
+      : m_driver_api{std::move(driver_api)} {}
+
+  /**
+   * @brief Appends a processor row identified by its handle.
+   * @param handle The processor handle.
+   * @param processor_type The type of the processor.
+   */
+  void add(amdsmi_processor_handle handle, processor_type_t processor_type) {
+    add(handle, processor_type, handle_identity(handle));
+  }
+
+  /**
+   * @brief Appends a processor row. Capabilities stay empty until probe().
+   * @param handle The processor handle.
+   * @param processor_type The type of the processor.
+   * @param identity Stable identity used by reconcile().
+   */
+  void add(amdsmi_processor_handle handle, processor_type_t processor_type,
+           uint64_t identity) {
+    m_rows_by_identity[identity] = m_handles.size();
+    m_identities.push_back(identity);
+    m_retired.push_back(0);
+    m_handles.push_back(handle);
+    m_types.push_back(processor_type);
+    m_capabilities.push_back(0);
+    m_samples.push_back(smi_metrics{});
+    m_statuses.push_back(AMDSMI_STATUS_NO_DATA);
+    m_timestamps.push_back(sample_timestamp{});
+    m_memory.push_back(memory_snapshot{});
+    m_supported_metrics.push_back(supported_metrics{});
+    m_xcp_layouts.emplace_back();
+    m_xcp_offsets.push_back(m_xcp_offsets.back());
+  }
+
+  /**
+   * @brief Returns the number of processors in the table.
+   */
+  std::size_t size() const { return m_handles.size(); }
+
+  /**
+   * @brief Probes the supported metrics of every processor.
+   *
+   * Only GPU rows are probed; other processor types keep an empty capability
+   * mask and are skipped by sample().
+   */
+  void probe() {
+    for (std::size_t index = 0; index < size(); ++index) {
+      probe_row(index);
+    }
+    rebuild_xcp_storage();
+  }
+
+  /**
+   * @brief Applies a fresh enumeration by processor identity.
+   *
+   * Only processors not currently in the table are probed. Known processors
+   * keep their probe result and latest sample; if their handle changed (for
+   * example after a GPU reset) only the handle is replaced. Processors that
+   * are no longer enumerated are retired.
+   * @param discovered Every processor found by the enumeration.
+   * @return The rows that changed.
+   */
+  enumeration_diff reconcile(std::span<const discovered_processor> discovered) {
+    enumeration_diff diff;
+    std::vector<uint8_t> seen(size(), 0);
+    for (const auto &current : discovered) {
+      auto found = m_rows_by_identity.find(current.identity);
+      if (found == m_rows_by_identity.end()) {
+        add(current.handle, current.type, current.identity);
+        seen.push_back(1);
+        probe_row(size() - 1);
+        diff.added.push_back(size() - 1);
+        continue;
+      }
+
+      auto index = found->second;
+      seen[index] = 1;
+      if (m_retired[index]) {
+        m_retired[index] = 0;
+        m_handles[index] = current.handle;
+        m_types[index] = current.type;
+        probe_row(index);
+        diff.added.push_back(index);
+      } else if (m_handles[index] != current.handle) {
+        m_handles[index] = current.handle;
+        diff.rebound.push_back(index);
+      }
+    }
+
+    for (std::size_t index = 0; index < seen.size(); ++index) {
+      if (!seen[index] && !m_retired[index]) {
+        retire_row(index);
+        diff.retired.push_back(index);
+      }
+    }
+    if (!diff.added.empty() || !diff.retired.empty()) {
+      rebuild_xcp_storage();
+    }
+    return diff;
+  }
+
+  /**
+   * @brief Reads the latest metrics of every processor with capabilities.
+   * @return Number of rows that were read successfully.
+   * @note A failed read leaves the previous sample in place and records the
+   * driver status for that row.
+   */
+  std::size_t sample() {
+    std::size_t succeeded{0};
+    for (std::size_t index = 0; index < size(); ++index) {
+      if (m_capabilities[index] == 0) {
+        continue;
+      }
+      succeeded +=
+          sample_row(index, all_metric_groups) == AMDSMI_STATUS_SUCCESS;
+    }
+    return succeeded;
+  }
+
+  /**
+   * @brief Reads selected metric groups of one processor.
+   * @param index Row index.
+   * @param groups Metric groups to refresh; other fields keep their values.
+   * @return Status of the read, also recorded in statuses().
+   */
+  amdsmi_status_t sample_row(std::size_t index, group_mask groups) {
+    m_statuses[index] = read_smi_metrics(
+        *m_driver_api, m_handles[index], m_supported_metrics[index],
+        m_samples[index], m_xcp_layouts[index], xcp_activity_data(index),
+        groups, &m_timestamps[index], &m_memory[index]);
+    return m_statuses[index];
+  }
+
+  /**
+   * @brief Copies what a read of selected metric groups of one row needs.
+   * @param index Row index.
+   * @param groups Metric groups to refresh.
+   * @param request Reused between reads to keep its allocation.
+   */
+  void prepare_read(std::size_t index, group_mask groups,
+                    row_read &request) const {
+    request.handle = m_handles[index];
+    request.supported = m_supported_metrics[index];
+    request.xcp_layout = m_xcp_layouts[index];
+    request.sample = m_samples[index];
+    request.memory = m_memory[index];
+    auto activity = xcp_activity(index);
+    request.xcp_activity.assign(activity.begin(), activity.end());
+    request.timestamp = m_timestamps[index];
+    request.groups = groups;
+    request.status = AMDSMI_STATUS_NO_DATA;
+  }
+
+  /**
+   * @brief Issues the driver calls of a prepared read.
+   *
+   * Touches no table state, so it may run on any thread while the table is
+   * used elsewhere.
+   */
+  amdsmi_status_t perform_read(row_read &request) const {
+    return perform_read(m_driver_api, request);
+  }
+
+  /**
+   * @brief Issues the driver calls of a prepared read through @p driver_api.
+   *
+   * Needs no table at all, so a reader holding its own copy of the binding
+   * (see driver_api()) can finish a call that outlives the table.
+   */
+  static amdsmi_status_t perform_read(const driver_binding<driver> &driver_api,
+                                      row_read &request) {
+    request.status = read_smi_metrics(
+        *driver_api, request.handle, request.supported, request.sample,
+        request.xcp_layout, request.xcp_activity, request.groups,
+        &request.timestamp, &request.memory);
+    return request.status;
+  }
+
+  /** @brief Binding to the driver the table reads through. */
+  const driver_binding<driver> &driver_api() const { return m_driver_api; }
+
+  /**
+   * @brief Stores the result of a performed read in its row.
+   *
+   * Like sample_row(), a failed read only records its status.
+   */
+  void commit_read(std::size_t index, const row_read &request) {
+    m_statuses[index] = request.status;
+    if (request.status != AMDSMI_STATUS_SUCCESS) {
+      return;
+    }
+    m_samples[index] = request.sample;
+    m_memory[index] = request.memory;
+    m_timestamps[index] = request.timestamp;
+    auto activity = xcp_activity_data(index);
+    if (activity.size() == request.xcp_activity.size()) {
+      std::copy(request.xcp_activity.begin(), request.xcp_activity.end(),
+                activity.begin());
+    }
+  }
+
+  /**
+   * @brief Records that a row's read did not complete in time.
+   *
+   * The previous sample stays in place; the status becomes
+   * AMDSMI_STATUS_TIMEOUT so the row is skipped for this round.
+   */
+  void mark_missing(std::size_t index) {
+    m_statuses[index] = AMDSMI_STATUS_TIMEOUT;
+  }
+
+  /**
+   * @brief Lists the processes using one processor.
+   * @param index Row index.
+   * @param processes Receives the list; reused between calls to keep its
+   * allocation, and grown when the driver reports more processes, up to
+   * max_listed_processes.
+   * @return Status of the driver call, or AMDSMI_STATUS_OUT_OF_RESOURCES
+   * with an empty list when the driver still wants more at the limit.
+   */
+  amdsmi_status_t read_processes(std::size_t index,
+                                 std::vector<amdsmi_proc_info_t> &processes)
+      const
+    requires process_driver<driver>
+  {
+    if (processes.capacity() < 16) {
+      processes.reserve(16);
+    }
+    for (;;) {
+      processes.resize(processes.capacity());
+      auto count = static_cast<uint32_t>(processes.size());
+      auto status = m_driver_api->get_process_list(m_handles[index], &count,
+                                                   processes.data());
+      if (status == AMDSMI_STATUS_OUT_OF_RESOURCES ||
+          (status == AMDSMI_STATUS_SUCCESS && count > processes.size())) {
+        if (processes.size() >= max_listed_processes) {
+          processes.clear();
+          return AMDSMI_STATUS_OUT_OF_RESOURCES;
+        }
+        processes.reserve(std::min<std::size_t>(
+            std::max<std::size_t>(count, 2 * processes.size()),
+            max_listed_processes));
+        continue;
+      }
+      processes.resize(status == AMDSMI_STATUS_SUCCESS ? count : 0);
+      return status;
+    }
+  }
+
+  /** @brief Stable processor identities, one per row. */
+  std::span<const uint64_t> identities() const { return m_identities; }
+
+  /** @brief Whether a row's processor vanished on re-enumeration. */
+  bool retired(std::size_t index) const { return m_retired[index] != 0; }
+
+  /** @brief Processor handles, one per row. */
+  std::span<const amdsmi_processor_handle> handles() const {
+    return m_handles;
+  }
+
+  /** @brief Processor types, one per row. */
+  std::span<const processor_type_t> types() const { return m_types; }
+
+  /** @brief Capability masks, one per row. */
+  std::span<const capability_mask> capabilities() const {
+    return m_capabilities;
+  }
+
+  /** @brief Latest samples, one per row. */
+  std::span<const smi_metrics> samples() const { return m_samples; }
+
+  /** @brief Status of the latest read, one per row. */
+  std::span<const amdsmi_status_t> statuses() const { return m_statuses; }
+
+  /** @brief When the latest successful read was taken, one per row. */
+  std::span<const sample_timestamp> timestamps() const {
+    return m_timestamps;
+  }
+
+  /**
+   * @brief Usage and size of every memory type, one per row.
+   *
+   * Usage is as of the latest successful read of the memory group.
+   */
+  std::span<const memory_snapshot> memory() const { return m_memory; }
+
+  /**
+   * @brief Latest packed XCP media engine activity of a row.
+   * @param index Row index.
+   */
+  std::span<const uint16_t> xcp_activity(std::size_t index) const {
+    return {m_xcp_activity.data() + m_xcp_offsets[index],
+            m_xcp_offsets[index + 1] - m_xcp_offsets[index]};
+  }
+
+  /**
+   * @brief Engines described by the packed activity of a row.
+   * @param index Row index.
+   */
+  const xcp_engine_layout &get_xcp_engine_layout(std::size_t index) const {
+    return m_xcp_layouts[index];
+  }
+
+  /**
+   * @brief Returns the full probe result of a row.
+   * @param index Row index.
+   */
+  const supported_metrics &get_supported_metrics(std::size_t index) const {
+    return m_supported_metrics[index];
+  }
+
+private:
+  void probe_row(std::size_t index) {
+    if (m_types[index] != AMDSMI_PROCESSOR_TYPE_AMD_GPU) {
+      return;
+    }
+    m_supported_metrics[index] =
+        probe_supported_metrics(*m_driver_api, m_handles[index]);
+    m_capabilities[index] = to_capability_mask(m_supported_metrics[index]);
+    m_xcp_layouts[index] = xcp_engine_layout{m_supported_metrics[index]};
+    m_samples[index] = smi_metrics{};
+    m_statuses[index] = AMDSMI_STATUS_NO_DATA;
+    probe_memory_totals(index);
+  }
+
+  void probe_memory_totals(std::size_t index) {
+    auto &memory = m_memory[index];
+    memory = memory_snapshot{};
+    if constexpr (memory_total_driver<driver>) {
+      auto types = m_supported_metrics[index].memory_types;
+      for (std::size_t type = 0; type < memory_type_count; ++type) {
+        uint64_t total;
+        if ((types & (1u << type)) != 0 &&
+            m_driver_api->get_memory_total(
+                m_handles[index], static_cast<amdsmi_memory_type_t>(type),
+                &total) == AMDSMI_STATUS_SUCCESS) {
+          memory.total[type] = total;
+        }
+      }
+    }
+  }
+
+  void retire_row(std::size_t index) {
+    m_retired[index] = 1;
+    m_capabilities[index] = 0;
+    m_statuses[index] = AMDSMI_STATUS_NO_DATA;
+    m_supported_metrics[index] = supported_metrics{};
+    m_memory[index] = memory_snapshot{};
+    m_xcp_layouts[index] = xcp_engine_layout{};
+  }
+
+  /**
+   * @brief Recomputes the packing of XCP activity, keeping the values of
+   * rows whose layout did not change size.
+   */
+  void rebuild_xcp_storage() {
+    std::vector<std::size_t> offsets(size() + 1, 0);
+    for (std::size_t index = 0; index < size(); ++index) {
+      offsets[index + 1] = offsets[index] + m_xcp_layouts[index].size();
+    }
+    std::vector<uint16_t> activity(offsets.back(), 0);
+    for (std::size_t index = 0; index + 1 < m_xcp_offsets.size(); ++index) {
+      auto length = m_xcp_offsets[index + 1] - m_xcp_offsets[index];
+      if (length == offsets[index + 1] - offsets[index]) {
+        std::copy_n(m_xcp_activity.begin() + m_xcp_offsets[index], length,
+                    activity.begin() + offsets[index]);
+      }
+    }
+    m_xcp_offsets = std::move(offsets);
+    m_xcp_activity = std::move(activity);
+  }
+
+  std::span<uint16_t> xcp_activity_data(std::size_t index) {
+    return {m_xcp_activity.data() + m_xcp_offsets[index],
+            m_xcp_offsets[index + 1] - m_xcp_offsets[index]};
+  }
+
+  [[no_unique_address]] driver_binding<driver> m_driver_api;
+  std::unordered_map<uint64_t, std::size_t> m_rows_by_identity;
+  std::vector<uint64_t> m_identities;
+  std::vector<uint8_t> m_retired;
+  std::vector<amdsmi_processor_handle> m_handles;
+  std::vector<processor_type_t> m_types;
+  std::vector<capability_mask> m_capabilities;
+  std::vector<smi_metrics> m_samples;
+  std::vector<amdsmi_status_t> m_statuses;
+  std::vector<sample_timestamp> m_timestamps;
+  std::vector<memory_snapshot> m_memory;
+  std::vector<supported_metrics> m_supported_metrics;
+  std::vector<xcp_engine_layout> m_xcp_layouts;
+  std::vector<std::size_t> m_xcp_offsets{0}; ///< Row start in m_xcp_activity
+  std::vector<uint16_t> m_xcp_activity;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,265 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/derived_metrics.hpp"
+#include "smi/node_aggregate.hpp"
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sample_batch.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <cstddef>
+#include <fmt/format.h>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct exposition_family
+ * @brief Name, type and help text of one exported metric family.
+ */
+struct exposition_family {
+  std::string_view name;
+  std::string_view type;
+  std::string_view help;
+};
+
+/**
+ * @brief Prometheus family of every sample_batch column, in column order.
+ */
+inline constexpr std::array<exposition_family, metric_column_count>
+    processor_families{{
+        {"smi_current_socket_power_watts", "gauge",
+         "Current socket power of the processor."},
+        {"smi_average_socket_power_watts", "gauge",
+         "Average socket power of the processor."},
+        {"smi_memory_used_bytes", "gauge", "VRAM in use in bytes."},
+        {"smi_hotspot_temperature_celsius", "gauge", "Hotspot temperature."},
+        {"smi_edge_temperature_celsius", "gauge", "Edge temperature."},
+        {"smi_gfx_activity_percent", "gauge", "GFX engine activity."},
+        {"smi_umc_activity_percent", "gauge", "Memory controller activity."},
+        {"smi_mm_activity_percent", "gauge", "Multimedia engine activity."},
+    }};
+
+/**
+ * @class prometheus_exposition
+ * @brief Prometheus text-format page of the latest round, rendered once per
+ * round instead of once per scrape.
+ *
+ * One sample line per (metric, processor) is kept. A round re-renders only
+ * the lines of the metric groups it refreshed, for the processors read
+ * successfully, and then concatenates the lines into a new immutable page.
+ * Metrics a processor does not support get no line, and a family without
+ * any line is left out, so unsupported values are never exported.
+ * page() hands out the current page by reference count, so a scrape only
+ * copies bytes and never touches the driver or the table.
+ *
+ * Derived metrics, when passed to update(), are exported as smi_<name>
+ * gauges per processor and smi_node_<name> gauges for the node.
+ */
+class prometheus_exposition {
+public:
+  /**
+   * @brief Constructs an empty exposition for @p rows processors.
+   */
+  explicit prometheus_exposition(std::size_t rows)
+      : m_page{std::make_shared<const std::string>()} {
+    resize(rows);
+  }
+
+  /** @brief Adjusts the number of processors; new rows export nothing. */
+  void resize(std::size_t rows) {
+    m_rows = rows;
+    for (auto &lines : m_lines) {
+      lines.resize(rows);
+    }
+    for (auto &lines : m_derived_lines) {
+      lines.resize(rows);
+    }
+  }
+
+  /** @brief Stops exporting a retired processor. */
+  void remove(std::size_t row) {
+    for (auto &lines : m_lines) {
+      lines[row].clear();
+    }
+    for (auto &lines : m_derived_lines) {
+      lines[row].clear();
+    }
+  }
+
+  /**
+   * @brief Re-renders the lines refreshed by a round and publishes the page.
+   * @param table Table whose samples were just updated.
+   * @param due Groups read per row; when empty, every row was read in full.
+   * @param node Node totals as of this round.
+   * @param derived Derived metrics updated from the same round, if any.
+   */
+  template <typename driver>
+  void update(const processor_table<driver> &table,
+              std::span<const group_mask> due, const node_snapshot &node,
+              const derived_metrics *derived = nullptr) {
+    if (derived != nullptr && m_derived_lines.size() != derived->size()) {
+      m_derived_lines.assign(derived->size(),
+                             std::vector<std::string>(m_rows));
+    }
+    auto statuses = table.statuses();
+    auto capabilities = table.capabilities();
+    auto samples = table.samples();
+    auto memory = table.memory();
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      if (capabilities[row] == 0 || statuses[row] != AMDSMI_STATUS_SUCCESS) {
+        continue;
+      }
+      group_mask groups = due.empty() ? all_metric_groups : due[row];
+      for (std::size_t index = 0; index < metric_column_count; ++index) {
+        auto column = static_cast<metric_column>(index);
+        if ((groups & group_bit(column_group(column))) == 0) {
+          continue;
+        }
+        auto &line = m_lines[index][row];
+        line.clear();
+        if ((capabilities[row] & column_capability(column)) == 0) {
+          continue;
+        }
+        // smi_metrics::memory_usage wraps above 4 GiB; the snapshot does not.
+        uint64_t value = column == metric_column::memory_usage
+                             ? memory[row].used[AMDSMI_MEM_TYPE_VRAM]
+                             : metric_value(samples[row], column);
+        fmt::format_to(std::back_inserter(line), "{}{{processor=\"{}\"}} {}\n",
+                       processor_families[index].name, row, value);
+      }
+      if (derived != nullptr && groups != 0 && row < derived->rows()) {
+        render_derived(row, *derived);
+      }
+    }
+    publish(node, derived);
+  }
+
+  /**
+   * @brief Current page; safe to call from any thread.
+   */
+  std::shared_ptr<const std::string> page() const {
+    std::lock_guard lock{m_page_mutex};
+    return m_page;
+  }
+
+private:
+  void render_derived(std::size_t row, const derived_metrics &derived) {
+    auto values = derived.values(row);
+    for (std::size_t metric = 0; metric < derived.size(); ++metric) {
+      auto &line = m_derived_lines[metric][row];
+      line.clear();
+      if (!derived.supported(row, metric)) {
+        continue;
+      }
+      fmt::format_to(std::back_inserter(line),
+                     "smi_{}{{processor=\"{}\"}} {}\n",
+                     derived.definition(metric).name, row, values[metric]);
+    }
+  }
+
+  void publish(const node_snapshot &node, const derived_metrics *derived) {
+    std::string page;
+    page.reserve(m_page_size);
+    auto out = std::back_inserter(page);
+    for (std::size_t index = 0; index < metric_column_count; ++index) {
+      const auto &lines = m_lines[index];
+      if (std::all_of(lines.begin(), lines.end(),
+                      [](const auto &line) { return line.empty(); })) {
+        continue;
+      }
+      const auto &family = processor_families[index];
+      fmt::format_to(out, "# HELP {} {}\n# TYPE {} {}\n", family.name,
+                     family.help, family.name, family.type);
+      for (const auto &line : lines) {
+        page += line;
+      }
+    }
+    for (std::size_t metric = 0; derived != nullptr && metric < derived->size();
+         ++metric) {
+      const auto &lines = m_derived_lines[metric];
+      if (std::all_of(lines.begin(), lines.end(),
+                      [](const auto &line) { return line.empty(); })) {
+        continue;
+      }
+      const auto &name = derived->definition(metric).name;
+      fmt::format_to(out,
+                     "# HELP smi_{0} Derived metric {0}.\n"
+                     "# TYPE smi_{0} gauge\n",
+                     name);
+      for (const auto &line : lines) {
+        page += line;
+      }
+      fmt::format_to(out,
+                     "# HELP smi_node_{0} Node aggregate of {0}.\n"
+                     "# TYPE smi_node_{0} gauge\n"
+                     "smi_node_{0} {1}\n",
+                     name, derived->node_value(metric));
+    }
+    fmt::format_to(out,
+                   "# HELP smi_node_socket_power_watts Sum of socket power.\n"
+                   "# TYPE smi_node_socket_power_watts gauge\n"
+                   "smi_node_socket_power_watts {}\n"
+                   "# HELP smi_node_processors Processors with samples.\n"
+                   "# TYPE smi_node_processors gauge\n"
+                   "smi_node_processors {}\n"
+                   "# HELP smi_rounds_total Sampling rounds completed.\n"
+                   "# TYPE smi_rounds_total counter\n"
+                   "smi_rounds_total {}\n",
+                   node.total_socket_power, node.processor_count, node.round);
+    m_page_size = page.size();
+
+    auto published = std::make_shared<const std::string>(std::move(page));
+    std::lock_guard lock{m_page_mutex};
+    m_page.swap(published);
+  }
+
+  /** Rendered sample line per column, then per row. */
+  std::array<std::vector<std::string>, metric_column_count> m_lines;
+  /** Rendered derived metric line per metric, then per row. */
+  std::vector<std::vector<std::string>> m_derived_lines;
+  std::size_t m_rows{0};
+  std::size_t m_page_size{0}; ///< Size of the last page, to reserve once
+  mutable std::mutex m_page_mutex;
+  std::shared_ptr<const std::string> m_page;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
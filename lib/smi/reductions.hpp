@@ -0,0 +1,264 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+/**
+ * @file reductions.hpp
+ * @brief Reduction kernels over dense metric columns.
+ *
+ * The kernels are selected at compile time: AVX2 when __AVX2__ is defined,
+ * SSE4.1 when __SSE4_1__ is defined, and a portable scalar loop otherwise.
+ * The instruction set is chosen with the SMI_SIMD_LEVEL CMake option.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct column_summary
+ * @brief Sum, extremes and element count of a metric column.
+ */
+struct column_summary {
+  uint64_t sum{0};
+  uint32_t min{std::numeric_limits<uint32_t>::max()};
+  uint32_t max{0};
+  std::size_t count{0};
+
+  /** @brief Arithmetic mean, or zero for an empty column. */
+  double mean() const {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+  }
+};
+
+namespace detail {
+
+inline uint64_t scalar_sum(const uint32_t *data, std::size_t size) {
+  uint64_t sum{0};
+  for (std::size_t i = 0; i < size; ++i) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+inline uint32_t scalar_min(const uint32_t *data, std::size_t size) {
+  uint32_t min = std::numeric_limits<uint32_t>::max();
+  for (std::size_t i = 0; i < size; ++i) {
+    min = data[i] < min ? data[i] : min;
+  }
+  return min;
+}
+
+inline uint32_t scalar_max(const uint32_t *data, std::size_t size) {
+  uint32_t max{0};
+  for (std::size_t i = 0; i < size; ++i) {
+    max = data[i] > max ? data[i] : max;
+  }
+  return max;
+}
+
+inline std::size_t scalar_count_above(const uint32_t *data, std::size_t size,
+                                      uint32_t threshold) {
+  std::size_t count{0};
+  for (std::size_t i = 0; i < size; ++i) {
+    count += data[i] > threshold;
+  }
+  return count;
+}
+
+} // namespace detail
+
+/**
+ * @brief Sums a column; the result is widened to 64 bits.
+ */
+inline uint64_t column_sum(std::span<const uint32_t> column) {
+  const uint32_t *data = column.data();
+  std::size_t size = column.size();
+  std::size_t i{0};
+  uint64_t sum{0};
+#if defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 8 <= size; i += 8) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    acc = _mm256_add_epi64(
+        acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+    acc = _mm256_add_epi64(
+        acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+  }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+  sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE4_1__)
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 4 <= size; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    acc = _mm_add_epi64(acc, _mm_cvtepu32_epi64(v));
+    acc = _mm_add_epi64(acc, _mm_cvtepu32_epi64(_mm_srli_si128(v, 8)));
+  }
+  alignas(16) uint64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+  sum = lanes[0] + lanes[1];
+#endif
+  return sum + detail::scalar_sum(data + i, size - i);
+}
+
+/**
+ * @brief Returns the smallest value of a column, or UINT32_MAX if empty.
+ */
+inline uint32_t column_min(std::span<const uint32_t> column) {
+  const uint32_t *data = column.data();
+  std::size_t size = column.size();
+  std::size_t i{0};
+  uint32_t min = std::numeric_limits<uint32_t>::max();
+#if defined(__AVX2__)
+  __m256i acc = _mm256_set1_epi32(-1);
+  for (; i + 8 <= size; i += 8) {
+    acc = _mm256_min_epu32(
+        acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+  }
+  __m128i half = _mm_min_epu32(_mm256_castsi256_si128(acc),
+                               _mm256_extracti128_si256(acc, 1));
+  alignas(16) uint32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), half);
+  min = detail::scalar_min(lanes, 4);
+#elif defined(__SSE4_1__)
+  __m128i acc = _mm_set1_epi32(-1);
+  for (; i + 4 <= size; i += 4) {
+    acc = _mm_min_epu32(
+        acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+  }
+  alignas(16) uint32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+  min = detail::scalar_min(lanes, 4);
+#endif
+  uint32_t tail = detail::scalar_min(data + i, size - i);
+  return tail < min ? tail : min;
+}
+
+/**
+ * @brief Returns the largest value of a column, or zero if empty.
+ */
+inline uint32_t column_max(std::span<const uint32_t> column) {
+  const uint32_t *data = column.data();
+  std::size_t size = column.size();
+  std::size_t i{0};
+  uint32_t max{0};
+#if defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 8 <= size; i += 8) {
+    acc = _mm256_max_epu32(
+        acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+  }
+  __m128i half = _mm_max_epu32(_mm256_castsi256_si128(acc),
+                               _mm256_extracti128_si256(acc, 1));
+  alignas(16) uint32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), half);
+  max = detail::scalar_max(lanes, 4);
+#elif defined(__SSE4_1__)
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 4 <= size; i += 4) {
+    acc = _mm_max_epu32(
+        acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+  }
+  alignas(16) uint32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+  max = detail::scalar_max(lanes, 4);
+#endif
+  uint32_t tail = detail::scalar_max(data + i, size - i);
+  return tail > max ? tail : max;
+}
+
+/**
+ * @brief Returns the arithmetic mean of a column, or zero if empty.
+ */
+inline double column_mean(std::span<const uint32_t> column) {
+  return column.empty()
+             ? 0.0
+             : static_cast<double>(column_sum(column)) / column.size();
+}
+
+/**
+ * @brief Counts the values of a column strictly greater than @p threshold.
+ */
+inline std::size_t column_count_above(std::span<const uint32_t> column,
+                                      uint32_t threshold) {
+  const uint32_t *data = column.data();
+  std::size_t size = column.size();
+  std::size_t i{0};
+  std::size_t count{0};
+  // Unsigned compare through the signed instruction: flip the sign bits.
+#if defined(__AVX2__)
+  const __m256i sign = _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m256i limit = _mm256_xor_si256(
+      _mm256_set1_epi32(static_cast<int32_t>(threshold)), sign);
+  for (; i + 8 <= size; i += 8) {
+    __m256i v = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), sign);
+    auto mask = static_cast<uint32_t>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, limit))));
+    count += std::popcount(mask);
+  }
+#elif defined(__SSE4_1__)
+  const __m128i sign = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m128i limit =
+      _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(threshold)), sign);
+  for (; i + 4 <= size; i += 4) {
+    __m128i v = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), sign);
+    auto mask = static_cast<uint32_t>(
+        _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, limit))));
+    count += std::popcount(mask);
+  }
+#endif
+  return count + detail::scalar_count_above(data + i, size - i, threshold);
+}
+
+/**
+ * @brief Computes sum, extremes and count of a column.
+ */
+inline column_summary summarize_column(std::span<const uint32_t> column) {
+  column_summary summary{};
+  summary.sum = column_sum(column);
+  summary.min = column_min(column);
+  summary.max = column_max(column);
+  summary.count = column.size();
+  return summary;
+}
+
+} // namespace amd_smi
+} // namespace rocprofsys
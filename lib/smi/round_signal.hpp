@@ -0,0 +1,168 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @class round_signal
+ * @brief Wakes coroutines waiting for the next sampling round.
+ *
+ * The sampler calls publish() after each round; every coroutine suspended in
+ * co_await next_round() is then resumed, either inline on the publishing
+ * thread or through the executor given at construction (for example one
+ * that posts the handle to an event loop). Waiting costs no thread and no
+ * polling.
+ *
+ * A suspended coroutine may be destroyed from any thread until publish()
+ * takes it off the waiting list; from then on its resumption is in flight,
+ * so its frame may only be destroyed on the thread that resumes it (the
+ * executor's, or the publishing thread when there is no executor).
+ */
+class round_signal {
+public:
+  using executor = std::function<void(std::coroutine_handle<>)>;
+
+  /**
+   * @class awaiter
+   * @brief Awaitable returned by next_round(); resumes with the round number.
+   *
+   * An awaiter destroyed while suspended (for example because its coroutine
+   * frame was destroyed) unregisters itself and is never resumed, unless
+   * publish() already took it; see round_signal.
+   */
+  class awaiter {
+  public:
+    awaiter(round_signal &signal, uint64_t observed)
+        : m_signal{signal}, m_observed{observed} {}
+
+    awaiter(const awaiter &) = delete;
+    awaiter &operator=(const awaiter &) = delete;
+
+    ~awaiter() { m_signal.remove(this); }
+
+    bool await_ready() const noexcept {
+      return m_signal.round() > m_observed;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      std::lock_guard lock{m_signal.m_mutex};
+      if (m_signal.round() > m_observed) {
+        // Published between next_round() and co_await.
+        return false;
+      }
+      m_handle = handle;
+      m_registered = true;
+      m_signal.m_waiting.push_back(this);
+      return true;
+    }
+
+    uint64_t await_resume() const noexcept { return m_signal.round(); }
+
+  private:
+    friend class round_signal;
+
+    round_signal &m_signal;
+    uint64_t m_observed;
+    std::coroutine_handle<> m_handle{};
+    bool m_registered{false}; ///< Guarded by round_signal::m_mutex
+  };
+
+  /**
+   * @brief Constructs a signal.
+   * @param resume Executor for resumed coroutines; inline when empty.
+   */
+  explicit round_signal(executor resume = {}) : m_resume{std::move(resume)} {}
+
+  round_signal(const round_signal &) = delete;
+  round_signal &operator=(const round_signal &) = delete;
+
+  /**
+   * @brief Replaces the executor. Must not race with publish().
+   */
+  void set_executor(executor resume) { m_resume = std::move(resume); }
+
+  /** @brief Number of rounds published so far. */
+  uint64_t round() const { return m_round.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Returns an awaitable that completes on the next publish().
+   */
+  awaiter next_round() { return awaiter{*this, round()}; }
+
+  /**
+   * @brief Completes a round and resumes every waiting coroutine.
+   */
+  void publish() {
+    std::vector<std::coroutine_handle<>> ready;
+    {
+      std::lock_guard lock{m_mutex};
+      m_round.fetch_add(1, std::memory_order_release);
+      ready.reserve(m_waiting.size());
+      for (auto *waiting : m_waiting) {
+        waiting->m_registered = false;
+        ready.push_back(waiting->m_handle);
+      }
+      m_waiting.clear();
+    }
+    for (auto handle : ready) {
+      if (m_resume) {
+        m_resume(handle);
+      } else {
+        handle.resume();
+      }
+    }
+  }
+
+private:
+  void remove(awaiter *waiting) {
+    std::lock_guard lock{m_mutex};
+    if (waiting->m_registered) {
+      std::erase(m_waiting, waiting);
+      waiting->m_registered = false;
+    }
+  }
+
+  executor m_resume;
+  std::atomic<uint64_t> m_round{0};
+  std::mutex m_mutex;
+  std::vector<awaiter *> m_waiting;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,364 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/reductions.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Scalar metrics stored as columns in a sample_batch.
+ */
+enum class metric_column : std::size_t {
+  current_socket_power,
+  average_socket_power,
+  memory_usage,
+  hotspot_temperature,
+  edge_temperature,
+  gfx_activity,
+  umc_activity,
+  mm_activity,
+  count
+};
+
+constexpr std::size_t metric_column_count =
+    static_cast<std::size_t>(metric_column::count);
+
+/**
+ * @brief Returns the value of one scalar metric of a sample.
+ */
+inline uint32_t metric_value(const smi_metrics &metrics, metric_column column) {
+  switch (column) {
+  case metric_column::current_socket_power:
+    return metrics.current_socket_power;
+  case metric_column::average_socket_power:
+    return metrics.average_socket_power;
+  case metric_column::memory_usage:
+    return metrics.memory_usage;
+  case metric_column::hotspot_temperature:
+    return metrics.hotspot_temperature;
+  case metric_column::edge_temperature:
+    return metrics.edge_temperature;
+  case metric_column::gfx_activity:
+    return metrics.gfx_activity;
+  case metric_column::umc_activity:
+    return metrics.umc_activity;
+  case metric_column::mm_activity:
+    return metrics.mm_activity;
+  case metric_column::count:
+    break;
+  }
+  return 0;
+}
+
+/**
+ * @brief Returns the metric group that refreshes a column.
+ */
+constexpr metric_group column_group(metric_column column) {
+  switch (column) {
+  case metric_column::current_socket_power:
+  case metric_column::average_socket_power:
+    return metric_group::power;
+  case metric_column::memory_usage:
+    return metric_group::memory;
+  case metric_column::hotspot_temperature:
+  case metric_column::edge_temperature:
+    return metric_group::thermal;
+  default:
+    return metric_group::activity;
+  }
+}
+
+/**
+ * @brief Returns the capability bit that marks a column as supported.
+ */
+constexpr capability_mask column_capability(metric_column column) {
+  switch (column) {
+  case metric_column::current_socket_power:
+    return capability::current_socket_power;
+  case metric_column::average_socket_power:
+    return capability::average_socket_power;
+  case metric_column::memory_usage:
+    return capability::memory_usage;
+  case metric_column::hotspot_temperature:
+    return capability::hotspot_temperature;
+  case metric_column::edge_temperature:
+    return capability::edge_temperature;
+  case metric_column::gfx_activity:
+    return capability::gfx_activity;
+  case metric_column::umc_activity:
+    return capability::umc_activity;
+  case metric_column::mm_activity:
+    return capability::mm_activity;
+  case metric_column::count:
+    break;
+  }
+  return 0;
+}
+
+/**
+ * @brief Returns the field name of a column, as used by exporters.
+ */
+constexpr std::string_view metric_column_name(metric_column column) {
+  constexpr std::array<std::string_view, metric_column_count> names{
+      "current_socket_power", "average_socket_power", "memory_usage",
+      "hotspot_temperature",  "edge_temperature",     "gfx_activity",
+      "umc_activity",         "mm_activity",
+  };
+  auto index = static_cast<std::size_t>(column);
+  return index < names.size() ? names[index] : std::string_view{};
+}
+
+/**
+ * @class sample_batch
+ * @brief Columnar (structure-of-arrays) buffer of samples for many processors.
+ *
+ * Every scalar metric of every processor is stored as its own contiguous
+ * column of up to capacity() 32-bit values, so reductions over one metric
+ * touch only that metric's memory. Narrower fields such as temperatures are
+ * widened to 32 bits so a single set of kernels covers every column. The
+ * memory column holds VRAM usage in MiB, as byte counts of large GPUs do
+ * not fit 32 bits.
+ */
+class sample_batch {
+public:
+  /**
+   * @brief Constructs an empty batch.
+   * @param processor_count Number of processors (rows of the table).
+   * @param capacity Maximum number of samples kept per processor.
+   */
+  sample_batch(std::size_t processor_count, std::size_t capacity)
+      : m_processor_count{processor_count}, m_capacity{capacity},
+        m_sizes(processor_count, 0),
+        m_data(processor_count * metric_column_count * capacity, 0),
+        m_scratch(processor_count, 0) {}
+
+  /** @brief Number of processors in the batch. */
+  std::size_t processor_count() const { return m_processor_count; }
+
+  /** @brief Maximum number of samples per processor. */
+  std::size_t capacity() const { return m_capacity; }
+
+  /** @brief Number of samples stored for @p processor. */
+  std::size_t size(std::size_t processor) const { return m_sizes[processor]; }
+
+  /** @brief Drops all samples while keeping the allocation. */
+  void clear() { std::fill(m_sizes.begin(), m_sizes.end(), 0); }
+
+  /**
+   * @brief Returns the stored samples of one metric of one processor.
+   */
+  std::span<const uint32_t> column(std::size_t processor,
+                                   metric_column metric) const {
+    return {column_data(processor, metric), m_sizes[processor]};
+  }
+
+  /**
+   * @brief Appends one sample of @p processor, taking VRAM usage from
+   * smi_metrics::memory_usage, which wraps above 4 GiB.
+   * @return False if the processor's columns are full.
+   */
+  bool append(std::size_t processor, const smi_metrics &metrics) {
+    return append(processor, metrics, metrics.memory_usage);
+  }
+
+  /**
+   * @brief Appends one sample of @p processor.
+   * @param vram_used VRAM in use in bytes, from the processor's
+   * memory_snapshot.
+   * @return False if the processor's columns are full.
+   */
+  bool append(std::size_t processor, const smi_metrics &metrics,
+              uint64_t vram_used) {
+    auto &size = m_sizes[processor];
+    if (size == m_capacity) {
+      return false;
+    }
+    for (std::size_t metric = 0; metric < metric_column_count; ++metric) {
+      auto column = static_cast<metric_column>(metric);
+      column_data(processor, column)[size] = metric_value(metrics, column);
+    }
+    column_data(processor, metric_column::memory_usage)[size] =
+        to_mebibytes(vram_used);
+    ++size;
+    return true;
+  }
+
+  /**
+   * @brief Appends raw driver records of @p processor column by column.
+   *
+   * Each destination column is filled in one sequential pass over the
+   * records, so writes stay contiguous even though the source fields are
+   * strided through the driver structure.
+   *
+   * @param processor Processor index.
+   * @param records Raw GPU metrics, oldest first.
+   * @param memory_usage Optional VRAM usage in bytes for each record; the
+   * memory column is zero-filled when empty.
+   * @return Number of records appended; stops when the columns are full.
+   */
+  std::size_t append(std::size_t processor,
+                     std::span<const amdsmi_gpu_metrics_t> records,
+                     std::span<const uint64_t> memory_usage = {}) {
+    auto &size = m_sizes[processor];
+    std::size_t count = std::min(records.size(), m_capacity - size);
+
+    auto convert = [&](metric_column metric, auto member) {
+      uint32_t *out = column_data(processor, metric) + size;
+      for (std::size_t i = 0; i < count; ++i) {
+        out[i] = records[i].*member;
+      }
+    };
+    convert(metric_column::current_socket_power,
+            &amdsmi_gpu_metrics_t::current_socket_power);
+    convert(metric_column::average_socket_power,
+            &amdsmi_gpu_metrics_t::average_socket_power);
+    convert(metric_column::hotspot_temperature,
+            &amdsmi_gpu_metrics_t::temperature_hotspot);
+    convert(metric_column::edge_temperature,
+            &amdsmi_gpu_metrics_t::temperature_edge);
+    convert(metric_column::gfx_activity,
+            &amdsmi_gpu_metrics_t::average_gfx_activity);
+    convert(metric_column::umc_activity,
+            &amdsmi_gpu_metrics_t::average_umc_activity);
+    convert(metric_column::mm_activity,
+            &amdsmi_gpu_metrics_t::average_mm_activity);
+
+    uint32_t *memory = column_data(processor, metric_column::memory_usage);
+    for (std::size_t i = 0; i < count; ++i) {
+      memory[size + i] =
+          i < memory_usage.size() ? to_mebibytes(memory_usage[i]) : 0;
+    }
+
+    size += count;
+    return count;
+  }
+
+  /**
+   * @brief Appends the latest sample of every successfully read table row.
+   * @return Number of samples appended.
+   */
+  template <typename driver>
+  std::size_t append_round(const processor_table<driver> &table) {
+    auto statuses = table.statuses();
+    auto samples = table.samples();
+    auto memory = table.memory();
+    std::size_t appended{0};
+    for (std::size_t row = 0; row < std::min(table.size(), m_processor_count);
+         ++row) {
+      if (statuses[row] == AMDSMI_STATUS_SUCCESS) {
+        appended +=
+            append(row, samples[row], memory[row].used[AMDSMI_MEM_TYPE_VRAM]);
+      }
+    }
+    return appended;
+  }
+
+  /**
+   * @brief Summarizes one metric of one processor across time.
+   */
+  column_summary summarize(std::size_t processor, metric_column metric) const {
+    return summarize_column(column(processor, metric));
+  }
+
+  /**
+   * @brief Counts samples of one processor above @p threshold.
+   */
+  std::size_t count_above(std::size_t processor, metric_column metric,
+                          uint32_t threshold) const {
+    return column_count_above(column(processor, metric), threshold);
+  }
+
+  /**
+   * @brief Summarizes the most recent sample of every processor.
+   *
+   * Processors without samples are skipped.
+   */
+  column_summary summarize_latest(metric_column metric) const {
+    return summarize_column(gather_latest(metric));
+  }
+
+  /**
+   * @brief Counts processors whose most recent sample is above @p threshold.
+   */
+  std::size_t count_latest_above(metric_column metric,
+                                 uint32_t threshold) const {
+    return column_count_above(gather_latest(metric), threshold);
+  }
+
+private:
+  static uint32_t to_mebibytes(uint64_t bytes) {
+    return static_cast<uint32_t>(bytes >> 20);
+  }
+
+  uint32_t *column_data(std::size_t processor, metric_column metric) {
+    return m_data.data() +
+           (processor * metric_column_count +
+            static_cast<std::size_t>(metric)) *
+               m_capacity;
+  }
+
+  const uint32_t *column_data(std::size_t processor,
+                              metric_column metric) const {
+    return const_cast<sample_batch *>(this)->column_data(processor, metric);
+  }
+
+  std::span<const uint32_t> gather_latest(metric_column metric) const {
+    std::size_t count{0};
+    for (std::size_t processor = 0; processor < m_processor_count;
+         ++processor) {
+      if (m_sizes[processor] != 0) {
+        m_scratch[count++] =
+            column_data(processor, metric)[m_sizes[processor] - 1];
+      }
+    }
+    return {m_scratch.data(), count};
+  }
+
+  std::size_t m_processor_count;
+  std::size_t m_capacity;
+  std::vector<std::size_t> m_sizes;
+  std::vector<uint32_t> m_data;
+  mutable std::vector<uint32_t> m_scratch;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,308 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/common.hpp"
+#include "smi/derived_metrics.hpp"
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sample_batch.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Text formats of sample_exporter.
+ */
+enum class export_format {
+  csv,        ///< Header line, then one row per sample
+  json_lines, ///< One JSON object per line
+};
+
+/**
+ * @class sample_exporter
+ * @brief Formats per-processor samples as CSV or JSON Lines into a reused
+ * buffer and hands it to a sink in large chunks.
+ *
+ * Only the metrics a processor supports are written: CSV has a column for
+ * every metric supported by any processor and leaves unsupported cells
+ * empty, while JSON Lines omits unsupported fields. Derived metrics added
+ * with add_derived_columns() follow the native ones, and are left empty or
+ * omitted in rows written without derived values and for processors that do
+ * not support them (a NaN value); other non-finite values, e.g. from a
+ * division by zero, are written as an empty cell or null. Rows are formatted
+ * with compiled format strings straight into the buffer, so exporting does
+ * not allocate once the buffer has grown to its flush size.
+ */
+class sample_exporter {
+public:
+  /** @brief Receives formatted text; see fd_sink(). */
+  using sink = std::function<void(std::string_view)>;
+
+  /**
+   * @brief Constructs an exporter.
+   * @param format Output format.
+   * @param supported Capabilities of each processor, indexed by processor
+   * id (e.g. processor_table::capabilities()).
+   * @param out Destination of the formatted text.
+   * @param flush_bytes Buffered bytes that trigger a write to @p out.
+   */
+  sample_exporter(export_format format,
+                  std::span<const capability_mask> supported, sink out,
+                  std::size_t flush_bytes = 1 << 20)
+      : m_format{format}, m_supported(supported.begin(), supported.end()),
+        m_out{std::move(out)}, m_flush_bytes{flush_bytes} {
+    for (auto mask : m_supported) {
+      m_columns |= mask;
+    }
+    m_buffer.reserve(flush_bytes + 1024);
+  }
+
+  sample_exporter(const sample_exporter &) = delete;
+  sample_exporter &operator=(const sample_exporter &) = delete;
+
+  /**
+   * @brief Writes the remaining buffered text. A write error is dropped
+   * here; call flush() first to see it.
+   */
+  ~sample_exporter() {
+    try {
+      flush();
+    } catch (const std::exception &) {
+    }
+  }
+
+  /**
+   * @brief Adds one column per derived metric, named after its definition.
+   *
+   * Names are written unquoted in the CSV header and unescaped as JSON
+   * keys; derived_metrics only accepts a valid_derived_name(), which needs
+   * neither.
+   * @note Must be called before the first write.
+   */
+  void add_derived_columns(const derived_metrics &derived) {
+    for (std::size_t metric = 0; metric < derived.size(); ++metric) {
+      m_derived_names.push_back(derived.definition(metric).name);
+    }
+  }
+
+  /** @brief Number of rows written, excluding the CSV header. */
+  uint64_t rows() const { return m_rows; }
+
+  /**
+   * @brief Writes one sample of one processor.
+   * @param derived Values of the derived columns, in definition order.
+   */
+  void write(uint32_t processor, uint64_t host_ns, const smi_metrics &metrics,
+             std::span<const double> derived = {}) {
+    std::array<uint64_t, metric_column_count> values;
+    for (std::size_t column = 0; column < metric_column_count; ++column) {
+      values[column] =
+          metric_value(metrics, static_cast<metric_column>(column));
+    }
+    write_row(processor, host_ns, values, derived);
+  }
+
+  /** @brief Writes one record, e.g. from a capture or a daemon batch. */
+  void write(const sample_record &record) {
+    write_row(record.processor, record.host_ns, record.values, {});
+  }
+
+  /**
+   * @brief Writes the latest sample of every table row read successfully.
+   * @param due Groups refreshed per row this round; when empty every row is
+   * written.
+   * @param derived Derived metrics updated from the same round, if any.
+   * @return Number of rows written.
+   */
+  template <typename driver>
+  std::size_t write_round(const processor_table<driver> &table,
+                          std::span<const group_mask> due = {},
+                          const derived_metrics *derived = nullptr) {
+    auto statuses = table.statuses();
+    auto samples = table.samples();
+    auto timestamps = table.timestamps();
+    std::size_t written{0};
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      if ((due.empty() || due[row] != 0) &&
+          statuses[row] == AMDSMI_STATUS_SUCCESS) {
+        write(static_cast<uint32_t>(row), timestamps[row].host_ns(),
+              samples[row],
+              derived != nullptr && row < derived->rows()
+                  ? derived->values(row)
+                  : std::span<const double>{});
+        ++written;
+      }
+    }
+    return written;
+  }
+
+  /**
+   * @brief Hands all buffered text to the sink.
+   * @throws Whatever the sink throws; the text stays buffered.
+   */
+  void flush() {
+    if (m_buffer.size() != 0) {
+      m_out({m_buffer.data(), m_buffer.size()});
+      m_buffer.clear();
+    }
+  }
+
+private:
+  void write_row(uint32_t processor, uint64_t host_ns,
+                 const std::array<uint64_t, metric_column_count> &values,
+                 std::span<const double> derived) {
+    auto out = std::back_inserter(m_buffer);
+    capability_mask supported =
+        processor < m_supported.size() ? m_supported[processor] : 0;
+    if (m_format == export_format::csv) {
+      if (!m_header_written) {
+        write_csv_header();
+      }
+      fmt::format_to(out, FMT_COMPILE("{},{}"), host_ns, processor);
+      for (std::size_t column = 0; column < metric_column_count; ++column) {
+        auto bit = column_capability(static_cast<metric_column>(column));
+        if ((m_columns & bit) == 0) {
+          continue;
+        }
+        if (supported & bit) {
+          fmt::format_to(out, FMT_COMPILE(",{}"), values[column]);
+        } else {
+          m_buffer.push_back(',');
+        }
+      }
+      for (std::size_t metric = 0; metric < m_derived_names.size(); ++metric) {
+        if (metric < derived.size() && std::isfinite(derived[metric])) {
+          fmt::format_to(out, FMT_COMPILE(",{}"), derived[metric]);
+        } else {
+          m_buffer.push_back(',');
+        }
+      }
+      m_buffer.push_back('\n');
+    } else {
+      fmt::format_to(out, FMT_COMPILE("{{\"host_ns\":{},\"processor\":{}"),
+                     host_ns, processor);
+      for (std::size_t column = 0; column < metric_column_count; ++column) {
+        auto metric = static_cast<metric_column>(column);
+        if (supported & column_capability(metric)) {
+          fmt::format_to(out, FMT_COMPILE(",\"{}\":{}"),
+                         metric_column_name(metric), values[column]);
+        }
+      }
+      for (std::size_t metric = 0;
+           metric < std::min(m_derived_names.size(), derived.size());
+           ++metric) {
+        if (std::isnan(derived[metric])) {
+          continue;
+        }
+        if (std::isinf(derived[metric])) {
+          fmt::format_to(out, FMT_COMPILE(",\"{}\":null"),
+                         m_derived_names[metric]);
+          continue;
+        }
+        fmt::format_to(out, FMT_COMPILE(",\"{}\":{}"), m_derived_names[metric],
+                       derived[metric]);
+      }
+      m_buffer.append(std::string_view{"}\n"});
+    }
+    ++m_rows;
+    if (m_buffer.size() >= m_flush_bytes) {
+      flush();
+    }
+  }
+
+  void write_csv_header() {
+    m_buffer.append(std::string_view{"host_ns,processor"});
+    for (std::size_t column = 0; column < metric_column_count; ++column) {
+      auto metric = static_cast<metric_column>(column);
+      if (m_columns & column_capability(metric)) {
+        m_buffer.push_back(',');
+        m_buffer.append(metric_column_name(metric));
+      }
+    }
+    for (const auto &name : m_derived_names) {
+      m_buffer.push_back(',');
+      m_buffer.append(name);
+    }
+    m_buffer.push_back('\n');
+    m_header_written = true;
+  }
+
+  export_format m_format;
+  std::vector<capability_mask> m_supported; ///< Per processor
+  capability_mask m_columns{0};             ///< Union of m_supported
+  std::vector<std::string> m_derived_names; ///< Derived columns
+  sink m_out;
+  std::size_t m_flush_bytes;
+  fmt::memory_buffer m_buffer;
+  bool m_header_written{false};
+  uint64_t m_rows{0};
+};
+
+/**
+ * @brief Sink writing to a file descriptor, retrying short writes.
+ * @throws std::runtime_error from the sink if a write fails.
+ */
+inline sample_exporter::sink fd_sink(int fd) {
+  return [fd](std::string_view text) {
+    while (!text.empty()) {
+      auto written = ::write(fd, text.data(), text.size());
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        detail::throw_errno("Failed to write samples");
+      }
+      text.remove_prefix(static_cast<std::size_t>(written));
+    }
+  };
+}
+
+} // namespace amd_smi
+} // namespace rocprofsys
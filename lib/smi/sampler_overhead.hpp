@@ -0,0 +1,148 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief CPU time consumed so far by the calling thread, in nanoseconds.
+ */
+inline uint64_t thread_cpu_time_ns() {
+  timespec now{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 +
+         static_cast<uint64_t>(now.tv_nsec);
+}
+
+/**
+ * @class latency_histogram
+ * @brief Distribution of durations in power-of-two microsecond buckets.
+ *
+ * Bucket 0 counts durations below 1 us and bucket i durations in
+ * [2^(i-1), 2^i) us; the last bucket is open-ended. Recording is a few
+ * integer operations, cheap enough for every sampler tick.
+ */
+class latency_histogram {
+public:
+  static constexpr std::size_t bucket_count = 24;
+
+  /** @brief Adds one duration. */
+  void record(uint64_t duration_ns) {
+    auto micros = duration_ns / 1000;
+    auto bucket = std::min<std::size_t>(std::bit_width(micros),
+                                        bucket_count - 1);
+    ++m_buckets[bucket];
+    ++m_count;
+    m_total_ns += duration_ns;
+    m_max_ns = std::max(m_max_ns, duration_ns);
+  }
+
+  /** @brief Number of recorded durations. */
+  uint64_t count() const { return m_count; }
+
+  /** @brief Longest recorded duration. */
+  uint64_t max_ns() const { return m_max_ns; }
+
+  /** @brief Mean duration, or zero when empty. */
+  double mean_ns() const {
+    return m_count == 0 ? 0.0 : static_cast<double>(m_total_ns) / m_count;
+  }
+
+  /** @brief Count of one bucket. */
+  uint64_t bucket(std::size_t index) const { return m_buckets[index]; }
+
+  /**
+   * @brief Upper bound of the bucket holding the @p fraction quantile.
+   * @param fraction Quantile in [0, 1], e.g. 0.99.
+   * @return Bound in nanoseconds; the maximum for the open-ended bucket.
+   */
+  uint64_t quantile_ns(double fraction) const {
+    auto rank = static_cast<uint64_t>(fraction * static_cast<double>(m_count));
+    uint64_t seen{0};
+    for (std::size_t index = 0; index + 1 < bucket_count; ++index) {
+      seen += m_buckets[index];
+      if (seen > rank) {
+        return std::min(m_max_ns, (uint64_t{1} << index) * 1000);
+      }
+    }
+    return m_max_ns;
+  }
+
+private:
+  std::array<uint64_t, bucket_count> m_buckets{};
+  uint64_t m_count{0};
+  uint64_t m_total_ns{0};
+  uint64_t m_max_ns{0};
+};
+
+/**
+ * @struct sampler_overhead
+ * @brief Cost of the background sampler.
+ *
+ * CPU time is thread CPU time (CLOCK_THREAD_CPUTIME_ID): that of the sampler
+ * thread during each tick, plus that of the supervised_reader workers whose
+ * driver calls returned during the tick. Other threads of the process are not
+ * counted.
+ */
+struct sampler_overhead {
+  uint64_t rounds{0};                 ///< Ticks run by the sampler thread
+  uint64_t cpu_time_ns{0};            ///< CPU time of those ticks
+  uint64_t worker_cpu_time_ns{0};     ///< Part of cpu_time_ns spent on workers
+  uint64_t max_round_cpu_ns{0};       ///< Most expensive tick
+  latency_histogram wakeup_latency{}; ///< Wakeup minus scheduled tick time
+  latency_histogram tick_jitter{};    ///< |Tick interval - nominal tick|
+
+  /** @brief Mean CPU time per tick, or zero before the first tick. */
+  double mean_round_cpu_ns() const {
+    return rounds == 0 ? 0.0 : static_cast<double>(cpu_time_ns) / rounds;
+  }
+
+  /**
+   * @brief Adds the CPU time of one tick.
+   * @param round_cpu_ns Sampler thread and worker CPU time of the tick.
+   * @param round_worker_cpu_ns Part of @p round_cpu_ns spent on workers.
+   */
+  void record_round(uint64_t round_cpu_ns, uint64_t round_worker_cpu_ns = 0) {
+    ++rounds;
+    cpu_time_ns += round_cpu_ns;
+    worker_cpu_time_ns += round_worker_cpu_ns;
+    max_round_cpu_ns = std::max(max_round_cpu_ns, round_cpu_ns);
+  }
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,359 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/data_collector.hpp"
+#include "smi/metrics_endpoint.hpp"
+#include "smi/processor_filter.hpp"
+#include "smi/sample_batch.hpp"
+#include "smi/sampling_scheduler.hpp"
+#include "smi/subscription_protocol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @class sampling_daemon
+ * @tparam driver_factory The factory type used to create the driver interface.
+ * @brief Samples the node once and fans the results out to local clients
+ * over a Unix domain socket.
+ *
+ * The daemon owns the only data_collector of the node and runs its
+ * background scheduler. Each client sends a subscribe frame naming the
+ * processors, metrics, period and batch size it wants; the daemon answers
+ * with a subscribed frame carrying the processor count, then sends samples
+ * frames of @c batch records per selected processor. Records are built from
+ * the collector's published samples, so the number of clients never changes
+ * the number of driver calls.
+ *
+ * A client that does not keep up has frames dropped (see dropped_frames())
+ * rather than stalling the daemon. Use daemon_client on the client side.
+ */
+template <smi_driver_factory driver_factory> class sampling_daemon {
+public:
+  /** @brief Frames queued per client before new frames are dropped. */
+  static constexpr std::size_t max_pending_bytes = 1 << 20;
+
+  /**
+   * @brief Initializes the driver, starts sampling and starts listening.
+   * @param socket_path Unix socket to listen on; a stale socket left by an
+   * exited daemon is replaced.
+   * @param policy Sampling rates of the shared collector.
+   * @param filter Processors to sample.
+   * @throws std::runtime_error if the driver or the socket cannot be set up,
+   * e.g. because another daemon listens on @p socket_path or it names a file
+   * that is not a socket.
+   */
+  explicit sampling_daemon(
+      std::string socket_path, const sampling_policy &policy = {},
+      processor_filter filter = processor_filter::amd_gpus())
+      : m_socket_path{std::move(socket_path)}, m_collector{std::move(filter)},
+        m_listen_fd{detail::listen_on({.unix_path = m_socket_path})},
+        m_wake_fd{eventfd(0, EFD_CLOEXEC)} {
+    if (m_wake_fd < 0) {
+      close(m_listen_fd);
+      detail::throw_errno("Failed to create eventfd");
+    }
+    try {
+      m_collector.start(policy);
+      m_thread = std::thread([this] { run(); });
+    } catch (...) {
+      close(m_listen_fd);
+      close(m_wake_fd);
+      unlink(m_socket_path.c_str());
+      throw;
+    }
+  }
+
+  sampling_daemon(const sampling_daemon &) = delete;
+  sampling_daemon &operator=(const sampling_daemon &) = delete;
+
+  ~sampling_daemon() {
+    uint64_t wake{1};
+    [[maybe_unused]] auto written = write(m_wake_fd, &wake, sizeof(wake));
+    m_thread.join();
+    for (auto &current : m_clients) {
+      close(current.fd);
+    }
+    close(m_listen_fd);
+    close(m_wake_fd);
+    unlink(m_socket_path.c_str());
+  }
+
+  /** @brief The shared collector, e.g. to add event rules. */
+  data_collector<driver_factory> &get_collector() { return m_collector; }
+
+  /** @brief Number of connected clients. */
+  std::size_t client_count() const { return m_client_count; }
+
+  /** @brief Frames dropped because a client fell behind. */
+  uint64_t dropped_frames() const { return m_dropped_frames; }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  struct client {
+    int fd;
+    frame_reader reader{};
+    std::optional<subscription> request{};
+    clock::time_point next_due{};
+    std::string batch{};      ///< Samples payload being filled
+    uint32_t batch_rounds{0}; ///< Rounds already in the batch
+    std::string pending{};    ///< Encoded bytes not yet sent
+  };
+
+  void run() {
+    std::vector<pollfd> fds;
+    for (;;) {
+      fds.clear();
+      fds.push_back({m_listen_fd, POLLIN, 0});
+      fds.push_back({m_wake_fd, POLLIN, 0});
+      for (auto &current : m_clients) {
+        short events = POLLIN;
+        if (!current.pending.empty()) {
+          events |= POLLOUT;
+        }
+        fds.push_back({current.fd, events, 0});
+      }
+
+      if (poll(fds.data(), fds.size(), poll_timeout_ms()) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[1].revents != 0) {
+        return;
+      }
+
+      auto fd = fds.begin() + 2;
+      for (auto current = m_clients.begin(); current != m_clients.end();
+           ++fd) {
+        bool alive = true;
+        if (fd->revents & (POLLERR | POLLHUP | POLLIN)) {
+          alive = receive(*current);
+        }
+        if (alive && (fd->revents & POLLOUT)) {
+          alive = flush(*current);
+        }
+        if (alive) {
+          ++current;
+        } else {
+          close(current->fd);
+          current = m_clients.erase(current);
+        }
+      }
+
+      if (fds[0].revents & POLLIN) {
+        int accepted = accept4(m_listen_fd, nullptr, nullptr,
+                               SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (accepted >= 0) {
+          m_clients.push_back(client{accepted});
+        }
+      }
+      m_client_count = m_clients.size();
+      publish_due(clock::now());
+    }
+  }
+
+  int poll_timeout_ms() const {
+    std::optional<clock::time_point> earliest;
+    for (const auto &current : m_clients) {
+      if (current.request && (!earliest || current.next_due < *earliest)) {
+        earliest = current.next_due;
+      }
+    }
+    if (!earliest) {
+      return -1;
+    }
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(*earliest -
+                                                             clock::now());
+    return static_cast<int>(std::max<int64_t>(wait.count(), 0));
+  }
+
+  bool receive(client &current) {
+    char buffer[512];
+    auto received = recv(current.fd, buffer, sizeof(buffer), 0);
+    if (received == 0) {
+      return false;
+    }
+    if (received < 0) {
+      return errno == EAGAIN || errno == EINTR;
+    }
+    current.reader.feed({buffer, static_cast<std::size_t>(received)});
+    try {
+      while (auto next = current.reader.next()) {
+        if (next->type != frame_type::subscribe) {
+          throw std::runtime_error("Unexpected SMI frame");
+        }
+        subscribe(current, decode_subscription(next->payload));
+      }
+    } catch (const std::exception &error) {
+      current.pending += encode_frame(frame_type::error, error.what());
+      flush(current);
+      return false;
+    }
+    return true;
+  }
+
+  void subscribe(client &current, const subscription &request) {
+    check_processor_count();
+    current.request = request;
+    current.next_due = clock::now();
+    current.batch = begin_samples(request.columns);
+    current.batch_rounds = 0;
+    std::string payload;
+    detail::put(payload, static_cast<uint32_t>(processor_count()));
+    queue(current, encode_frame(frame_type::subscribed, payload));
+  }
+
+  void publish_due(clock::time_point now) {
+    for (auto &current : m_clients) {
+      if (!current.request || current.next_due > now) {
+        continue;
+      }
+      auto count = processor_count();
+      if (count > max_subscribed_processors) {
+        // Processors were added beyond what the subscription can select.
+        current.request.reset();
+        queue(current, encode_frame(frame_type::error,
+                                    processor_count_error(count)));
+        continue;
+      }
+      const auto &request = *current.request;
+      std::chrono::milliseconds period{request.period_ms};
+      current.next_due += period;
+      if (current.next_due <= now) {
+        // Fell behind; skip the missed rounds.
+        current.next_due = now + period;
+      }
+
+      bool recorded{false};
+      for (std::size_t id = 0; id < count; ++id) {
+        if ((request.processors & (uint64_t{1} << id)) == 0) {
+          continue;
+        }
+        // Processors not read yet have nothing to report.
+        if (auto next = record(id)) {
+          encode_record(current.batch, request.columns, *next);
+          recorded = true;
+        }
+      }
+      if (recorded && ++current.batch_rounds >= request.batch) {
+        queue(current, encode_frame(frame_type::samples, current.batch));
+        current.batch = begin_samples(request.columns);
+        current.batch_rounds = 0;
+      }
+    }
+  }
+
+  std::optional<sample_record> record(std::size_t id) {
+    auto sample = m_collector.read_sample(id);
+    if (sample.timestamp.host_end_ns == 0) {
+      return std::nullopt;
+    }
+    return to_sample_record(
+        static_cast<uint32_t>(id), m_collector.read_metrics(id),
+        m_collector.read_memory(id).used[AMDSMI_MEM_TYPE_VRAM],
+        sample.timestamp);
+  }
+
+  void queue(client &current, std::string encoded) {
+    if (current.pending.size() + encoded.size() > max_pending_bytes) {
+      ++m_dropped_frames;
+      return;
+    }
+    current.pending += encoded;
+    flush(current);
+  }
+
+  bool flush(client &current) {
+    while (!current.pending.empty()) {
+      auto sent = send(current.fd, current.pending.data(),
+                       current.pending.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent < 0) {
+        return errno == EAGAIN || errno == EINTR;
+      }
+      current.pending.erase(0, static_cast<std::size_t>(sent));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Processors the daemon publishes, read from the published samples
+   * so a concurrent rescan() cannot be observed half way.
+   */
+  std::size_t processor_count() { return m_collector.published_count(); }
+
+  /**
+   * @throws std::runtime_error if the processors cannot all be addressed by
+   * a subscription.
+   */
+  void check_processor_count() {
+    auto count = processor_count();
+    if (count > max_subscribed_processors) {
+      throw std::runtime_error(processor_count_error(count));
+    }
+  }
+
+  static std::string processor_count_error(std::size_t count) {
+    return "SMI daemon samples " + std::to_string(count) +
+           " processors; subscriptions can select only the first " +
+           std::to_string(max_subscribed_processors);
+  }
+
+  std::string m_socket_path;
+  data_collector<driver_factory> m_collector;
+  int m_listen_fd;
+  int m_wake_fd;
+  std::list<client> m_clients; ///< Touched by the daemon thread only
+  std::atomic<std::size_t> m_client_count{0};
+  std::atomic<uint64_t> m_dropped_frames{0};
+  std::thread m_thread;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
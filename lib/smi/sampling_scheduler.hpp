@@ -0,0 +1,492 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/adaptive_sampling.hpp"
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sampler_overhead.hpp"
+#include "smi/supervised_reader.hpp"
+#include "smi/thread_placement.hpp"
+#include "smi/timer_wheel.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <pthread.h>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct sampling_policy
+ * @brief Sampling period of every metric group.
+ *
+ * Periods are rounded down to whole ticks (at least one). Fast-moving
+ * metrics such as socket power need short periods, while temperatures and
+ * memory usage can be sampled far less often.
+ */
+struct sampling_policy {
+  using duration = std::chrono::microseconds;
+
+  /** Resolution of the scheduler's timer wheel. */
+  duration tick{std::chrono::milliseconds{10}};
+  /** Period of each metric group, indexed by metric_group. */
+  std::array<duration, metric_group_count> periods{
+      std::chrono::milliseconds{10},  // power
+      std::chrono::milliseconds{100}, // thermal
+      std::chrono::milliseconds{500}, // memory
+      std::chrono::milliseconds{10},  // activity
+      std::chrono::milliseconds{100}, // xcp_engines
+      std::chrono::milliseconds{10},  // clocks
+  };
+  /** Change-driven stretching of the periods; disabled by default. */
+  adaptive_policy adaptive{};
+  /** CPU affinity and priority of the scheduler and its reader's workers. */
+  thread_placement placement{};
+
+  duration &period(metric_group group) {
+    return periods[static_cast<std::size_t>(group)];
+  }
+
+  const duration &period(metric_group group) const {
+    return periods[static_cast<std::size_t>(group)];
+  }
+
+  /** @brief Period of @p group in ticks, at least one. */
+  uint64_t period_ticks(metric_group group) const {
+    auto ticks = tick.count() > 0 ? period(group) / tick : 1;
+    return ticks > 0 ? static_cast<uint64_t>(ticks) : 1;
+  }
+};
+
+/**
+ * @class sampling_scheduler
+ * @tparam driver The driver interface type used to communicate with the
+ * processors.
+ * @brief Samples a processor_table at per-group rates from a single thread.
+ *
+ * Every (processor, metric group) pair the processor supports owns one timer
+ * on a timer_wheel. On each tick the expired timers are merged into a group
+ * mask per processor, and each processor due on the tick is read once with
+ * that mask. Groups that share the GPU metrics call are therefore batched,
+ * and the driver call rate of a processor follows its fastest due group
+ * instead of the fastest configured group.
+ *
+ * With sampling_policy::adaptive enabled, every successful read that
+ * refreshed the watched groups (change_detector::watched_groups) is fed to a
+ * change_detector, and the timers of that processor are rescheduled with
+ * their period multiplied by the processor's current stride. When a change
+ * resets the stride, every group of the processor is due on the next tick.
+ *
+ * With a supervised_reader set, the due processors of a tick are read in
+ * parallel under its deadline instead of one after another on the
+ * scheduler thread; a processor that misses the deadline is skipped for
+ * that round while the others publish on time.
+ *
+ * Rows retired from the table stop being sampled on their next due tick.
+ * Rows added to the table are picked up with add_rows(); run it through
+ * post_to_thread() while the scheduler thread is running so the table is
+ * never changed under a tick.
+ */
+template <typename driver> class sampling_scheduler {
+public:
+  /**
+   * @brief Called on the scheduler thread after each tick that sampled at
+   * least one processor, with the groups refreshed per row.
+   */
+  using round_callback = std::function<void(const processor_table<driver> &,
+                                            std::span<const group_mask>)>;
+
+  /**
+   * @brief Constructs a stopped scheduler.
+   * @param table Probed processor table; must outlive the scheduler.
+   * @param policy Tick and per-group periods.
+   * @param on_round Optional callback invoked after each sampling tick.
+   */
+  sampling_scheduler(processor_table<driver> &table, sampling_policy policy,
+                     round_callback on_round = {})
+      : m_table{table}, m_policy{policy}, m_on_round{std::move(on_round)},
+        m_wheel{wheel_slots(policy)}, m_due(table.size(), 0),
+        m_generations(table.size(), 0),
+        m_detector{policy.adaptive, table.size()},
+        m_strides(table.size(), 1) {
+    for (std::size_t row = 0; row < m_table.size(); ++row) {
+      schedule_row(row);
+    }
+  }
+
+  sampling_scheduler(const sampling_scheduler &) = delete;
+  sampling_scheduler &operator=(const sampling_scheduler &) = delete;
+
+  ~sampling_scheduler() { stop(); }
+
+  /**
+   * @brief Starts the scheduler thread. Does nothing if already running.
+   *
+   * The thread applies sampling_policy::placement to itself and to the
+   * workers of the reader before its first tick, and start() returns once
+   * it did.
+   * @throws std::system_error if sampling_policy::placement cannot be
+   * applied; the thread is stopped again.
+   */
+  void start() {
+    std::promise<void> placed;
+    auto ready = placed.get_future();
+    {
+      std::lock_guard lock{m_mutex};
+      if (m_running) {
+        return;
+      }
+      m_running = true;
+      m_thread = std::thread(
+          [this, placed = std::move(placed)]() mutable { run(placed); });
+    }
+    try {
+      ready.get();
+    } catch (...) {
+      stop();
+      throw;
+    }
+  }
+
+  /**
+   * @brief Stops and joins the scheduler thread.
+   *
+   * Tasks still queued for the thread by post_to_thread() run on the
+   * calling thread once the scheduler thread has exited.
+   */
+  void stop() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_running = false;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+      m_thread.join();
+      run_posted_tasks();
+    }
+  }
+
+  /** @brief Whether the scheduler thread is running. */
+  bool running() const {
+    std::lock_guard lock{m_mutex};
+    return m_running;
+  }
+
+  /**
+   * @brief Runs @p task before the next tick, for ticks driven manually.
+   */
+  void post(std::function<void()> task) {
+    std::lock_guard lock{m_mutex};
+    m_tasks.push_back(std::move(task));
+  }
+
+  /**
+   * @brief Runs @p task on the scheduler thread before its next tick.
+   *
+   * A queued task always runs: on the scheduler thread, or in stop() if
+   * the thread exits first.
+   * @return False, without queuing the task, if the thread is not running
+   * or the caller is the scheduler thread itself (e.g. a round callback or
+   * a coroutine it resumed); the caller may then run the task directly.
+   */
+  bool post_to_thread(std::function<void()> task) {
+    std::lock_guard lock{m_mutex};
+    if (!m_running || std::this_thread::get_id() == m_thread.get_id()) {
+      return false;
+    }
+    m_tasks.push_back(std::move(task));
+    return true;
+  }
+
+  /**
+   * @brief Reads due processors through @p reader; null reads inline.
+   * @param reader Reader over the same table; must outlive the scheduler.
+   * @note Must be called before start().
+   */
+  void set_reader(supervised_reader<driver> *reader) { m_reader = reader; }
+
+  /**
+   * @brief Starts sampling rows that were added to or returned to the table.
+   *
+   * Pending timers of the rows are discarded and every supported group is
+   * due on the next tick.
+   * @note Must run on the scheduler thread (see post()) or while stopped.
+   */
+  void add_rows(std::span<const std::size_t> rows) {
+    m_due.resize(m_table.size(), 0);
+    m_generations.resize(m_table.size(), 0);
+    m_detector.resize(m_table.size());
+    for (auto row : rows) {
+      m_detector.reset_row(row);
+      schedule_row(row);
+    }
+    std::lock_guard lock{m_mutex};
+    m_strides.resize(m_table.size(), 1);
+    for (auto row : rows) {
+      m_strides[row] = 1;
+    }
+  }
+
+  /**
+   * @brief Advances the wheel one tick and reads every processor that is due.
+   *
+   * Called by the scheduler thread; may also be driven manually while the
+   * thread is stopped. Tasks queued with post() run first.
+   * @return Number of processors read on this tick.
+   */
+  std::size_t tick() {
+    run_posted_tasks();
+
+    std::fill(m_due.begin(), m_due.end(), 0);
+    m_fired.clear();
+    auto capabilities = m_table.capabilities();
+    m_wheel.advance([&](const timer &expired) {
+      // Timers of retired or rescheduled rows are dropped.
+      if (expired.generation != m_generations[expired.row] ||
+          (capabilities[expired.row] & group_capabilities(expired.group)) ==
+              0) {
+        return;
+      }
+      m_due[expired.row] |= group_bit(expired.group);
+      m_fired.push_back(expired);
+    });
+
+    if (m_reader != nullptr) {
+      m_reader->read(m_due);
+    }
+    std::size_t sampled{0};
+    for (std::size_t row = 0; row < m_due.size(); ++row) {
+      if (m_due[row] == 0) {
+        continue;
+      }
+      auto status = m_reader != nullptr ? m_table.statuses()[row]
+                                        : m_table.sample_row(row, m_due[row]);
+      if (status == AMDSMI_STATUS_SUCCESS &&
+          (m_due[row] & change_detector::watched_groups) != 0) {
+        update_stride(row);
+      }
+      m_driver_calls += (m_due[row] & gpu_metrics_groups) != 0;
+      if ((m_due[row] & group_bit(metric_group::memory)) != 0) {
+        m_driver_calls += static_cast<uint64_t>(std::popcount(
+            uint32_t{m_table.get_supported_metrics(row).memory_types}));
+      }
+      ++sampled;
+    }
+
+    for (const auto &expired : m_fired) {
+      if (expired.generation != m_generations[expired.row]) {
+        continue; // The row was rescheduled in full on a change.
+      }
+      m_wheel.schedule(m_policy.period_ticks(expired.group) *
+                           m_detector.stride(expired.row),
+                       expired);
+    }
+
+    if (sampled != 0 && m_on_round) {
+      m_on_round(m_table, m_due);
+    }
+    return sampled;
+  }
+
+  /** @brief Total driver calls issued by the scheduler. */
+  uint64_t driver_calls() const { return m_driver_calls; }
+
+  /**
+   * @brief Current period multiplier of a row; always one unless adaptive
+   * sampling is enabled.
+   * @note Safe to call from any thread.
+   */
+  uint32_t stride(std::size_t row) const {
+    std::lock_guard lock{m_mutex};
+    return row < m_strides.size() ? m_strides[row] : 1;
+  }
+
+  /**
+   * @brief Cost of the scheduler so far: CPU time per tick, wakeup latency
+   * and tick jitter. Tick CPU time includes the supervised_reader workers
+   * (see sampler_overhead). Ticks driven manually are not counted.
+   */
+  sampler_overhead overhead() const {
+    std::lock_guard lock{m_mutex};
+    return m_overhead;
+  }
+
+  /** @brief Policy the scheduler was built with. */
+  const sampling_policy &get_policy() const { return m_policy; }
+
+private:
+  struct timer {
+    uint32_t row;
+    uint32_t generation;
+    metric_group group;
+  };
+
+  void schedule_row(std::size_t row) {
+    auto capabilities = m_table.capabilities();
+    auto generation = ++m_generations[row];
+    for (std::size_t group = 0; group < metric_group_count; ++group) {
+      auto metric = static_cast<metric_group>(group);
+      if (capabilities[row] & group_capabilities(metric)) {
+        m_wheel.schedule(
+            1, timer{static_cast<uint32_t>(row), generation, metric});
+      }
+    }
+  }
+
+  void update_stride(std::size_t row) {
+    auto previous = m_detector.stride(row);
+    auto stride = m_detector.update(row, m_table.samples()[row]);
+    if (stride == previous) {
+      return;
+    }
+    if (stride < previous) {
+      // Back to full rate: also re-arm the groups that were not due now.
+      schedule_row(row);
+    }
+    std::lock_guard lock{m_mutex};
+    m_strides[row] = stride;
+  }
+
+  void run_posted_tasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+      std::lock_guard lock{m_mutex};
+      tasks.swap(m_tasks);
+    }
+    for (auto &task : tasks) {
+      task();
+    }
+  }
+
+  static std::size_t wheel_slots(const sampling_policy &policy) {
+    uint64_t longest{1};
+    for (std::size_t group = 0; group < metric_group_count; ++group) {
+      longest = std::max(
+          longest, policy.period_ticks(static_cast<metric_group>(group)));
+    }
+    return static_cast<std::size_t>(longest) + 1;
+  }
+
+  void run(std::promise<void> &placed) {
+    try {
+      if (!m_policy.placement.empty()) {
+        apply_thread_placement(pthread_self(), m_policy.placement);
+        if (m_reader != nullptr) {
+          m_reader->set_placement(m_policy.placement);
+        }
+      }
+    } catch (...) {
+      placed.set_exception(std::current_exception());
+      return;
+    }
+    placed.set_value();
+
+    using clock = std::chrono::steady_clock;
+    auto next = clock::now();
+    clock::time_point previous_wakeup{};
+    std::unique_lock lock{m_mutex};
+    while (m_running) {
+      next += m_policy.tick;
+      auto now = clock::now();
+      if (next + m_policy.tick < now) {
+        // Fell behind by more than a tick; skip the missed ticks.
+        next = now;
+      }
+      if (m_condition.wait_until(lock, next, [this] { return !m_running; })) {
+        break;
+      }
+      auto wakeup = clock::now();
+      m_overhead.wakeup_latency.record(elapsed_ns(next, wakeup));
+      if (previous_wakeup != clock::time_point{}) {
+        auto interval = elapsed_ns(previous_wakeup, wakeup);
+        auto nominal = static_cast<uint64_t>(
+            std::chrono::nanoseconds{m_policy.tick}.count());
+        m_overhead.tick_jitter.record(interval > nominal ? interval - nominal
+                                                         : nominal - interval);
+      }
+      previous_wakeup = wakeup;
+      lock.unlock();
+      auto cpu_begin = thread_cpu_time_ns();
+      auto worker_begin = worker_cpu_time_ns();
+      tick();
+      auto cpu_time = thread_cpu_time_ns() - cpu_begin;
+      auto worker_time = worker_cpu_time_ns() - worker_begin;
+      lock.lock();
+      m_overhead.record_round(cpu_time + worker_time, worker_time);
+    }
+  }
+
+  /** @brief CPU time of the reader's workers, or zero when reading inline. */
+  uint64_t worker_cpu_time_ns() const {
+    return m_reader != nullptr ? m_reader->worker_cpu_time_ns() : 0;
+  }
+
+  static uint64_t elapsed_ns(std::chrono::steady_clock::time_point from,
+                             std::chrono::steady_clock::time_point to) {
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from);
+    return elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0;
+  }
+
+  processor_table<driver> &m_table;
+  sampling_policy m_policy;
+  round_callback m_on_round;
+  timer_wheel<timer> m_wheel;
+  std::vector<group_mask> m_due;       ///< Groups due per row this tick
+  std::vector<timer> m_fired;          ///< Timers expired this tick
+  std::vector<uint32_t> m_generations; ///< Timer generation per row
+  change_detector m_detector;
+  std::vector<uint32_t> m_strides; ///< Published strides; guarded by m_mutex
+  supervised_reader<driver> *m_reader{nullptr}; ///< Null: read inline
+  std::atomic<uint64_t> m_driver_calls{0};
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_running{false};
+  std::vector<std::function<void()>> m_tasks; ///< Queued by post()
+  sampler_overhead m_overhead;                ///< Guarded by m_mutex
+  std::thread m_thread;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
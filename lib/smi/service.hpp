@@ -29,11 +29,16 @@
 #pragma once
 
 #include "smi/common.hpp"
+#include "smi/driver.hpp"
 #include "smi/processor.hpp"
+#include "smi/processor_filter.hpp"
+#include "smi/processor_table.hpp"
 
 #include <amd_smi/amdsmi.h>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace rocprofsys {
@@ -46,18 +51,28 @@ namespace amd_smi {
  * The service class provides methods to initialize the AMD SMI driver, retrieve
  * its version, and enumerate all available processors. It uses a driver factory
  * to create the driver instance and wraps lower-level driver calls with error
- * checking.
+ * checking. Stateless drivers are bound at compile time; stateful drivers are
+ * shared with every processor through a reference-counted binding.
  */
-template <typename driver_factory> struct service {
+template <smi_driver_factory driver_factory> struct service {
   using driver_t = typename driver_factory::driver_t;
+  static_assert(enumeration_driver<driver_t>,
+                "Driver does not implement the enumeration interface!");
 
   /**
    * @brief Constructs a service object and initializes the AMD SMI driver.
+   *
+   * When the driver accepts init flags, it is initialized with the
+   * filter's processor_filter::init_flags(): only the accepted processor
+   * families, or every family for a filter without types.
+   * @param filter Processors to enumerate; accepts everything by default.
    * @throws std::runtime_error if driver initialization or version retrieval
    * fails.
    */
-  service() : m_driver_api(driver_factory::create_driver()) {
-    check_status(m_driver_api->init(), "Fail to initialize AMD SMI driver!");
+  explicit service(processor_filter filter = {})
+      : m_driver_api(driver_factory::create_driver()),
+        m_filter(std::move(filter)) {
+    check_status(init_driver(), "Fail to initialize AMD SMI driver!");
 
     amdsmi_version_t version;
     check_status(m_driver_api->get_version(&version),
@@ -74,31 +89,120 @@ template <typename driver_factory> struct service {
    */
   const version &get_version() { return m_version; }
 
+  /** @brief Returns the filter applied during enumeration. */
+  const processor_filter &get_filter() const { return m_filter; }
+
   /**
-   * @brief Enumerates all available processors managed by the AMD SMI driver.
+   * @brief Enumerates the processors accepted by the filter.
    * @return Vector of shared pointers to processor objects.
    * @throws std::runtime_error if processor enumeration fails.
    */
   std::vector<std::shared_ptr<processor<driver_t>>> get_processors() {
     std::vector<std::shared_ptr<processor<driver_t>>> processors{};
+    for_each_processor([&](amdsmi_processor_handle processor_handle,
+                           processor_type_t processor_type) {
+      processors.emplace_back(std::make_shared<processor<driver_t>>(
+          m_driver_api, processor_handle, processor_type));
+    });
+    return processors;
+  }
+
+  /**
+   * @brief Enumerates the accepted processors into a flat processor table.
+   * @return Table with one row per processor; capabilities are not probed.
+   * @throws std::runtime_error if processor enumeration fails.
+   */
+  processor_table<driver_t> get_processor_table() {
+    processor_table<driver_t> table{m_driver_api};
+    for_each_processor([&](amdsmi_processor_handle processor_handle,
+                           processor_type_t processor_type) {
+      table.add(processor_handle, processor_type, identify(processor_handle));
+    });
+    return table;
+  }
+
+  /**
+   * @brief Enumerates the accepted processors with their stable identity.
+   *
+   * The result is meant for processor_table::reconcile(), which only probes
+   * processors it has not seen before.
+   * @return One entry per processor.
+   * @throws std::runtime_error if processor enumeration fails.
+   */
+  std::vector<discovered_processor> discover() {
+    std::vector<discovered_processor> discovered{};
+    for_each_processor([&](amdsmi_processor_handle processor_handle,
+                           processor_type_t processor_type) {
+      discovered.push_back(
+          {processor_handle, processor_type, identify(processor_handle)});
+    });
+    return discovered;
+  }
+
+private:
+  /**
+   * @brief Initializes the driver for the filtered processor types when the
+   * driver takes init flags.
+   */
+  amdsmi_status_t init_driver() {
+    if constexpr (requires(uint64_t flags) { m_driver_api->init(flags); }) {
+      return m_driver_api->init(m_filter.init_flags());
+    } else {
+      return m_driver_api->init();
+    }
+  }
+
+  /**
+   * @brief Invokes @p callback with the handle and type of every processor
+   * accepted by the filter.
+   *
+   * Device indices are counted over every socket, so when the filter also
+   * selects devices, the processors of rejected sockets are still listed and
+   * typed (but never probed). Without a device filter, rejected sockets are
+   * not asked for their processors.
+   * @throws std::runtime_error if processor enumeration fails.
+   */
+  template <typename callback_t>
+  void for_each_processor(callback_t &&callback) {
     auto socket_handles = get_socket_handles();
+    std::map<processor_type_t, uint32_t> device_counts{};
 
-    for (auto &socket_handle : socket_handles) {
-      auto processor_handles = get_processor_handles(socket_handle);
+    for (uint32_t socket = 0; socket < socket_handles.size(); ++socket) {
+      bool accepted_socket = m_filter.accepts_socket(socket);
+      if (!accepted_socket && m_filter.devices.empty()) {
+        continue;
+      }
+      auto processor_handles = get_processor_handles(socket_handles[socket]);
       for (auto &processor_handle : processor_handles) {
-        processor_type_t processor_type;
+        processor_type_t processor_type{};
         check_status(
             m_driver_api->get_processor_type(processor_handle, &processor_type),
             "Failed to get processor type!");
-        // We can implement filter later
-        processors.emplace_back(std::make_shared<processor<driver_t>>(
-            m_driver_api, processor_handle, processor_type));
+        auto device = device_counts[processor_type]++;
+        if (accepted_socket && m_filter.accepts(processor_type, device)) {
+          callback(processor_handle, processor_type);
+        }
       }
-    };
-    return processors;
+    }
+  }
+
+  /**
+   * @brief Returns the stable identity of a processor.
+   *
+   * The PCI address is used when the driver can report it; otherwise the
+   * handle itself identifies the processor.
+   */
+  uint64_t identify(amdsmi_processor_handle processor_handle) {
+    if constexpr (identity_driver<driver_t>) {
+      amdsmi_bdf_t bdf{};
+      if (m_driver_api->get_device_bdf(processor_handle, &bdf) ==
+          AMDSMI_STATUS_SUCCESS) {
+        return bdf.as_uint;
+      }
+    }
+    return handle_identity(processor_handle);
   }
 
-private:
   /**
    * @brief Retrieves all socket handles from the AMD SMI driver.
    * @return Vector of socket handles.
@@ -136,8 +240,10 @@ private:
   }
 
 private:
-  /** Shared pointer to the driver interface used for SMI operations. */
-  std::shared_ptr<driver_t> m_driver_api;
+  /** Binding to the driver interface used for SMI operations. */
+  [[no_unique_address]] driver_binding<driver_t> m_driver_api;
+  /** Processors accepted during enumeration. */
+  processor_filter m_filter;
   /** AMD SMI driver version information. */
   version m_version;
 };
@@ -0,0 +1,333 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/sample_batch.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Frame types of the daemon subscription protocol.
+ */
+enum class frame_type : uint16_t {
+  subscribe = 1,  ///< Client to daemon: a subscription
+  subscribed = 2, ///< Daemon to client: number of processors
+  samples = 3,    ///< Daemon to client: a batch of sample records
+  error = 4,      ///< Daemon to client: message text, then disconnect
+};
+
+constexpr uint32_t protocol_magic = 0x31494d53; ///< "SMI1" in memory order
+constexpr uint16_t protocol_version = 1;
+constexpr std::size_t frame_header_size = 12;
+constexpr std::size_t max_frame_payload = 16 << 20;
+
+/** @brief Column mask selecting every metric_column. */
+constexpr uint32_t all_metric_columns = (1u << metric_column_count) - 1;
+
+/** @brief Processors a subscription can address, one bit each. */
+constexpr std::size_t max_subscribed_processors = 64;
+
+/**
+ * @struct subscription
+ * @brief What a client receives: which processors and metrics, how often
+ * and how many rounds per frame.
+ *
+ * Only the first max_subscribed_processors processors can be selected; a
+ * daemon sampling more rejects subscriptions with an error frame.
+ */
+struct subscription {
+  uint64_t processors{~uint64_t{0}};    ///< Bit i selects processor i
+  uint32_t columns{all_metric_columns}; ///< Bit i selects metric_column i
+  uint32_t period_ms{100};              ///< Time between two records
+  uint32_t batch{1};                    ///< Rounds per samples frame
+};
+
+/**
+ * @brief Bytes of one column's value in a record. VRAM usage is a 64-bit
+ * byte count; every other column fits 32 bits.
+ */
+constexpr std::size_t column_width(metric_column column) {
+  return column == metric_column::memory_usage ? 8 : 4;
+}
+
+/**
+ * @brief Bytes of one record with the selected columns: host time, GPU
+ * clock and processor, then the values in column order.
+ */
+constexpr std::size_t record_size(uint32_t columns) {
+  std::size_t size{20};
+  for (std::size_t column = 0; column < metric_column_count; ++column) {
+    if (columns & (1u << column)) {
+      size += column_width(static_cast<metric_column>(column));
+    }
+  }
+  return size;
+}
+
+/**
+ * @struct sample_record
+ * @brief One processor's metrics at one round, as carried in samples frames.
+ *
+ * Columns not selected by the subscription are zero. The memory_usage
+ * column holds the VRAM bytes in use.
+ */
+struct sample_record {
+  uint64_t host_ns{0};           ///< Host time of the underlying read
+  uint64_t gpu_clock_counter{0}; ///< GPU clock of the underlying read
+  uint32_t processor{0};
+  std::array<uint64_t, metric_column_count> values{};
+
+  uint64_t value(metric_column column) const {
+    return values[static_cast<std::size_t>(column)];
+  }
+};
+
+/**
+ * @brief Builds the record of one processor's sample.
+ * @param vram_used VRAM in use in bytes, from the processor's
+ * memory_snapshot; smi_metrics::memory_usage wraps above 4 GiB.
+ */
+inline sample_record to_sample_record(uint32_t processor,
+                                      const smi_metrics &metrics,
+                                      uint64_t vram_used,
+                                      const sample_timestamp &timestamp) {
+  sample_record record;
+  record.host_ns = timestamp.host_ns();
+  record.gpu_clock_counter = timestamp.gpu_clock_counter;
+  record.processor = processor;
+  for (std::size_t column = 0; column < metric_column_count; ++column) {
+    record.values[column] =
+        metric_value(metrics, static_cast<metric_column>(column));
+  }
+  record.values[static_cast<std::size_t>(metric_column::memory_usage)] =
+      vram_used;
+  return record;
+}
+
+/**
+ * @struct frame
+ * @brief A decoded frame.
+ */
+struct frame {
+  frame_type type;
+  std::string payload;
+};
+
+namespace detail {
+
+template <typename value_t> void put(std::string &out, value_t value) {
+  char bytes[sizeof(value_t)];
+  std::memcpy(bytes, &value, sizeof(value_t));
+  out.append(bytes, sizeof(value_t));
+}
+
+template <typename value_t> value_t take(std::string_view &in) {
+  if (in.size() < sizeof(value_t)) {
+    throw std::runtime_error("Truncated SMI frame");
+  }
+  value_t value;
+  std::memcpy(&value, in.data(), sizeof(value_t));
+  in.remove_prefix(sizeof(value_t));
+  return value;
+}
+
+inline void put_value(std::string &out, metric_column column, uint64_t value) {
+  if (column_width(column) == 8) {
+    put(out, value);
+  } else {
+    put(out, static_cast<uint32_t>(value));
+  }
+}
+
+inline uint64_t take_value(std::string_view &in, metric_column column) {
+  return column_width(column) == 8 ? take<uint64_t>(in) : take<uint32_t>(in);
+}
+
+} // namespace detail
+
+/**
+ * @brief Encodes a frame: 12-byte header, then the payload.
+ *
+ * The protocol is node-local, so integers are in host byte order.
+ */
+inline std::string encode_frame(frame_type type, std::string_view payload) {
+  std::string out;
+  out.reserve(frame_header_size + payload.size());
+  detail::put(out, protocol_magic);
+  detail::put(out, protocol_version);
+  detail::put(out, static_cast<uint16_t>(type));
+  detail::put(out, static_cast<uint32_t>(payload.size()));
+  out.append(payload);
+  return out;
+}
+
+/** @brief Encodes the payload of a subscribe frame. */
+inline std::string encode_subscription(const subscription &request) {
+  std::string out;
+  detail::put(out, request.processors);
+  detail::put(out, request.columns);
+  detail::put(out, request.period_ms);
+  detail::put(out, request.batch);
+  return out;
+}
+
+/**
+ * @brief Decodes the payload of a subscribe frame.
+ * @throws std::runtime_error if the payload is malformed, or selects no
+ * column or a column outside all_metric_columns.
+ */
+inline subscription decode_subscription(std::string_view payload) {
+  subscription request;
+  request.processors = detail::take<uint64_t>(payload);
+  request.columns = detail::take<uint32_t>(payload);
+  request.period_ms = detail::take<uint32_t>(payload);
+  request.batch = detail::take<uint32_t>(payload);
+  if (request.period_ms == 0 || request.batch == 0 || request.columns == 0 ||
+      (request.columns & ~all_metric_columns) != 0) {
+    throw std::runtime_error("Invalid SMI subscription");
+  }
+  return request;
+}
+
+/**
+ * @brief Appends one record to a samples payload; only the selected
+ * columns are written.
+ */
+inline void encode_record(std::string &payload, uint32_t columns,
+                          const sample_record &record) {
+  detail::put(payload, record.host_ns);
+  detail::put(payload, record.gpu_clock_counter);
+  detail::put(payload, record.processor);
+  for (std::size_t column = 0; column < metric_column_count; ++column) {
+    if (columns & (1u << column)) {
+      detail::put_value(payload, static_cast<metric_column>(column),
+                        record.values[column]);
+    }
+  }
+}
+
+/**
+ * @brief Starts a samples payload for records with the selected columns.
+ */
+inline std::string begin_samples(uint32_t columns) {
+  std::string payload;
+  detail::put(payload, columns);
+  return payload;
+}
+
+/**
+ * @brief Decodes a samples payload.
+ *
+ * Column bits outside all_metric_columns are ignored, as encode_record()
+ * writes no value for them.
+ * @throws std::runtime_error if the payload is malformed.
+ */
+inline std::vector<sample_record> decode_samples(std::string_view payload) {
+  auto columns = detail::take<uint32_t>(payload) & all_metric_columns;
+  auto size = record_size(columns);
+  if (payload.size() % size != 0) {
+    throw std::runtime_error("Truncated SMI samples frame");
+  }
+  std::vector<sample_record> records(payload.size() / size);
+  for (auto &record : records) {
+    record.host_ns = detail::take<uint64_t>(payload);
+    record.gpu_clock_counter = detail::take<uint64_t>(payload);
+    record.processor = detail::take<uint32_t>(payload);
+    for (std::size_t column = 0; column < metric_column_count; ++column) {
+      if (columns & (1u << column)) {
+        record.values[column] =
+            detail::take_value(payload, static_cast<metric_column>(column));
+      }
+    }
+  }
+  return records;
+}
+
+/**
+ * @class frame_reader
+ * @brief Reassembles frames from a byte stream.
+ */
+class frame_reader {
+public:
+  /** @brief Appends received bytes. */
+  void feed(std::string_view bytes) { m_buffer.append(bytes); }
+
+  /**
+   * @brief Returns the next complete frame, if any.
+   * @throws std::runtime_error on a bad header or oversized frame.
+   */
+  std::optional<frame> next() {
+    std::string_view pending{m_buffer};
+    pending.remove_prefix(m_offset);
+    if (pending.size() < frame_header_size) {
+      compact();
+      return std::nullopt;
+    }
+    auto header = pending;
+    auto magic = detail::take<uint32_t>(header);
+    auto version = detail::take<uint16_t>(header);
+    auto type = detail::take<uint16_t>(header);
+    auto length = detail::take<uint32_t>(header);
+    if (magic != protocol_magic || version != protocol_version ||
+        length > max_frame_payload) {
+      throw std::runtime_error("Bad SMI frame header");
+    }
+    if (header.size() < length) {
+      compact();
+      return std::nullopt;
+    }
+    m_offset += frame_header_size + length;
+    return frame{static_cast<frame_type>(type),
+                 std::string{header.substr(0, length)}};
+  }
+
+private:
+  void compact() {
+    m_buffer.erase(0, m_offset);
+    m_offset = 0;
+  }
+
+  std::string m_buffer;
+  std::size_t m_offset{0};
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
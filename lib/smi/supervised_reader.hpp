@@ -0,0 +1,340 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sampler_overhead.hpp"
+#include "smi/thread_placement.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @struct call_health
+ * @brief Driver call statistics of one processor under supervision.
+ */
+struct call_health {
+  uint64_t completed{0};            ///< Reads finished before the deadline
+  uint64_t timeouts{0};             ///< Rounds the processor was missing
+  uint32_t consecutive_timeouts{0}; ///< Missed rounds since the last success
+  uint64_t last_latency_ns{0};      ///< Duration of the latest finished read
+  uint64_t max_latency_ns{0};       ///< Longest finished read
+  bool hung{false};                 ///< Hang threshold reached
+};
+
+/**
+ * @class supervised_reader
+ * @tparam driver The driver interface type of the table.
+ * @brief Reads processor table rows on per-processor worker threads with a
+ * per-round deadline.
+ *
+ * Each processor gets its own worker, started on its first read, so one
+ * stuck driver call (for example during a GPU reset) cannot delay the
+ * others. A round waits for the dispatched reads until the deadline; reads
+ * that finish in time are committed to the table, the rest are marked
+ * missing (AMDSMI_STATUS_TIMEOUT) and their late results are discarded. A
+ * processor whose previous call is still running is not called again and is
+ * missing as well, until the call returns.
+ *
+ * Workers own their state and a copy of the driver binding through shared
+ * pointers. Destruction joins idle workers and detaches those still inside
+ * a driver call; a detached worker exits as soon as its call returns, so a
+ * hung driver never blocks the owner. abandoned_workers() counts them.
+ *
+ * Workers run with the placement given to set_placement(), so pinning the
+ * sampler also keeps its driver calls off the profiled workload's CPUs.
+ *
+ * read() must be called from one thread at a time, and the table must not
+ * be changed during a read().
+ */
+template <typename driver> class supervised_reader {
+public:
+  /**
+   * @brief Constructs a reader without starting any worker.
+   * @param table Processor table to read; must outlive the reader.
+   * @param deadline Time a round waits for its reads.
+   * @param hang_threshold Consecutive missed rounds after which a processor
+   * is reported as hung.
+   */
+  supervised_reader(processor_table<driver> &table,
+                    std::chrono::nanoseconds deadline,
+                    uint32_t hang_threshold = 3)
+      : m_table{table}, m_deadline{deadline},
+        m_hang_threshold{hang_threshold},
+        m_shared{std::make_shared<shared_state>()} {
+    resize(table.size());
+  }
+
+  supervised_reader(const supervised_reader &) = delete;
+  supervised_reader &operator=(const supervised_reader &) = delete;
+
+  ~supervised_reader() {
+    std::vector<std::thread> idle;
+    {
+      std::lock_guard lock{m_shared->mutex};
+      m_shared->stopping = true;
+      for (auto &current : m_lanes) {
+        if (!current->worker.joinable()) {
+          continue;
+        }
+        if (current->state == lane_state::running) {
+          current->worker.detach();
+          ++abandoned_count();
+        } else {
+          idle.push_back(std::move(current->worker));
+        }
+        current->wake.notify_all();
+      }
+    }
+    for (auto &worker : idle) {
+      worker.join();
+    }
+  }
+
+  /** @brief Time a round waits for its reads. */
+  std::chrono::nanoseconds deadline() const { return m_deadline; }
+
+  /**
+   * @brief Sets the CPU affinity and priority of the workers, including
+   * those already running.
+   *
+   * Workers started later apply it themselves; as it was applied once
+   * here, a failure there keeps the worker as created.
+   * @throws std::system_error or std::runtime_error as
+   * apply_thread_placement().
+   */
+  void set_placement(const thread_placement &placement) {
+    std::lock_guard lock{m_shared->mutex};
+    m_shared->placement = placement;
+    for (auto &current : m_lanes) {
+      if (current->worker.joinable() && !placement.empty()) {
+        apply_thread_placement(current->worker.native_handle(), placement);
+      }
+    }
+  }
+
+  /**
+   * @brief Workers detached, across all readers, because their driver call
+   * was still running when the reader was destroyed.
+   */
+  static uint64_t abandoned_workers() { return abandoned_count().load(); }
+
+  /**
+   * @brief Adds lanes for rows appended to the table.
+   */
+  void resize(std::size_t rows) {
+    std::lock_guard lock{m_shared->mutex};
+    while (m_lanes.size() < rows) {
+      m_lanes.push_back(std::make_shared<lane>());
+    }
+    m_health.resize(m_lanes.size());
+  }
+
+  /**
+   * @brief Reads the due metric groups of every row within the deadline.
+   * @param due Groups to refresh per row; when empty, every row with
+   * capabilities is read in full, like processor_table::sample().
+   * @return Number of rows whose read finished in time.
+   */
+  std::size_t read(std::span<const group_mask> due) {
+    auto capabilities = m_table.capabilities();
+    std::unique_lock lock{m_shared->mutex};
+    m_dispatched.clear();
+    for (std::size_t row = 0; row < m_table.size(); ++row) {
+      group_mask groups =
+          due.empty() ? (capabilities[row] != 0 ? all_metric_groups : 0)
+                      : due[row];
+      if (groups == 0) {
+        continue;
+      }
+      auto &current = *m_lanes[row];
+      if (current.state == lane_state::pending ||
+          current.state == lane_state::running) {
+        m_table.mark_missing(row);
+        record_timeout(row);
+        continue;
+      }
+      m_table.prepare_read(row, groups, current.request);
+      current.state = lane_state::pending;
+      if (!current.worker.joinable()) {
+        current.worker =
+            std::thread(work, m_shared, m_lanes[row], m_table.driver_api());
+      }
+      current.wake.notify_one();
+      m_dispatched.push_back(row);
+    }
+
+    m_shared->finished.wait_for(lock, m_deadline, [this] {
+      for (auto row : m_dispatched) {
+        if (m_lanes[row]->state != lane_state::done) {
+          return false;
+        }
+      }
+      return true;
+    });
+
+    std::size_t completed{0};
+    for (auto row : m_dispatched) {
+      auto &current = *m_lanes[row];
+      if (current.state != lane_state::done) {
+        m_table.mark_missing(row);
+        record_timeout(row);
+        continue;
+      }
+      m_table.commit_read(row, current.request);
+      current.state = lane_state::idle;
+      auto &health = m_health[row];
+      ++health.completed;
+      health.consecutive_timeouts = 0;
+      health.hung = false;
+      health.last_latency_ns = current.latency_ns;
+      health.max_latency_ns = std::max(health.max_latency_ns,
+                                       current.latency_ns);
+      ++completed;
+    }
+    return completed;
+  }
+
+  /**
+   * @brief Returns the call statistics of every row.
+   * @note Safe to call from any thread.
+   */
+  std::vector<call_health> health() const {
+    std::lock_guard lock{m_shared->mutex};
+    return m_health;
+  }
+
+  /**
+   * @brief CPU time the workers have spent in driver calls so far, measured
+   * with CLOCK_THREAD_CPUTIME_ID on each worker. A call is counted when it
+   * returns, including late calls whose result was discarded.
+   * @note Safe to call from any thread.
+   */
+  uint64_t worker_cpu_time_ns() const {
+    std::lock_guard lock{m_shared->mutex};
+    return m_shared->worker_cpu_ns;
+  }
+
+private:
+  enum class lane_state { idle, pending, running, done };
+
+  /** @brief State the reader shares with its workers. */
+  struct shared_state {
+    std::mutex mutex; ///< Guards lane states, health and stopping
+    std::condition_variable finished;
+    bool stopping{false};
+    uint64_t worker_cpu_ns{0};    ///< CPU time of finished driver calls
+    thread_placement placement{}; ///< Of every worker
+  };
+
+  struct lane {
+    row_read request;
+    lane_state state{lane_state::idle};
+    uint64_t latency_ns{0};
+    std::condition_variable wake;
+    std::thread worker;
+  };
+
+  /**
+   * @brief Worker loop. Touches only what it owns a reference to, so it can
+   * outlive the reader and the table.
+   */
+  static void work(std::shared_ptr<shared_state> shared,
+                   std::shared_ptr<lane> owned,
+                   driver_binding<driver> driver_api) {
+    auto &current = *owned;
+    std::unique_lock lock{shared->mutex};
+    if (!shared->placement.empty()) {
+      try {
+        apply_thread_placement(pthread_self(), shared->placement);
+      } catch (const std::exception &) {
+        // Applied before by set_placement(); keep the worker as created.
+      }
+    }
+    for (;;) {
+      current.wake.wait(lock, [&] {
+        return shared->stopping || current.state == lane_state::pending;
+      });
+      if (shared->stopping) {
+        return;
+      }
+      current.state = lane_state::running;
+      lock.unlock();
+      auto begin = host_timestamp_ns();
+      auto cpu_begin = thread_cpu_time_ns();
+      processor_table<driver>::perform_read(driver_api, current.request);
+      auto cpu_time = thread_cpu_time_ns() - cpu_begin;
+      auto latency = host_timestamp_ns() - begin;
+      lock.lock();
+      shared->worker_cpu_ns += cpu_time;
+      current.latency_ns = latency;
+      current.state = lane_state::done;
+      shared->finished.notify_all();
+    }
+  }
+
+  void record_timeout(std::size_t row) {
+    auto &health = m_health[row];
+    ++health.timeouts;
+    ++health.consecutive_timeouts;
+    health.hung = health.consecutive_timeouts >= m_hang_threshold;
+  }
+
+  static std::atomic<uint64_t> &abandoned_count() {
+    static std::atomic<uint64_t> count{0};
+    return count;
+  }
+
+  processor_table<driver> &m_table;
+  std::chrono::nanoseconds m_deadline;
+  uint32_t m_hang_threshold;
+
+  std::shared_ptr<shared_state> m_shared;
+  std::vector<std::shared_ptr<lane>> m_lanes; ///< One per row
+  std::vector<std::size_t> m_dispatched;      ///< Rows read this round
+  std::vector<call_health> m_health;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
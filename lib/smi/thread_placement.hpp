@@ -0,0 +1,155 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Parses a Linux CPU list such as "0-3,8,10-11".
+ * @throws std::invalid_argument if the list is malformed.
+ */
+inline std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::size_t position{0};
+  while (position < list.size()) {
+    auto end = list.find(',', position);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    auto range = list.substr(position, end - position);
+    position = end + 1;
+    if (range.find_first_not_of(" \t\n") == std::string::npos) {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    if (first < 0 || last < first) {
+      throw std::invalid_argument("Invalid CPU range: " + range);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+/**
+ * @brief Returns the CPUs of a NUMA node as listed by sysfs.
+ * @param node NUMA node index.
+ * @param sysfs_root Directory holding the node<N> entries.
+ * @throws std::runtime_error if the node does not exist.
+ */
+inline std::vector<int>
+numa_node_cpus(int node,
+               const std::string &sysfs_root = "/sys/devices/system/node") {
+  std::ifstream file{sysfs_root + "/node" + std::to_string(node) +
+                     "/cpulist"};
+  std::string list;
+  if (!file || !std::getline(file, list)) {
+    throw std::runtime_error("Unknown NUMA node " + std::to_string(node));
+  }
+  return parse_cpu_list(list);
+}
+
+/**
+ * @struct thread_placement
+ * @brief Where and at which priority the sampler thread runs.
+ *
+ * An empty placement leaves the thread as created. Pinning the sampler to
+ * CPUs next to the GPUs, away from the profiled workload, keeps it from
+ * perturbing what it measures.
+ */
+struct thread_placement {
+  std::vector<int> cpus{};  ///< CPUs to run on; empty keeps the default
+  int numa_node{-1};        ///< Adds the node's CPUs when not negative
+  bool realtime{false};     ///< Use SCHED_FIFO instead of SCHED_OTHER
+  int realtime_priority{1}; ///< SCHED_FIFO priority when realtime is set
+
+  bool empty() const { return cpus.empty() && numa_node < 0 && !realtime; }
+
+  /** @brief Every CPU the thread may run on; empty for no restriction. */
+  std::vector<int> cpu_set() const {
+    auto all = cpus;
+    if (numa_node >= 0) {
+      auto node = numa_node_cpus(numa_node);
+      all.insert(all.end(), node.begin(), node.end());
+    }
+    return all;
+  }
+};
+
+/**
+ * @brief Applies a placement to a running thread.
+ * @throws std::system_error if the affinity or scheduling policy cannot be
+ * set, for example without the privilege to use real-time scheduling.
+ * @throws std::runtime_error if the NUMA node is unknown.
+ */
+inline void apply_thread_placement(pthread_t thread,
+                                   const thread_placement &placement) {
+  auto cpus = placement.cpu_set();
+  if (!cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        throw std::system_error(EINVAL, std::generic_category(),
+                                "Invalid sampler CPU");
+      }
+      CPU_SET(cpu, &set);
+    }
+    if (int error = pthread_setaffinity_np(thread, sizeof(set), &set)) {
+      throw std::system_error(error, std::generic_category(),
+                              "Failed to set sampler CPU affinity");
+    }
+  }
+  if (placement.realtime) {
+    sched_param parameters{};
+    parameters.sched_priority = placement.realtime_priority;
+    if (int error = pthread_setschedparam(thread, SCHED_FIFO, &parameters)) {
+      throw std::system_error(error, std::generic_category(),
+                              "Failed to set sampler real-time priority");
+    }
+  }
+}
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,215 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include "smi/processor.hpp"
+#include "smi/processor_table.hpp"
+
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @brief Family of throttlers limiting a processor's clocks.
+ *
+ * Follows the layout of the ASIC-independent throttle status: each cause
+ * owns 16 consecutive bits (PPT/SPL limits, TDC/EDC current limits,
+ * temperature limits, then PROCHOT, FIT and the rest).
+ */
+enum class throttle_cause : uint8_t { power, current, thermal, other };
+
+constexpr std::size_t throttle_cause_count = 4;
+
+/**
+ * @brief Throttle status bits that belong to @p cause.
+ */
+constexpr uint64_t throttle_cause_bits(throttle_cause cause) {
+  return uint64_t{0xffff} << (16 * static_cast<unsigned>(cause));
+}
+
+/**
+ * @struct throttle_event
+ * @brief One finished interval during which a processor was throttled.
+ *
+ * Times are host times of the samples that observed the start and the end,
+ * so the duration is accurate to the clocks group sampling period.
+ */
+struct throttle_event {
+  std::size_t row{0};                         ///< Processor table row
+  throttle_cause cause{throttle_cause::power}; ///< Throttler family
+  uint64_t reasons{0};  ///< Every throttler bit seen during the interval
+  uint64_t begin_ns{0}; ///< First sample with the cause active
+  uint64_t end_ns{0};   ///< First sample with the cause cleared
+
+  uint64_t duration_ns() const { return end_ns - begin_ns; }
+};
+
+/**
+ * @class throttle_tracker
+ * @brief Turns sampled throttle status bits into timed throttle intervals.
+ *
+ * Each processor has one interval per throttle_cause. An interval opens on
+ * the first sample reporting any bit of its cause and closes, producing a
+ * throttle_event, on the first sample reporting none. Per cause the tracker
+ * also accumulates the total throttled time of closed intervals.
+ *
+ * Not thread-safe; updates run on the sampling thread.
+ */
+class throttle_tracker {
+public:
+  /**
+   * @brief Constructs a tracker for @p rows processors, none throttled.
+   */
+  explicit throttle_tracker(std::size_t rows = 0) { resize(rows); }
+
+  /** @brief Grows the tracker to @p rows processors. */
+  void resize(std::size_t rows) {
+    if (rows > m_rows.size()) {
+      m_rows.resize(rows);
+    }
+  }
+
+  /**
+   * @brief Forgets the state of a row, e.g. for a retired processor. Open
+   * intervals are dropped without an event.
+   */
+  void reset_row(std::size_t row) { m_rows[row] = row_state{}; }
+
+  /**
+   * @brief Applies one throttle status sample of a row.
+   * @param row Processor table row.
+   * @param status ASIC-independent throttle status bits.
+   * @param host_ns Host time of the sample.
+   * @param ended Receives the intervals closed by this sample; appended to.
+   * @return Number of intervals closed.
+   */
+  std::size_t update(std::size_t row, uint64_t status, uint64_t host_ns,
+                     std::vector<throttle_event> &ended) {
+    auto &state = m_rows[row];
+    std::size_t closed{0};
+    for (std::size_t index = 0; index < throttle_cause_count; ++index) {
+      auto cause = static_cast<throttle_cause>(index);
+      auto bits = status & throttle_cause_bits(cause);
+      auto &current = state.intervals[index];
+      if (bits != 0) {
+        if (!current.open) {
+          current = {true, host_ns, 0};
+        }
+        current.reasons |= bits;
+      } else if (current.open) {
+        ended.push_back({row, cause, current.reasons, current.begin_ns,
+                         std::max(host_ns, current.begin_ns)});
+        state.throttled_ns[index] += ended.back().duration_ns();
+        current = interval{};
+        ++closed;
+      }
+    }
+    return closed;
+  }
+
+  /**
+   * @brief Applies the latest sample of every row whose clocks group was
+   * read successfully.
+   * @param table The sampled table.
+   * @param refreshed Groups refreshed per row; all groups when empty.
+   * @param ended Receives the intervals closed by this round; appended to.
+   * @return Number of intervals closed.
+   */
+  template <typename driver>
+  std::size_t update(const processor_table<driver> &table,
+                     std::span<const group_mask> refreshed,
+                     std::vector<throttle_event> &ended) {
+    auto statuses = table.statuses();
+    auto capabilities = table.capabilities();
+    auto samples = table.samples();
+    auto timestamps = table.timestamps();
+    resize(table.size());
+    std::size_t closed{0};
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      group_mask groups =
+          refreshed.empty() ? all_metric_groups : refreshed[row];
+      if ((groups & group_bit(metric_group::clocks)) == 0 ||
+          (capabilities[row] & capability::throttle_status) == 0 ||
+          statuses[row] != AMDSMI_STATUS_SUCCESS) {
+        continue;
+      }
+      closed += update(row, samples[row].throttle_status,
+                       timestamps[row].host_end_ns, ended);
+    }
+    return closed;
+  }
+
+  /**
+   * @brief Whether @p cause currently throttles a row.
+   */
+  bool active(std::size_t row, throttle_cause cause) const {
+    return m_rows[row].intervals[static_cast<std::size_t>(cause)].open;
+  }
+
+  /**
+   * @brief Host time at which the open interval of @p cause began, or zero
+   * when the cause is not active.
+   */
+  uint64_t active_since(std::size_t row, throttle_cause cause) const {
+    const auto &current =
+        m_rows[row].intervals[static_cast<std::size_t>(cause)];
+    return current.open ? current.begin_ns : 0;
+  }
+
+  /**
+   * @brief Total time of the closed intervals of @p cause on a row.
+   */
+  uint64_t throttled_ns(std::size_t row, throttle_cause cause) const {
+    return m_rows[row].throttled_ns[static_cast<std::size_t>(cause)];
+  }
+
+private:
+  struct interval {
+    bool open{false};
+    uint64_t begin_ns{0};
+    uint64_t reasons{0};
+  };
+
+  struct row_state {
+    std::array<interval, throttle_cause_count> intervals{};
+    std::array<uint64_t, throttle_cause_count> throttled_ns{};
+  };
+
+  std::vector<row_state> m_rows;
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,118 @@
+// Copyright (c) 2018-2025 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// with the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// * Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+//
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimers in the
+// documentation and/or other materials provided with the distribution.
+//
+// * Neither the names of Advanced Micro Devices, Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this Software without specific prior written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys {
+namespace amd_smi {
+
+/**
+ * @class timer_wheel
+ * @tparam payload_t Value delivered when a timer expires.
+ * @brief Hashed timing wheel with a fixed number of slots.
+ *
+ * Time advances in whole ticks. A timer due in d ticks is stored in slot
+ * (now + d) % slot_count together with its absolute deadline, so scheduling
+ * and expiring are O(1) per timer regardless of how far ahead it is due.
+ * Timers further than one revolution away stay in their slot until their
+ * deadline comes around.
+ */
+template <typename payload_t> class timer_wheel {
+public:
+  /**
+   * @brief Constructs an empty wheel.
+   * @param slot_count Number of slots; at least one.
+   */
+  explicit timer_wheel(std::size_t slot_count)
+      : m_slots(slot_count == 0 ? 1 : slot_count) {}
+
+  /** @brief Current tick. */
+  uint64_t now() const { return m_now; }
+
+  /** @brief Number of pending timers. */
+  std::size_t size() const { return m_size; }
+
+  /**
+   * @brief Schedules @p payload to expire @p delay ticks from now.
+   * @param delay Ticks until expiry; zero is treated as one.
+   * @param payload Value delivered on expiry.
+   */
+  void schedule(uint64_t delay, payload_t payload) {
+    uint64_t deadline = m_now + (delay == 0 ? 1 : delay);
+    m_slots[deadline % m_slots.size()].push_back(
+        {deadline, std::move(payload)});
+    ++m_size;
+  }
+
+  /**
+   * @brief Advances one tick and delivers every timer that expires on it.
+   * @param on_expired Called as on_expired(payload) for each expired timer.
+   * It may schedule new timers.
+   * @return Number of expired timers.
+   */
+  template <typename callback_t> std::size_t advance(callback_t &&on_expired) {
+    ++m_now;
+    auto &slot = m_slots[m_now % m_slots.size()];
+
+    m_expired.clear();
+    for (std::size_t index = 0; index < slot.size();) {
+      if (slot[index].deadline == m_now) {
+        m_expired.push_back(std::move(slot[index].payload));
+        slot[index] = std::move(slot.back());
+        slot.pop_back();
+      } else {
+        ++index;
+      }
+    }
+    m_size -= m_expired.size();
+
+    for (auto &payload : m_expired) {
+      on_expired(payload);
+    }
+    return m_expired.size();
+  }
+
+private:
+  struct entry {
+    uint64_t deadline;
+    payload_t payload;
+  };
+
+  std::vector<std::vector<entry>> m_slots;
+  std::vector<payload_t> m_expired;
+  uint64_t m_now{0};
+  std::size_t m_size{0};
+};
+
+} // namespace amd_smi
+} // namespace rocprofsys
@@ -0,0 +1,174 @@
+#include "smi/capture_merge.hpp"
+#include "smi/capture_reader.hpp"
+#include "smi/capture_writer.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+using smi::metric_column;
+
+namespace {
+std::filesystem::path temp_directory(const std::string &name) {
+  auto path = std::filesystem::path{::testing::TempDir()} /
+              (name + std::to_string(getpid()));
+  std::filesystem::remove_all(path);
+  return path;
+}
+
+/**
+ * Writes a node capture with @p processors processors sampled every 1000 ns
+ * from @p first_ns, then sets every block's clock offset to @p offset_ns.
+ */
+void write_node(const std::filesystem::path &directory,
+                std::size_t processors, uint64_t first_ns, int64_t offset_ns,
+                uint64_t rounds) {
+  {
+    smi::capture_options options;
+    options.directory = directory;
+    options.block_size = 4096;
+    smi::capture_writer writer{options};
+    std::vector<smi::sample_record> round(processors);
+    for (uint64_t r = 0; r < rounds; ++r) {
+      for (std::size_t id = 0; id < processors; ++id) {
+        round[id] = {};
+        // Later processors are read earlier within a round.
+        round[id].host_ns = first_ns + r * 1000 + (processors - id);
+        round[id].processor = static_cast<uint32_t>(id);
+        round[id].values[static_cast<std::size_t>(
+            metric_column::current_socket_power)] = static_cast<uint32_t>(r);
+      }
+      writer.append_wait(round);
+    }
+  }
+  auto segment = directory / smi::capture_segment_name("smi-capture", 0);
+  auto size = std::filesystem::file_size(segment);
+  std::fstream file{segment, std::ios::in | std::ios::out | std::ios::binary};
+  for (std::size_t block = 0; block < size; block += 4096) {
+    file.seekp(static_cast<std::streamoff>(
+        block + offsetof(smi::capture_block_header, realtime_offset_ns)));
+    file.write(reinterpret_cast<const char *>(&offset_ns), sizeof(offset_ns));
+  }
+}
+} // namespace
+
+TEST(CaptureFormatTest, RealtimeOffsetMatchesSystemClock) {
+  auto offset = smi::measure_realtime_offset_ns();
+  auto realtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+  auto estimate = static_cast<int64_t>(smi::host_timestamp_ns()) + offset;
+  EXPECT_LT(std::abs(estimate - realtime), 10'000'000);
+}
+
+TEST(CaptureMergeTest, MergesNodesOnSystemClock) {
+  auto node_a = temp_directory("smi-node-a-");
+  auto node_b = temp_directory("smi-node-b-");
+  auto merged = temp_directory("smi-merged-");
+  // Node B's monotonic clock started 400 ns later relative to real time.
+  write_node(node_a, 2, 10'000, 1'000'000'000, 200);
+  write_node(node_b, 3, 9'600, 1'000'000'500, 200);
+
+  std::vector<smi::merge_input> inputs{{node_a}, {node_b}};
+  smi::capture_options output;
+  output.directory = merged;
+  output.block_size = 4096;
+  auto summary = smi::merge_captures(inputs, output);
+  EXPECT_EQ(summary.records, 200 * 5);
+  EXPECT_EQ(summary.processor_base, (std::vector<uint32_t>{0, 2}));
+  EXPECT_EQ(summary.first_ns, 1'000'010'000 + 1);
+  EXPECT_EQ(summary.output.dropped_batches, 0);
+
+  auto reader = smi::capture_reader::open_directory(merged);
+  EXPECT_EQ(reader.record_count(), 200 * 5);
+  uint64_t previous{0};
+  std::vector<uint64_t> per_processor(5);
+  reader.for_each_record(0, ~uint64_t{0}, [&](const smi::sample_record &r) {
+    EXPECT_GE(r.host_ns, previous);
+    previous = r.host_ns;
+    ASSERT_LT(r.processor, 5);
+    ++per_processor[r.processor];
+  });
+  EXPECT_EQ(per_processor, std::vector<uint64_t>(5, 200));
+
+  smi::range_query request;
+  request.processor = 4; // Node B, processor 2
+  request.column = metric_column::current_socket_power;
+  request.begin_ns = 1'000'010'100;
+  request.end_ns = 1'000'012'100;
+  auto result = reader.query(request);
+  EXPECT_EQ(result.count, 2);
+  EXPECT_EQ(result.min, 0);
+  EXPECT_EQ(result.max, 1);
+
+  for (const auto &path : {node_a, node_b, merged}) {
+    std::filesystem::remove_all(path);
+  }
+}
+
+TEST(CaptureMergeTest, IndexesProcessorsPastSixtyFour) {
+  auto node_a = temp_directory("smi-wide-a-");
+  auto node_b = temp_directory("smi-wide-b-");
+  auto merged = temp_directory("smi-wide-merged-");
+  auto remerged = temp_directory("smi-wide-remerged-");
+  write_node(node_a, 40, 10'000, 0, 20);
+  write_node(node_b, 40, 10'000, 0, 20);
+
+  smi::capture_options output;
+  output.directory = merged;
+  output.block_size = 4096;
+  std::vector<smi::merge_input> inputs{{node_a}, {node_b}};
+  auto summary = smi::merge_captures(inputs, output);
+  EXPECT_EQ(summary.processor_base, (std::vector<uint32_t>{0, 40}));
+
+  auto reader = smi::capture_reader::open_directory(merged);
+  smi::range_query request;
+  request.processor = 70; // Node B, processor 30
+  request.column = metric_column::current_socket_power;
+  EXPECT_EQ(reader.query(request).count, 20);
+  request.processor = 80; // Past every node
+  EXPECT_EQ(reader.query(request).count, 0);
+
+  // Merging the merged capture again counts all 80 processors.
+  output.directory = remerged;
+  inputs = {{merged}, {node_a}};
+  summary = smi::merge_captures(inputs, output);
+  EXPECT_EQ(summary.processor_base, (std::vector<uint32_t>{0, 80}));
+
+  for (const auto &path : {node_a, node_b, merged, remerged}) {
+    std::filesystem::remove_all(path);
+  }
+}
+
+TEST(CaptureMergeTest, IgnoresDiskBudgetOfTheOutput) {
+  auto node_a = temp_directory("smi-large-a-");
+  auto node_b = temp_directory("smi-large-b-");
+  auto merged = temp_directory("smi-large-merged-");
+  write_node(node_a, 4, 10'000, 0, 500);
+  write_node(node_b, 4, 10'000, 0, 500);
+
+  // A live capture with these options would keep only two blocks.
+  smi::capture_options output;
+  output.directory = merged;
+  output.block_size = 4096;
+  output.segment_size = 4096;
+  output.disk_budget = 8192;
+  std::vector<smi::merge_input> inputs{{node_a}, {node_b}};
+  auto summary = smi::merge_captures(inputs, output);
+  EXPECT_EQ(summary.output.segments_removed, 0);
+  EXPECT_GT(summary.output.segments_created, 2);
+
+  auto reader = smi::capture_reader::open_directory(merged);
+  EXPECT_EQ(reader.record_count(), 2 * 4 * 500);
+
+  for (const auto &path : {node_a, node_b, merged}) {
+    std::filesystem::remove_all(path);
+  }
+}
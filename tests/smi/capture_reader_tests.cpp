@@ -0,0 +1,207 @@
+#include "smi/capture_reader.hpp"
+#include "smi/capture_writer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+using smi::metric_column;
+
+namespace {
+constexpr std::size_t processors = 4;
+constexpr uint64_t rounds = 1000;
+constexpr uint64_t period_ns = 10'000'000;
+
+uint32_t hotspot(uint64_t round, std::size_t id) {
+  return static_cast<uint32_t>(40 + (round * 7 + id * 13) % 60);
+}
+
+/** VRAM bytes in use; above 4 GiB for most rounds. */
+uint64_t vram_used(uint64_t round, std::size_t id) {
+  return (round + id) << 24;
+}
+
+/** Writes @c rounds rounds of @c processors records to a fresh capture. */
+std::filesystem::path write_capture(const std::string &name) {
+  auto directory = std::filesystem::path{::testing::TempDir()} /
+                   (name + std::to_string(getpid()));
+  std::filesystem::remove_all(directory);
+  smi::capture_options options;
+  options.directory = directory;
+  options.block_size = 4096;
+  options.segment_size = 64 * 4096;
+  smi::capture_writer writer{options};
+  std::vector<smi::sample_record> round(processors);
+  for (uint64_t r = 0; r < rounds; ++r) {
+    for (std::size_t id = 0; id < processors; ++id) {
+      round[id] = {};
+      round[id].host_ns = (r + 1) * period_ns;
+      round[id].processor = static_cast<uint32_t>(id);
+      round[id].values[static_cast<std::size_t>(
+          metric_column::hotspot_temperature)] = hotspot(r, id);
+      round[id].values[static_cast<std::size_t>(metric_column::memory_usage)] =
+          vram_used(r, id);
+    }
+    writer.append_wait(round);
+  }
+  return directory;
+}
+
+std::vector<uint32_t> expected_values(uint32_t processor, uint64_t begin_ns,
+                                      uint64_t end_ns) {
+  std::vector<uint32_t> values;
+  for (uint64_t r = 0; r < rounds; ++r) {
+    auto host_ns = (r + 1) * period_ns;
+    if (host_ns >= begin_ns && host_ns < end_ns) {
+      values.push_back(hotspot(r, processor));
+    }
+  }
+  return values;
+}
+} // namespace
+
+TEST(CaptureReaderTest, RangeAggregatesMatchBruteForce) {
+  auto directory = write_capture("smi-reader-");
+  auto reader = smi::capture_reader::open_directory(directory);
+  EXPECT_EQ(reader.record_count(), processors * rounds);
+
+  smi::range_query request;
+  request.processor = 3;
+  request.column = metric_column::hotspot_temperature;
+  request.begin_ns = 200 * period_ns;
+  request.end_ns = 300 * period_ns;
+  request.quantiles = {0.5, 0.99, 1.0};
+  auto result = reader.query(request, 4);
+
+  auto values = expected_values(3, request.begin_ns, request.end_ns);
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(result.count, values.size());
+  EXPECT_EQ(result.min, values.front());
+  EXPECT_EQ(result.max, values.back());
+  uint64_t sum{0};
+  for (auto value : values) {
+    sum += value;
+  }
+  EXPECT_EQ(result.sum, sum);
+  ASSERT_EQ(result.quantiles.size(), 3);
+  EXPECT_EQ(result.quantiles[0], values[values.size() / 2 - 1]);
+  EXPECT_EQ(result.quantiles[1], values[98]);
+  EXPECT_EQ(result.quantiles[2], values.back());
+
+  // The time index leaves most blocks unread.
+  EXPECT_GT(result.blocks_skipped, 5 * result.blocks_scanned);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureReaderTest, SystemClockRangesUseBlockOffsets) {
+  auto directory = write_capture("smi-wallclock-");
+  auto reader = smi::capture_reader::open_directory(directory);
+  auto offset = reader.block_header(0).realtime_offset_ns;
+
+  // Half a period around each bound absorbs the per-block offset jitter.
+  auto wall_clock = [&](uint64_t host_ns) {
+    return std::chrono::system_clock::time_point{
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds{static_cast<int64_t>(host_ns) + offset -
+                                     static_cast<int64_t>(period_ns / 2)})};
+  };
+  smi::range_query request;
+  request.processor = 1;
+  request.column = metric_column::hotspot_temperature;
+  request.between(wall_clock(200 * period_ns), wall_clock(300 * period_ns));
+  auto result = reader.query(request);
+
+  auto values = expected_values(1, 200 * period_ns - period_ns / 2,
+                                300 * period_ns - period_ns / 2);
+  ASSERT_EQ(result.count, values.size());
+  EXPECT_EQ(result.max, *std::max_element(values.begin(), values.end()));
+  EXPECT_GT(result.blocks_skipped, 5 * result.blocks_scanned);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureReaderTest, BatchedQueriesMatchSingleThreaded) {
+  auto directory = write_capture("smi-batch-");
+  auto reader = smi::capture_reader::open_directory(directory);
+
+  std::vector<smi::range_query> requests;
+  for (uint32_t id = 0; id < processors; ++id) {
+    smi::range_query request;
+    request.processor = id;
+    request.column = metric_column::hotspot_temperature;
+    request.quantiles = {0.99};
+    requests.push_back(request);
+  }
+  auto parallel = reader.query(requests);
+  auto serial = reader.query(requests, 1);
+  ASSERT_EQ(parallel.size(), processors);
+  for (std::size_t id = 0; id < processors; ++id) {
+    EXPECT_EQ(parallel[id].count, rounds);
+    EXPECT_EQ(parallel[id].sum, serial[id].sum);
+    EXPECT_EQ(parallel[id].quantiles, serial[id].quantiles);
+    EXPECT_DOUBLE_EQ(parallel[id].mean(), serial[id].mean());
+  }
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureReaderTest, ValueBoundsFilterRecords) {
+  auto directory = write_capture("smi-bounds-");
+  auto reader = smi::capture_reader::open_directory(directory);
+
+  smi::range_query request;
+  request.processor = 0;
+  request.column = metric_column::hotspot_temperature;
+  request.min_value = 95;
+  auto result = reader.query(request);
+  auto values = expected_values(0, 0, ~uint64_t{0});
+  EXPECT_EQ(result.count, std::count_if(values.begin(), values.end(),
+                                        [](uint32_t v) { return v >= 95; }));
+  EXPECT_GE(result.min, 95);
+
+  request.min_value = 200;
+  result = reader.query(request);
+  EXPECT_EQ(result.count, 0);
+  EXPECT_EQ(result.blocks_scanned, 0);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureReaderTest, MemoryAggregatesKeepBytesAbove4GiB) {
+  auto directory = write_capture("smi-vram-");
+  auto reader = smi::capture_reader::open_directory(directory);
+
+  smi::range_query request;
+  request.processor = 2;
+  request.column = metric_column::memory_usage;
+  request.min_value = vram_used(500, 2);
+  auto result = reader.query(request);
+  EXPECT_EQ(result.count, rounds - 500);
+  EXPECT_EQ(result.min, vram_used(500, 2));
+  EXPECT_EQ(result.max, vram_used(rounds - 1, 2));
+  EXPECT_GT(result.max, uint64_t{4} << 30);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureReaderTest, SkipsCorruptBlocks) {
+  auto directory = write_capture("smi-corrupt-");
+  auto segment = directory / smi::capture_segment_name("smi-capture", 0);
+  auto before = smi::capture_reader{{segment}}.record_count();
+  {
+    std::fstream file{segment, std::ios::in | std::ios::out |
+                                   std::ios::binary};
+    file.seekp(4096);
+    file.write("garbage", 7);
+  }
+  smi::capture_reader reader{{segment}};
+  EXPECT_LT(reader.record_count(), before);
+  EXPECT_GT(reader.record_count(), 0);
+
+  uint64_t visited{0};
+  reader.for_each_record(0, ~uint64_t{0},
+                         [&](const smi::sample_record &) { ++visited; });
+  EXPECT_EQ(visited, reader.record_count());
+  std::filesystem::remove_all(directory);
+}
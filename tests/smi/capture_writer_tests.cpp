@@ -0,0 +1,194 @@
+#include "smi/capture_format.hpp"
+#include "smi/capture_writer.hpp"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+using smi::metric_column;
+
+namespace {
+std::filesystem::path capture_directory(const std::string &name) {
+  auto path = std::filesystem::path{::testing::TempDir()} /
+              (name + std::to_string(getpid()));
+  std::filesystem::remove_all(path);
+  return path;
+}
+
+std::vector<std::byte> read_file(const std::filesystem::path &path) {
+  std::ifstream file{path, std::ios::binary};
+  std::vector<char> bytes{std::istreambuf_iterator<char>{file}, {}};
+  std::vector<std::byte> result(bytes.size());
+  std::memcpy(result.data(), bytes.data(), bytes.size());
+  return result;
+}
+
+std::vector<smi::sample_record> make_round(uint64_t host_ns,
+                                           std::size_t processors) {
+  std::vector<smi::sample_record> round(processors);
+  for (std::size_t id = 0; id < processors; ++id) {
+    round[id].host_ns = host_ns;
+    round[id].processor = static_cast<uint32_t>(id);
+    round[id].values[static_cast<std::size_t>(
+        metric_column::current_socket_power)] =
+        static_cast<uint32_t>(100 + id + host_ns);
+  }
+  return round;
+}
+} // namespace
+
+TEST(CaptureFormatTest, HeaderTracksTimeAndColumnBounds) {
+  smi::capture_block_header header;
+  auto round = make_round(50, 2);
+  round[1].host_ns = 20;
+  for (const auto &record : round) {
+    header.include(record);
+  }
+  EXPECT_EQ(header.record_count, 2);
+  EXPECT_EQ(header.first_host_ns, 20);
+  EXPECT_EQ(header.last_host_ns, 50);
+  EXPECT_EQ(header.processors, 0b11);
+  EXPECT_EQ(header.min_processor, 0);
+  EXPECT_EQ(header.max_processor, 1);
+  EXPECT_FALSE(header.valid()); // Sealed by the writer only
+  auto power = static_cast<std::size_t>(metric_column::current_socket_power);
+  EXPECT_EQ(header.min_values[power], 150);
+  EXPECT_EQ(header.max_values[power], 151);
+
+  std::vector<std::byte> stored(smi::capture_record_size);
+  auto memory = static_cast<std::size_t>(metric_column::memory_usage);
+  round[1].values[memory] = uint64_t{80} << 30;
+  smi::store_record(stored.data(), round[1]);
+  auto loaded = smi::load_record(stored.data());
+  EXPECT_EQ(loaded.host_ns, 20);
+  EXPECT_EQ(loaded.processor, 1);
+  EXPECT_EQ(loaded.value(metric_column::current_socket_power), 151);
+  EXPECT_EQ(loaded.value(metric_column::memory_usage), uint64_t{80} << 30);
+}
+
+TEST(CaptureWriterTest, WritesAlignedBlocksWithBothBackends) {
+  for (bool use_io_uring : {true, false}) {
+    auto directory = capture_directory("smi-capture-");
+    smi::capture_options options;
+    options.directory = directory;
+    options.block_size = 4096;
+    options.use_io_uring = use_io_uring;
+    {
+      smi::capture_writer writer{options};
+      if (!use_io_uring) {
+        EXPECT_FALSE(writer.using_io_uring());
+      }
+      EXPECT_TRUE(writer.append(make_round(1000, 4)));
+      EXPECT_TRUE(writer.append(make_round(2000, 4)));
+      writer.flush();
+      auto stats = writer.stats();
+      EXPECT_EQ(stats.batches, 2);
+      EXPECT_EQ(stats.blocks_written, 1);
+      EXPECT_EQ(stats.bytes_written, 4096);
+      EXPECT_EQ(stats.failed_blocks, 0);
+    }
+
+    auto bytes =
+        read_file(directory / smi::capture_segment_name("smi-capture", 0));
+    ASSERT_EQ(bytes.size(), 4096);
+    smi::capture_block_header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    EXPECT_TRUE(header.valid());
+    EXPECT_EQ(header.record_count, 8);
+    EXPECT_EQ(header.payload_bytes, 8 * smi::capture_record_size);
+    EXPECT_EQ(header.block_size, 4096);
+    EXPECT_EQ(header.first_host_ns, 1000);
+    EXPECT_EQ(header.last_host_ns, 2000);
+    auto last = smi::load_record(bytes.data() + smi::capture_header_size +
+                                 7 * smi::capture_record_size);
+    EXPECT_EQ(last.host_ns, 2000);
+    EXPECT_EQ(last.processor, 3);
+    std::filesystem::remove_all(directory);
+  }
+}
+
+TEST(CaptureWriterTest, RotatesSegmentsWithinDiskBudget) {
+  auto directory = capture_directory("smi-rotate-");
+  smi::capture_options options;
+  options.directory = directory;
+  options.block_size = 4096;
+  options.segment_size = 8192;
+  options.disk_budget = 16384;
+  smi::capture_writer writer{options};
+  for (uint64_t round = 0; round < 10; ++round) {
+    EXPECT_TRUE(writer.append(make_round(round, 2)));
+    writer.flush();
+  }
+
+  auto stats = writer.stats();
+  EXPECT_EQ(stats.blocks_written, 10);
+  EXPECT_EQ(stats.segments_created, 5);
+  EXPECT_EQ(stats.segments_removed, 3);
+  std::size_t on_disk{0};
+  for (const auto &entry : std::filesystem::directory_iterator{directory}) {
+    on_disk += entry.file_size();
+  }
+  EXPECT_LE(on_disk, options.disk_budget);
+  EXPECT_FALSE(std::filesystem::exists(
+      directory / smi::capture_segment_name("smi-capture", 0)));
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureWriterTest, DeletesSegmentsOfAnEarlierCapture) {
+  auto directory = capture_directory("smi-restart-");
+  smi::capture_options options;
+  options.directory = directory;
+  options.block_size = 4096;
+  options.segment_size = 4096;
+  {
+    smi::capture_writer writer{options};
+    for (uint64_t round = 0; round < 3; ++round) {
+      writer.append(make_round(round, 2));
+      writer.flush();
+    }
+  }
+  auto other = directory / smi::capture_segment_name("smi-capture-gpu0", 0);
+  std::ofstream{other} << "other capture";
+
+  {
+    // A shorter capture must not leave segments 1 and 2 behind.
+    smi::capture_writer writer{options};
+    writer.append(make_round(10, 2));
+  }
+  auto segments = smi::capture_segments(directory, "smi-capture");
+  ASSERT_EQ(segments.size(), 1);
+  EXPECT_EQ(segments[0].filename(),
+            smi::capture_segment_name("smi-capture", 0));
+  EXPECT_TRUE(std::filesystem::exists(other));
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureWriterTest, DropsBatchesInsteadOfBlocking) {
+  auto directory = capture_directory("smi-drop-");
+  smi::capture_options options;
+  options.directory = directory;
+  options.block_size = 4096;
+  smi::capture_writer writer{options};
+  auto capacity = smi::capture_block_capacity(options.block_size);
+  EXPECT_FALSE(writer.append(make_round(1, capacity + 1)));
+  EXPECT_TRUE(writer.append(make_round(1, capacity)));
+  writer.flush();
+  auto stats = writer.stats();
+  EXPECT_EQ(stats.batches, 2);
+  EXPECT_EQ(stats.dropped_batches, 1);
+  EXPECT_EQ(stats.blocks_written, 1);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureWriterTest, RejectsInconsistentOptions) {
+  smi::capture_options options;
+  options.directory = capture_directory("smi-invalid-");
+  options.block_size = 1000;
+  EXPECT_THROW(smi::capture_writer{options}, std::invalid_argument);
+}
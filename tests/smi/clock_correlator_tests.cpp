@@ -0,0 +1,63 @@
+#include "smi/clock_correlator.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+// Host time for a GPU counter running at 100 MHz from an arbitrary epoch.
+constexpr uint64_t host_epoch_ns = 5'000'000'000'000;
+
+smi::sample_timestamp stamp(uint64_t counter, uint64_t window_ns = 2'000) {
+  uint64_t host_ns = host_epoch_ns + counter * 10;
+  return {host_ns - window_ns / 2, host_ns + window_ns / 2, counter};
+}
+} // namespace
+
+TEST(ClockCorrelatorTest, FitsLinearMapping) {
+  smi::clock_correlator correlator;
+  EXPECT_FALSE(correlator.fit().valid());
+
+  for (uint64_t counter = 1'000'000; counter < 2'000'000; counter += 1'000) {
+    EXPECT_TRUE(correlator.add(stamp(counter)));
+  }
+
+  const auto &fit = correlator.fit();
+  ASSERT_TRUE(fit.valid());
+  EXPECT_EQ(fit.points, 64);
+  EXPECT_NEAR(fit.slope, 10.0, 1e-9);
+  EXPECT_LT(fit.residual_ns, 1.0);
+  // Extrapolating ahead of the window stays within a microsecond.
+  EXPECT_NEAR(static_cast<double>(fit.to_host_ns(2'500'000)),
+              static_cast<double>(host_epoch_ns + 25'000'000), 1'000.0);
+}
+
+TEST(ClockCorrelatorTest, RejectsWideWindowsAndMissingCounters) {
+  smi::clock_correlator correlator{16, 10'000};
+  EXPECT_FALSE(correlator.add(stamp(1'000, 50'000)));
+  EXPECT_FALSE(correlator.add({100, 200, 0}));
+  EXPECT_TRUE(correlator.add(stamp(1'000)));
+  EXPECT_EQ(correlator.fit().points, 1);
+}
+
+TEST(ClockCorrelatorTest, RepeatedCounterIsNotAFit) {
+  smi::clock_correlator correlator;
+  correlator.add(stamp(10'000));
+  correlator.add({host_epoch_ns + 200'000, host_epoch_ns + 201'000, 10'000});
+  EXPECT_EQ(correlator.fit().points, 2);
+  EXPECT_FALSE(correlator.fit().valid());
+
+  correlator.add(stamp(20'000));
+  EXPECT_TRUE(correlator.fit().valid());
+}
+
+TEST(ClockCorrelatorTest, CounterResetRestartsFit) {
+  smi::clock_correlator correlator;
+  correlator.add(stamp(10'000));
+  correlator.add(stamp(20'000));
+  ASSERT_EQ(correlator.fit().points, 2);
+
+  correlator.add(stamp(500));
+  EXPECT_EQ(correlator.fit().points, 1);
+  EXPECT_EQ(correlator.fit().gpu_origin, 500);
+}
@@ -0,0 +1,113 @@
+#include "smi/derived_metrics.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+smi::smi_metrics make_sample(uint32_t power, uint32_t activity,
+                             uint16_t hotspot, uint16_t edge) {
+  smi::smi_metrics sample{};
+  sample.current_socket_power = power;
+  sample.gfx_activity = activity;
+  sample.hotspot_temperature = hotspot;
+  sample.edge_temperature = edge;
+  return sample;
+}
+} // namespace
+
+TEST(DerivedMetricsTest, StandardDefinitions) {
+  smi::derived_metrics derived{smi::standard_derived_metrics(), 1};
+  ASSERT_EQ(derived.size(), 3);
+  EXPECT_EQ(derived.definition(2).name, "thermal_headroom");
+
+  EXPECT_EQ(derived.update(0, make_sample(200, 50, 80, 60)), 3);
+  EXPECT_DOUBLE_EQ(derived.value(0, 0), 0.25);
+  EXPECT_DOUBLE_EQ(derived.value(0, 1), 100.0);
+  EXPECT_DOUBLE_EQ(derived.value(0, 2), 20.0);
+}
+
+TEST(DerivedMetricsTest, RecomputesOnlyWhenInputsChange) {
+  smi::derived_metrics derived{smi::standard_derived_metrics(), 1};
+  derived.update(0, make_sample(200, 50, 80, 60));
+  auto evaluations = derived.evaluations();
+
+  EXPECT_EQ(derived.update(0, make_sample(200, 50, 80, 60)), 0);
+  // Only the temperatures changed: just thermal_headroom is recomputed.
+  EXPECT_EQ(derived.update(0, make_sample(200, 50, 85, 60)), 1);
+  EXPECT_EQ(derived.evaluations(), evaluations + 1);
+  EXPECT_DOUBLE_EQ(derived.value(0, 2), 25.0);
+  EXPECT_DOUBLE_EQ(derived.value(0, 1), 100.0);
+}
+
+TEST(DerivedMetricsTest, NodeValuesFollowUpdates) {
+  smi::derived_metrics derived{
+      {{"power", smi::column_bit(smi::metric_column::current_socket_power),
+        [](const smi::smi_metrics &sample) {
+          return static_cast<double>(sample.current_socket_power);
+        }}},
+      3};
+  derived.update(0, make_sample(100, 0, 0, 0));
+  derived.update(1, make_sample(200, 0, 0, 0));
+  derived.update(2, make_sample(300, 0, 0, 0));
+  EXPECT_DOUBLE_EQ(derived.node_value(0), 600.0);
+
+  derived.update(1, make_sample(50, 0, 0, 0));
+  EXPECT_DOUBLE_EQ(derived.node_value(0), 450.0);
+
+  auto snapshot = derived;
+  derived.update(0, make_sample(0, 0, 0, 0));
+  EXPECT_DOUBLE_EQ(snapshot.node_value(0), 450.0);
+  EXPECT_EQ(snapshot.definition(0).name, "power");
+}
+
+TEST(DerivedMetricsTest, NodeValuesFollowTheAggregation) {
+  smi::derived_metrics derived{smi::standard_derived_metrics(), 3};
+  derived.update(0, make_sample(200, 50, 80, 60));
+  derived.update(1, make_sample(100, 50, 90, 60));
+  derived.update(2, make_sample(400, 0, 70, 60));
+
+  // perf_per_watt is averaged, activity_weighted_power summed and
+  // thermal_headroom reported at its worst.
+  EXPECT_DOUBLE_EQ(derived.node_value(0), (0.25 + 0.5 + 0.0) / 3);
+  EXPECT_DOUBLE_EQ(derived.node_value(1), 150.0);
+  EXPECT_DOUBLE_EQ(derived.node_value(2), 30.0);
+
+  derived.reset_row(1);
+  EXPECT_DOUBLE_EQ(derived.node_value(0), 0.125);
+  EXPECT_DOUBLE_EQ(derived.node_value(2), 20.0);
+}
+
+TEST(DerivedMetricsTest, SkipsProcessorsWithoutTheRequiredCapabilities) {
+  smi::derived_metrics derived{smi::standard_derived_metrics(), 2};
+  constexpr auto no_edge =
+      smi::capability::all & ~smi::capability::edge_temperature;
+  derived.update(0, make_sample(200, 50, 80, 60));
+  // Edge reads as zero when unsupported; the headroom would be 90.
+  EXPECT_EQ(derived.update(1, make_sample(100, 50, 90, 0), no_edge), 2);
+
+  EXPECT_TRUE(derived.supported(1, 0));
+  EXPECT_FALSE(derived.supported(1, 2));
+  EXPECT_TRUE(std::isnan(derived.value(1, 2)));
+  EXPECT_DOUBLE_EQ(derived.node_value(1), 150.0);
+  EXPECT_DOUBLE_EQ(derived.node_value(2), 20.0);
+  EXPECT_TRUE(derived.node_supported(2));
+
+  derived.reset_row(0);
+  EXPECT_FALSE(derived.node_supported(2));
+
+  // Gaining the capability recomputes even though no input changed.
+  EXPECT_EQ(derived.update(1, make_sample(100, 50, 90, 0)), 3);
+  EXPECT_DOUBLE_EQ(derived.value(1, 2), 90.0);
+}
+
+TEST(DerivedMetricsTest, RejectsNamesThatNeedEscaping) {
+  auto constant = [](const smi::smi_metrics &) { return 1.0; };
+  for (const char *name : {"", "1st", "power,watts", "a\"b", "power watts"}) {
+    EXPECT_THROW((smi::derived_metrics{{{name, 0, constant}}, 1}),
+                 std::invalid_argument)
+        << name;
+  }
+  EXPECT_NO_THROW((smi::derived_metrics{{{"power_2", 0, constant}}, 1}));
+}
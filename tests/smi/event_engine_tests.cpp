@@ -0,0 +1,131 @@
+#include "smi/event_engine.hpp"
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+smi::smi_metrics with_power(uint32_t power) {
+  smi::smi_metrics sample{};
+  sample.current_socket_power = power;
+  return sample;
+}
+
+smi::sample_timestamp at_ms(uint64_t milliseconds) {
+  uint64_t ns = milliseconds * 1'000'000;
+  return {ns, ns, 0};
+}
+} // namespace
+
+TEST(EventEngineTest, ThresholdWithHysteresis) {
+  smi::event_engine engine{1};
+  std::vector<smi::smi_event> seen;
+  auto rule = engine.add_rule(
+      {smi::metric_column::current_socket_power, smi::rule_condition::above,
+       500, 20},
+      [&](const smi::smi_event &event) { seen.push_back(event); });
+
+  EXPECT_EQ(engine.evaluate(0, with_power(450), at_ms(0)), 0);
+  EXPECT_EQ(engine.evaluate(0, with_power(510), at_ms(0)), 1);
+  EXPECT_TRUE(engine.active(rule, 0));
+  // Inside the hysteresis band: stays raised, no new events.
+  EXPECT_EQ(engine.evaluate(0, with_power(490), at_ms(0)), 0);
+  EXPECT_EQ(engine.evaluate(0, with_power(520), at_ms(0)), 0);
+  EXPECT_EQ(engine.evaluate(0, with_power(470), at_ms(0)), 1);
+  EXPECT_FALSE(engine.active(rule, 0));
+
+  ASSERT_EQ(seen.size(), 2);
+  EXPECT_EQ(seen[0].edge, smi::event_edge::raised);
+  EXPECT_EQ(seen[0].value, 510);
+  EXPECT_EQ(seen[1].edge, smi::event_edge::cleared);
+  EXPECT_EQ(seen[1].rule, rule);
+}
+
+TEST(EventEngineTest, RateOfChange) {
+  smi::event_engine engine{1};
+  engine.add_rule({smi::metric_column::current_socket_power,
+                   smi::rule_condition::rate_above, 100});
+
+  EXPECT_EQ(engine.evaluate(0, with_power(300), at_ms(0)), 0);
+  EXPECT_EQ(engine.evaluate(0, with_power(350), at_ms(1000)), 0);
+  EXPECT_EQ(engine.evaluate(0, with_power(500), at_ms(2000)), 1);
+  EXPECT_EQ(engine.evaluate(0, with_power(510), at_ms(3000)), 1);
+  // The same 60 W step is 120 W/s when the samples are 500 ms apart.
+  EXPECT_EQ(engine.evaluate(0, with_power(570), at_ms(4000)), 0);
+  EXPECT_EQ(engine.evaluate(0, with_power(630), at_ms(4500)), 1);
+
+  auto events = engine.take_events();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[0].value, 150);
+  EXPECT_EQ(events[1].edge, smi::event_edge::cleared);
+  EXPECT_EQ(events[2].value, 120);
+}
+
+TEST(EventEngineTest, SkipsRulesOnMetricsNotRefreshed) {
+  smi::event_engine engine{1};
+  engine.add_rule({smi::metric_column::hotspot_temperature,
+                   smi::rule_condition::above, 90});
+  smi::smi_metrics hot{};
+  hot.hotspot_temperature = 95;
+
+  EXPECT_EQ(engine.evaluate(0, hot, at_ms(0),
+                            smi::group_bit(smi::metric_group::power)),
+            0);
+  EXPECT_EQ(engine.evaluate(0, hot, at_ms(0),
+                            smi::group_bit(smi::metric_group::thermal)),
+            1);
+}
+
+TEST(EventEngineTest, SkipsRulesOnUnsupportedMetrics) {
+  smi::event_engine engine{1};
+  auto rule = engine.add_rule({smi::metric_column::edge_temperature,
+                               smi::rule_condition::below, 10});
+  // An unsupported edge temperature reads as zero.
+  smi::smi_metrics sample{};
+  constexpr auto no_edge =
+      smi::capability::all & ~smi::capability::edge_temperature;
+
+  EXPECT_EQ(engine.evaluate(0, sample, at_ms(0), smi::all_metric_groups,
+                            no_edge),
+            0);
+  EXPECT_FALSE(engine.active(rule, 0));
+  EXPECT_EQ(engine.evaluate(0, sample, at_ms(0)), 1);
+}
+
+TEST(EventEngineTest, NotificationFdSignalsWaitingThreads) {
+  smi::event_engine engine{2};
+  engine.add_rule({smi::metric_column::current_socket_power,
+                   smi::rule_condition::below, 50});
+
+  pollfd descriptor{engine.notification_fd(), POLLIN, 0};
+  EXPECT_EQ(poll(&descriptor, 1, 0), 0);
+
+  engine.evaluate(1, with_power(10), at_ms(0));
+  EXPECT_EQ(poll(&descriptor, 1, 0), 1);
+
+  auto events = engine.take_events();
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].row, 1);
+  EXPECT_EQ(poll(&descriptor, 1, 0), 0);
+  EXPECT_TRUE(engine.take_events().empty());
+}
+
+TEST(EventEngineTest, QueueDropsOldestEventsWhenUndrained) {
+  smi::event_engine engine{1};
+  engine.add_rule({smi::metric_column::current_socket_power,
+                   smi::rule_condition::above, 100});
+
+  // Every other sample raises, the ones in between clear.
+  const std::size_t samples = smi::event_engine::max_queued_events + 10;
+  for (std::size_t sample = 0; sample < samples; ++sample) {
+    engine.evaluate(0, with_power(sample % 2 == 0 ? 200 : 0), at_ms(0));
+  }
+  EXPECT_EQ(engine.dropped_events(), 10);
+
+  auto events = engine.take_events();
+  ASSERT_EQ(events.size(), smi::event_engine::max_queued_events);
+  // The ten oldest transitions (raised, cleared, ...) are gone.
+  EXPECT_EQ(events.front().edge, smi::event_edge::raised);
+  EXPECT_TRUE(engine.take_events().empty());
+}
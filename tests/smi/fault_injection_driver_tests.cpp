@@ -0,0 +1,207 @@
+#include "smi/amd_smi_driver.hpp"
+#include "smi/fault_injection_driver.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/supervised_reader.hpp"
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <chrono>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+using smi::driver_call;
+using smi::fault_kind;
+
+namespace {
+// Stateless simulated driver: one GPU whose every call succeeds.
+struct simulated_driver {
+  static amdsmi_status_t init() { return AMDSMI_STATUS_SUCCESS; }
+  static amdsmi_status_t get_version(amdsmi_version_t *version) {
+    *version = amdsmi_version_t{1, 0, 0, "simulated"};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_socket_handles(uint32_t *count,
+                                            amdsmi_socket_handle *) {
+    *count = 0;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_processor_handles(amdsmi_socket_handle,
+                                               uint32_t *count,
+                                               amdsmi_processor_handle *) {
+    *count = 0;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_processor_type(amdsmi_processor_handle,
+                                            processor_type_t *type) {
+    *type = AMDSMI_PROCESSOR_TYPE_AMD_GPU;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_power_info(amdsmi_processor_handle,
+                                        amdsmi_power_info_t *info) {
+    *info = {};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_gpu_activity(amdsmi_processor_handle,
+                                          amdsmi_engine_usage_t *usage) {
+    *usage = {};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_memory_usage(amdsmi_processor_handle,
+                                          amdsmi_memory_type_t,
+                                          uint64_t *usage) {
+    *usage = 4096;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t
+  get_temperature_metric(amdsmi_processor_handle, amdsmi_temperature_type_t,
+                         amdsmi_temperature_metric_t, int64_t *temperature) {
+    *temperature = 50;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_gpu_metrics_info(amdsmi_processor_handle,
+                                              amdsmi_gpu_metrics_t *metrics) {
+    *metrics = {};
+    metrics->current_socket_power = 200;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+using faulty_driver = smi::fault_injection_driver<simulated_driver>;
+
+const auto gpu_handle = reinterpret_cast<amdsmi_processor_handle>(0x1000);
+
+std::shared_ptr<faulty_driver> make_driver(std::vector<smi::fault_rule> rules,
+                                           uint64_t seed = 1) {
+  return std::make_shared<faulty_driver>(simulated_driver{},
+                                         smi::fault_config{rules, seed});
+}
+
+smi::fault_rule gpu_metrics_rule(fault_kind kind) {
+  smi::fault_rule rule;
+  rule.kind = kind;
+  rule.calls = smi::call_bit(driver_call::get_gpu_metrics_info);
+  return rule;
+}
+} // namespace
+
+static_assert(smi::smi_driver<faulty_driver>);
+static_assert(!smi::identity_driver<faulty_driver>);
+static_assert(smi::identity_driver<
+              smi::fault_injection_driver<smi::amd_smi_driver>>);
+static_assert(smi::process_driver<
+              smi::fault_injection_driver<smi::amd_smi_driver>>);
+
+TEST(FaultInjectionDriverTest, ScheduledErrorsReplaceTheCall) {
+  auto rule = gpu_metrics_rule(fault_kind::error);
+  rule.every = 3;
+  rule.skip = 1; // the capability probe
+  rule.status = AMDSMI_STATUS_TIMEOUT;
+  auto driver = make_driver({rule});
+
+  smi::processor_table<faulty_driver> table{driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  std::vector<amdsmi_status_t> statuses;
+  for (int read = 0; read < 6; ++read) {
+    table.sample();
+    statuses.push_back(table.statuses()[0]);
+  }
+  EXPECT_EQ(statuses[2], AMDSMI_STATUS_TIMEOUT);
+  EXPECT_EQ(statuses[5], AMDSMI_STATUS_TIMEOUT);
+  EXPECT_EQ(std::count(statuses.begin(), statuses.end(),
+                       AMDSMI_STATUS_SUCCESS),
+            4);
+  EXPECT_EQ(table.samples()[0].current_socket_power, 200);
+  EXPECT_EQ(driver->stats().errors, 2);
+}
+
+TEST(FaultInjectionDriverTest, RandomFaultsAreReproducibleAndLimited) {
+  auto rule = gpu_metrics_rule(fault_kind::error);
+  rule.probability = 0.5;
+  auto draw = [&](uint64_t seed) {
+    auto driver = make_driver({rule}, seed);
+    std::vector<amdsmi_status_t> statuses;
+    amdsmi_gpu_metrics_t metrics;
+    for (int call = 0; call < 64; ++call) {
+      statuses.push_back(driver->get_gpu_metrics_info(gpu_handle, &metrics));
+    }
+    return statuses;
+  };
+  auto first = draw(7);
+  EXPECT_EQ(first, draw(7));
+  auto failures = std::count(first.begin(), first.end(), AMDSMI_STATUS_BUSY);
+  EXPECT_GT(failures, 0);
+  EXPECT_LT(failures, 64);
+
+  rule.probability = 1.0;
+  rule.limit = 5;
+  auto driver = make_driver({rule});
+  amdsmi_gpu_metrics_t metrics;
+  for (int call = 0; call < 20; ++call) {
+    driver->get_gpu_metrics_info(gpu_handle, &metrics);
+  }
+  // Other calls are not targeted.
+  uint64_t memory;
+  EXPECT_EQ(driver->get_memory_usage(gpu_handle, AMDSMI_MEM_TYPE_VRAM, &memory),
+            AMDSMI_STATUS_SUCCESS);
+  EXPECT_EQ(driver->stats().errors, 5);
+  EXPECT_EQ(driver->stats().calls, 21);
+}
+
+TEST(FaultInjectionDriverTest, CorruptionOverwritesGpuMetrics) {
+  auto rule = gpu_metrics_rule(fault_kind::corruption);
+  rule.every = 1;
+  rule.corrupt_bytes = 64;
+  auto driver = make_driver({rule});
+
+  amdsmi_gpu_metrics_t metrics;
+  ASSERT_EQ(driver->get_gpu_metrics_info(gpu_handle, &metrics),
+            AMDSMI_STATUS_SUCCESS);
+  amdsmi_gpu_metrics_t clean{};
+  clean.current_socket_power = 200;
+  auto *bytes = reinterpret_cast<const unsigned char *>(&metrics);
+  auto *expected = reinterpret_cast<const unsigned char *>(&clean);
+  EXPECT_FALSE(std::equal(bytes, bytes + sizeof(metrics), expected));
+  EXPECT_EQ(driver->stats().corruptions, 1);
+}
+
+TEST(FaultInjectionDriverTest, LatencyAndHangsShowInSupervisedReads) {
+  auto slow = gpu_metrics_rule(fault_kind::latency);
+  slow.every = 1;
+  slow.skip = 1;
+  slow.limit = 1;
+  slow.duration = std::chrono::milliseconds{5};
+  auto hang = gpu_metrics_rule(fault_kind::hang);
+  hang.every = 1;
+  hang.skip = 2;
+  hang.duration = std::chrono::nanoseconds::zero();
+  auto driver = make_driver({slow, hang});
+
+  smi::processor_table<faulty_driver> table{driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  smi::supervised_reader<faulty_driver> reader{
+      table, std::chrono::milliseconds{100}, 2};
+
+  EXPECT_EQ(reader.read({}), 1);
+  EXPECT_GE(reader.health()[0].last_latency_ns, 5'000'000u);
+
+  // The next call hangs: the processor is missing until it is released.
+  EXPECT_EQ(reader.read({}), 0);
+  EXPECT_EQ(reader.read({}), 0);
+  EXPECT_TRUE(reader.health()[0].hung);
+  EXPECT_EQ(driver->stats().hangs, 1);
+
+  driver->release_hangs();
+  bool recovered = false;
+  for (int attempt = 0; attempt < 100 && !recovered; ++attempt) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    recovered = reader.read({}) == 1;
+  }
+  EXPECT_TRUE(recovered);
+  EXPECT_FALSE(reader.health()[0].hung);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <amd_smi/amdsmi.h>
+#include <cstdint>
+#include <gmock/gmock.h>
+
+// Mock driver API shared by the table, scheduler, reader and exposition tests
+struct mock_sampling_driver {
+  MOCK_METHOD(amdsmi_status_t, get_power_info,
+              (amdsmi_processor_handle, amdsmi_power_info_t *), ());
+  MOCK_METHOD(amdsmi_status_t, get_gpu_activity,
+              (amdsmi_processor_handle, amdsmi_engine_usage_t *), ());
+  MOCK_METHOD(amdsmi_status_t, get_memory_usage,
+              (amdsmi_processor_handle, amdsmi_memory_type_t, uint64_t *), ());
+  MOCK_METHOD(amdsmi_status_t, get_temperature_metric,
+              (amdsmi_processor_handle, amdsmi_temperature_type_t,
+               amdsmi_temperature_metric_t, int64_t *),
+              ());
+  MOCK_METHOD(amdsmi_status_t, get_gpu_metrics_info,
+              (amdsmi_processor_handle, amdsmi_gpu_metrics_t *), ());
+};
+
+// Makes every call succeed: 4096 bytes of memory, 55 degrees, and the given
+// power and GPU metrics.
+inline void set_default_answers(mock_sampling_driver &driver,
+                                const amdsmi_gpu_metrics_t &gpu_metrics,
+                                const amdsmi_power_info_t &power_info = {}) {
+  using ::testing::_;
+  using ::testing::DoAll;
+  using ::testing::Return;
+  using ::testing::SetArgPointee;
+
+  ON_CALL(driver, get_power_info(_, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<1>(power_info), Return(AMDSMI_STATUS_SUCCESS)));
+  ON_CALL(driver, get_gpu_activity(_, _))
+      .WillByDefault(Return(AMDSMI_STATUS_SUCCESS));
+  ON_CALL(driver, get_memory_usage(_, _, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<2>(4096), Return(AMDSMI_STATUS_SUCCESS)));
+  ON_CALL(driver, get_temperature_metric(_, _, _, _))
+      .WillByDefault(DoAll(SetArgPointee<3>(int64_t{55}),
+                           Return(AMDSMI_STATUS_SUCCESS)));
+  ON_CALL(driver, get_gpu_metrics_info(_, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<1>(gpu_metrics), Return(AMDSMI_STATUS_SUCCESS)));
+}
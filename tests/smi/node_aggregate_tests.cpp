@@ -0,0 +1,95 @@
+#include "smi/node_aggregate.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+smi::smi_metrics make_sample(uint32_t power, uint16_t hotspot,
+                             uint32_t gfx_activity) {
+  smi::smi_metrics sample{};
+  sample.current_socket_power = power;
+  sample.hotspot_temperature = hotspot;
+  sample.gfx_activity = gfx_activity;
+  return sample;
+}
+} // namespace
+
+TEST(NodeAggregateTest, TotalsAndExtremes) {
+  smi::node_aggregate node{3};
+  EXPECT_EQ(node.snapshot().processor_count, 0);
+
+  node.apply(0, make_sample(100, 70, 20), 1000);
+  node.apply(1, make_sample(300, 90, 80), 3000);
+  node.publish();
+
+  auto snapshot = node.snapshot();
+  EXPECT_EQ(snapshot.round, 1);
+  EXPECT_EQ(snapshot.processor_count, 2);
+  EXPECT_EQ(snapshot.total_socket_power, 400);
+  EXPECT_EQ(snapshot.total_memory_usage, 4000);
+  EXPECT_EQ(snapshot.max_hotspot_temperature, 90);
+  EXPECT_DOUBLE_EQ(snapshot.mean_gfx_activity, 50.0);
+}
+
+TEST(NodeAggregateTest, IncrementalUpdatesReplaceContributions) {
+  smi::node_aggregate node{2};
+  node.apply(0, make_sample(100, 70, 20), 0);
+  node.apply(1, make_sample(300, 90, 80), 0);
+  node.publish();
+
+  // The hottest processor cools down: the maximum must be rescanned.
+  node.apply(1, make_sample(250, 60, 40), 0);
+  node.publish();
+
+  auto snapshot = node.snapshot();
+  EXPECT_EQ(snapshot.round, 2);
+  EXPECT_EQ(snapshot.processor_count, 2);
+  EXPECT_EQ(snapshot.total_socket_power, 350);
+  EXPECT_EQ(snapshot.max_hotspot_temperature, 70);
+  EXPECT_DOUBLE_EQ(snapshot.mean_gfx_activity, 30.0);
+}
+
+TEST(NodeAggregateTest, MemoryTotalDoesNotWrapAbove4GiB) {
+  constexpr uint64_t gib = uint64_t{1} << 30;
+  smi::node_aggregate node{2};
+  node.apply(0, make_sample(100, 70, 20), 48 * gib);
+  node.apply(1, make_sample(100, 70, 20), 6 * gib);
+  node.publish();
+  EXPECT_EQ(node.snapshot().total_memory_usage, 54 * gib);
+
+  node.apply(1, make_sample(100, 70, 20), 5 * gib);
+  node.publish();
+  EXPECT_EQ(node.snapshot().total_memory_usage, 53 * gib);
+
+  node.remove(0);
+  node.publish();
+  EXPECT_EQ(node.snapshot().total_memory_usage, 5 * gib);
+}
+
+TEST(SeqlockTest, ReadersSeeConsistentValues) {
+  struct pair {
+    uint64_t first;
+    uint64_t second;
+  };
+  smi::seqlock<pair> cell;
+  cell.store({0, 0});
+  std::atomic<bool> done{false};
+
+  std::thread writer([&] {
+    for (uint64_t i = 1; i <= 10000; ++i) {
+      cell.store({i, i});
+    }
+    done = true;
+  });
+  bool consistent{true};
+  while (!done) {
+    auto value = cell.load();
+    consistent = consistent && value.first == value.second;
+  }
+  writer.join();
+
+  EXPECT_TRUE(consistent);
+  EXPECT_EQ(cell.load().first, 10000);
+}
@@ -0,0 +1,163 @@
+#include "smi/process_tracker.hpp"
+#include "smi/processor_table.hpp"
+#include <amd_smi/amdsmi.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using rocprofsys::amd_smi::process_change;
+using rocprofsys::amd_smi::process_event;
+using rocprofsys::amd_smi::process_tracker;
+
+namespace {
+amdsmi_proc_info_t make_process(uint32_t pid, uint64_t vram,
+                                uint64_t gfx = 0) {
+  amdsmi_proc_info_t info{};
+  std::snprintf(info.name, sizeof(info.name), "proc-%u", pid);
+  info.pid = pid;
+  info.memory_usage.vram_mem = vram;
+  info.engine_usage.gfx = gfx;
+  return info;
+}
+
+struct mock_process_driver {
+  MOCK_METHOD(amdsmi_status_t, get_process_list,
+              (amdsmi_processor_handle, uint32_t *, amdsmi_proc_info_t *), ());
+};
+} // namespace
+
+TEST(ProcessTrackerTest, ReportsAppearedChangedAndDisappeared) {
+  process_tracker tracker{2};
+  std::vector<process_event> events;
+
+  std::vector<amdsmi_proc_info_t> round{make_process(30, 4 << 20),
+                                        make_process(10, 1 << 20)};
+  EXPECT_EQ(tracker.update(1, round, 100, events), 2);
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0].change, process_change::appeared);
+  EXPECT_EQ(events[0].usage.pid, 10);
+  EXPECT_EQ(events[0].usage.processor, 1);
+  EXPECT_EQ(events[0].usage.name, "proc-10");
+  EXPECT_EQ(events[1].usage.pid, 30);
+
+  // Same list: nothing to report.
+  events.clear();
+  EXPECT_EQ(tracker.update(1, round, 200, events), 0);
+
+  // pid 10 grows by 8 MiB, pid 30 exits, pid 20 starts.
+  round = {make_process(10, 9 << 20), make_process(20, 0)};
+  EXPECT_EQ(tracker.update(1, round, 300, events), 3);
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[0].change, process_change::changed);
+  EXPECT_EQ(events[0].usage.vram_bytes, 9u << 20);
+  EXPECT_EQ(events[1].change, process_change::appeared);
+  EXPECT_EQ(events[1].usage.pid, 20);
+  EXPECT_EQ(events[2].change, process_change::disappeared);
+  EXPECT_EQ(events[2].usage.pid, 30);
+  EXPECT_EQ(events[2].host_ns, 300);
+
+  auto snapshot = tracker.snapshot();
+  ASSERT_EQ(snapshot.size(), 2);
+  EXPECT_EQ(snapshot[0].pid, 10);
+  EXPECT_EQ(snapshot[1].pid, 20);
+}
+
+TEST(ProcessTrackerTest, SmallMovesAccumulateUntilThreshold) {
+  process_tracker tracker{1, {.memory_bytes = 1000, .engine_ns = 50}};
+  std::vector<process_event> events;
+
+  std::vector<amdsmi_proc_info_t> round{make_process(7, 0, 0)};
+  tracker.update(0, round, 0, events);
+  events.clear();
+
+  for (uint64_t step = 1; step <= 4; ++step) {
+    round[0] = make_process(7, 200 * step, 10 * step);
+    tracker.update(0, round, step, events);
+  }
+  // 800 bytes and 40 ns are below both thresholds.
+  EXPECT_TRUE(events.empty());
+
+  round[0] = make_process(7, 1200, 40);
+  tracker.update(0, round, 5, events);
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].change, process_change::changed);
+
+  // Measured from the reported values again.
+  events.clear();
+  round[0] = make_process(7, 1200, 80);
+  tracker.update(0, round, 6, events);
+  EXPECT_TRUE(events.empty());
+
+  round[0].cu_occupancy = 4;
+  tracker.update(0, round, 7, events);
+  EXPECT_EQ(events.size(), 1);
+}
+
+TEST(ProcessTrackerTest, ResetRowReportsEveryProcessAsDisappeared) {
+  process_tracker tracker{1};
+  std::vector<process_event> events;
+  std::vector<amdsmi_proc_info_t> round{make_process(1, 0),
+                                        make_process(2, 0)};
+  tracker.update(0, round, 0, events);
+  events.clear();
+
+  EXPECT_EQ(tracker.reset_row(0, 10, events), 2);
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0].change, process_change::disappeared);
+  EXPECT_EQ(tracker.process_count(), 0);
+}
+
+TEST(ProcessTrackerTest, TableReadGrowsBufferWhenDriverNeedsMore) {
+  auto driver = std::make_shared<mock_process_driver>();
+  rocprofsys::amd_smi::processor_table<mock_process_driver> table{driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+
+  constexpr uint32_t running = 40;
+  EXPECT_CALL(*driver, get_process_list(_, _, _))
+      .WillRepeatedly(Invoke([](amdsmi_processor_handle, uint32_t *count,
+                                amdsmi_proc_info_t *processes) {
+        if (*count < running) {
+          *count = running;
+          return AMDSMI_STATUS_OUT_OF_RESOURCES;
+        }
+        for (uint32_t i = 0; i < running; ++i) {
+          processes[i] = make_process(i + 1, 0);
+        }
+        *count = running;
+        return AMDSMI_STATUS_SUCCESS;
+      }));
+
+  std::vector<amdsmi_proc_info_t> processes;
+  EXPECT_EQ(table.read_processes(0, processes), AMDSMI_STATUS_SUCCESS);
+  ASSERT_EQ(processes.size(), running);
+  EXPECT_EQ(processes.back().pid, running);
+}
+
+TEST(ProcessTrackerTest, TableReadStopsGrowingAtTheLimit) {
+  auto driver = std::make_shared<mock_process_driver>();
+  rocprofsys::amd_smi::processor_table<mock_process_driver> table{driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+
+  uint32_t largest{0};
+  EXPECT_CALL(*driver, get_process_list(_, _, _))
+      .WillRepeatedly(Invoke([&](amdsmi_processor_handle, uint32_t *count,
+                                 amdsmi_proc_info_t *) {
+        largest = std::max(largest, *count);
+        return AMDSMI_STATUS_OUT_OF_RESOURCES;
+      }));
+
+  std::vector<amdsmi_proc_info_t> processes;
+  EXPECT_EQ(table.read_processes(0, processes),
+            AMDSMI_STATUS_OUT_OF_RESOURCES);
+  EXPECT_TRUE(processes.empty());
+  EXPECT_EQ(largest, rocprofsys::amd_smi::max_listed_processes);
+}
@@ -0,0 +1,370 @@
+#include "mock_sampling_driver.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/throttle_tracker.hpp"
+#include <algorithm>
+#include <amd_smi/amdsmi.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+// Adds the optional memory size query to the table driver.
+struct mock_memory_driver : mock_sampling_driver {
+  MOCK_METHOD(amdsmi_status_t, get_memory_total,
+              (amdsmi_processor_handle, amdsmi_memory_type_t, uint64_t *), ());
+};
+
+class ProcessorTableTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mock_driver = std::make_shared<NiceMock<mock_sampling_driver>>();
+    gpu_handle = reinterpret_cast<amdsmi_processor_handle>(0x1000);
+    cpu_handle = reinterpret_cast<amdsmi_processor_handle>(0x2000);
+
+    amdsmi_power_info_t power_info = {};
+    power_info.average_socket_power = 150;
+    power_info.current_socket_power = 140;
+
+    gpu_metrics = {};
+    gpu_metrics.current_socket_power = 140;
+    gpu_metrics.average_socket_power = 150;
+    gpu_metrics.average_gfx_activity = 75;
+    gpu_metrics.temperature_hotspot = 60;
+    gpu_metrics.temperature_edge = 50;
+
+    set_default_answers(*mock_driver, gpu_metrics, power_info);
+  }
+
+  std::shared_ptr<NiceMock<mock_sampling_driver>> mock_driver;
+  amdsmi_processor_handle gpu_handle;
+  amdsmi_processor_handle cpu_handle;
+  amdsmi_gpu_metrics_t gpu_metrics;
+};
+
+TEST_F(ProcessorTableTest, AddKeepsColumnsAligned) {
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.add(cpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+
+  ASSERT_EQ(table.size(), 2);
+  EXPECT_EQ(table.handles()[0], gpu_handle);
+  EXPECT_EQ(table.handles()[1], cpu_handle);
+  EXPECT_EQ(table.types()[1], AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  EXPECT_EQ(table.capabilities().size(), 2);
+  EXPECT_EQ(table.samples().size(), 2);
+  EXPECT_EQ(table.statuses()[0], AMDSMI_STATUS_NO_DATA);
+}
+
+TEST_F(ProcessorTableTest, ProbeSkipsNonGpuRows) {
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(cpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+
+  EXPECT_CALL(*mock_driver, get_power_info(cpu_handle, _)).Times(0);
+  EXPECT_CALL(*mock_driver, get_power_info(gpu_handle, _)).Times(1);
+
+  table.probe();
+
+  namespace capability = rocprofsys::amd_smi::capability;
+  EXPECT_EQ(table.capabilities()[0], 0);
+  EXPECT_TRUE(table.capabilities()[1] & capability::current_socket_power);
+  EXPECT_TRUE(table.capabilities()[1] & capability::hotspot_temperature);
+  EXPECT_TRUE(table.capabilities()[1] & capability::memory_usage);
+  EXPECT_TRUE(table.get_supported_metrics(1).edge_temperature);
+}
+
+TEST_F(ProcessorTableTest, SampleReadsOnlyCapableRows) {
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(cpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(cpu_handle, _)).Times(0);
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(gpu_metrics), Return(AMDSMI_STATUS_SUCCESS)));
+
+  EXPECT_EQ(table.sample(), 1);
+  EXPECT_EQ(table.statuses()[0], AMDSMI_STATUS_NO_DATA);
+  EXPECT_EQ(table.statuses()[1], AMDSMI_STATUS_SUCCESS);
+  EXPECT_EQ(table.samples()[1].current_socket_power, 140);
+  EXPECT_EQ(table.samples()[1].gfx_activity, 75);
+  EXPECT_EQ(table.samples()[1].hotspot_temperature, 60);
+  EXPECT_EQ(table.samples()[1].memory_usage, 4096);
+}
+
+TEST_F(ProcessorTableTest, SampleFailureKeepsPreviousValues) {
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  ASSERT_EQ(table.sample(), 1);
+
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillOnce(Return(AMDSMI_STATUS_BUSY));
+
+  EXPECT_EQ(table.sample(), 0);
+  EXPECT_EQ(table.statuses()[0], AMDSMI_STATUS_BUSY);
+  EXPECT_EQ(table.samples()[0].current_socket_power, 140);
+}
+
+TEST_F(ProcessorTableTest, SampleRecordsTimestamp) {
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  amdsmi_gpu_metrics_t metrics = gpu_metrics;
+  metrics.system_clock_counter = 123456;
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillOnce(DoAll(SetArgPointee<1>(metrics), Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(Return(AMDSMI_STATUS_BUSY));
+
+  auto before = rocprofsys::amd_smi::host_timestamp_ns();
+  ASSERT_EQ(table.sample(), 1);
+  auto after = rocprofsys::amd_smi::host_timestamp_ns();
+
+  auto timestamp = table.timestamps()[0];
+  EXPECT_EQ(timestamp.gpu_clock_counter, 123456);
+  EXPECT_LE(before, timestamp.host_begin_ns);
+  EXPECT_LE(timestamp.host_begin_ns, timestamp.host_end_ns);
+  EXPECT_LE(timestamp.host_end_ns, after);
+
+  // A failed read keeps the timestamp of the sample it leaves in place.
+  EXPECT_EQ(table.sample(), 0);
+  EXPECT_EQ(table.timestamps()[0].host_end_ns, timestamp.host_end_ns);
+}
+
+TEST_F(ProcessorTableTest, ClocksGroupReadsClocksAndThrottleStatus) {
+  namespace smi = rocprofsys::amd_smi;
+  amdsmi_gpu_metrics_t probed = gpu_metrics;
+  probed.current_uclk = smi::metric_value_not_supported;
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillOnce(DoAll(SetArgPointee<1>(probed), Return(AMDSMI_STATUS_SUCCESS)));
+
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  auto capabilities = table.capabilities()[0];
+  EXPECT_NE(capabilities & smi::capability::gfx_clock, 0);
+  EXPECT_EQ(capabilities & smi::capability::memory_clock, 0);
+  EXPECT_NE(capabilities & smi::capability::throttle_status, 0);
+
+  amdsmi_gpu_metrics_t throttled = gpu_metrics;
+  throttled.current_gfxclk = 1700;
+  throttled.current_uclk = 900;
+  throttled.indep_throttle_status = uint64_t{1} << 36;
+  throttled.current_socket_power = 999;
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(throttled), Return(AMDSMI_STATUS_SUCCESS)));
+  ASSERT_EQ(table.sample_row(0, smi::group_bit(smi::metric_group::clocks)),
+            AMDSMI_STATUS_SUCCESS);
+
+  const auto &sample = table.samples()[0];
+  EXPECT_EQ(sample.gfx_clock, 1700);
+  EXPECT_EQ(sample.memory_clock, 0);
+  EXPECT_EQ(sample.throttle_status, uint64_t{1} << 36);
+  EXPECT_EQ(sample.current_socket_power, 0);
+
+  smi::throttle_tracker tracker{table.size()};
+  std::vector<smi::throttle_event> ended;
+  tracker.update(table, {}, ended);
+  EXPECT_TRUE(tracker.active(0, smi::throttle_cause::thermal));
+}
+
+TEST_F(ProcessorTableTest, PartitionedLayoutUsesXccClocksAndResidency) {
+  namespace smi = rocprofsys::amd_smi;
+  constexpr auto not_supported = smi::metric_value_not_supported;
+  // GPU metrics v1.4 and later: no single GFX clock, no independent throttle
+  // status, but per-XCC clocks and violation residency accumulators.
+  auto partitioned = [&](uint64_t counter, uint64_t ppt, uint64_t socket_thm) {
+    amdsmi_gpu_metrics_t metrics = gpu_metrics;
+    metrics.current_gfxclk = not_supported;
+    std::fill(std::begin(metrics.current_gfxclks),
+              std::end(metrics.current_gfxclks), not_supported);
+    metrics.current_gfxclks[0] = 1900;
+    metrics.current_gfxclks[1] = 2100;
+    metrics.indep_throttle_status = UINT64_MAX;
+    metrics.accumulation_counter = counter;
+    metrics.ppt_residency_acc = ppt;
+    metrics.socket_thm_residency_acc = socket_thm;
+    metrics.prochot_residency_acc = 7;
+    metrics.vr_thm_residency_acc = UINT64_MAX;
+    metrics.hbm_thm_residency_acc = 0;
+    return metrics;
+  };
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillOnce(DoAll(SetArgPointee<1>(partitioned(1, 0, 0)),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(DoAll(SetArgPointee<1>(partitioned(10, 0, 0)),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(DoAll(SetArgPointee<1>(partitioned(20, 5, 0)),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(DoAll(SetArgPointee<1>(partitioned(30, 15, 4)),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(DoAll(SetArgPointee<1>(partitioned(30, 15, 4)),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(DoAll(SetArgPointee<1>(partitioned(40, 15, 9)),
+                      Return(AMDSMI_STATUS_SUCCESS)));
+
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  auto capabilities = table.capabilities()[0];
+  EXPECT_NE(capabilities & smi::capability::gfx_clock, 0);
+  EXPECT_NE(capabilities & smi::capability::throttle_status, 0);
+  EXPECT_TRUE(table.get_supported_metrics(0).throttle_from_residency);
+
+  smi::throttle_tracker tracker{table.size()};
+  std::vector<smi::throttle_event> ended;
+  auto sample_clocks = [&](uint64_t host_ns) {
+    EXPECT_EQ(table.sample_row(0, smi::group_bit(smi::metric_group::clocks)),
+              AMDSMI_STATUS_SUCCESS);
+    return tracker.update(0, table.samples()[0].throttle_status, host_ns,
+                          ended);
+  };
+
+  // The first sample only sets the baseline.
+  sample_clocks(100);
+  EXPECT_EQ(table.samples()[0].gfx_clock, 2100);
+  EXPECT_EQ(table.samples()[0].throttle_status, 0);
+
+  sample_clocks(200);
+  EXPECT_EQ(table.samples()[0].throttle_status, smi::residency_throttler::ppt);
+  EXPECT_TRUE(tracker.active(0, smi::throttle_cause::power));
+
+  sample_clocks(300);
+  EXPECT_EQ(table.samples()[0].throttle_status,
+            smi::residency_throttler::ppt |
+                smi::residency_throttler::socket_thermal);
+
+  // No firmware accumulation since the last read keeps the status.
+  EXPECT_EQ(sample_clocks(350), 0);
+  EXPECT_TRUE(tracker.active(0, smi::throttle_cause::power));
+
+  EXPECT_EQ(sample_clocks(400), 1);
+  EXPECT_EQ(table.samples()[0].throttle_status,
+            smi::residency_throttler::socket_thermal);
+  ASSERT_EQ(ended.size(), 1);
+  EXPECT_EQ(ended[0].cause, smi::throttle_cause::power);
+  EXPECT_EQ(ended[0].begin_ns, 200);
+  EXPECT_EQ(ended[0].end_ns, 400);
+  EXPECT_TRUE(tracker.active(0, smi::throttle_cause::thermal));
+}
+
+TEST_F(ProcessorTableTest, XcpActivityIsPackedPerRow) {
+  constexpr auto not_supported =
+      rocprofsys::amd_smi::metric_value_not_supported;
+  auto only_engines = [&](std::size_t vcn_engines) {
+    amdsmi_gpu_metrics_t metrics = gpu_metrics;
+    for (auto &xcp_stats : metrics.xcp_stats) {
+      std::fill(std::begin(xcp_stats.vcn_busy), std::end(xcp_stats.vcn_busy),
+                not_supported);
+      std::fill(std::begin(xcp_stats.jpeg_busy),
+                std::end(xcp_stats.jpeg_busy), not_supported);
+    }
+    for (std::size_t engine = 0; engine < vcn_engines; ++engine) {
+      metrics.xcp_stats[0].vcn_busy[engine] = static_cast<uint16_t>(engine);
+    }
+    return metrics;
+  };
+  auto second_gpu = reinterpret_cast<amdsmi_processor_handle>(0x3000);
+  ON_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _))
+      .WillByDefault(DoAll(SetArgPointee<1>(only_engines(1)),
+                           Return(AMDSMI_STATUS_SUCCESS)));
+  ON_CALL(*mock_driver, get_gpu_metrics_info(second_gpu, _))
+      .WillByDefault(DoAll(SetArgPointee<1>(only_engines(3)),
+                           Return(AMDSMI_STATUS_SUCCESS)));
+
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.add(cpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  table.add(second_gpu, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  ASSERT_EQ(table.sample(), 2);
+
+  EXPECT_EQ(table.get_xcp_engine_layout(0).size(), 1);
+  EXPECT_EQ(table.xcp_activity(1).size(), 0);
+  auto activity = table.xcp_activity(2);
+  ASSERT_EQ(activity.size(), 3);
+  EXPECT_EQ(activity[0], 0);
+  EXPECT_EQ(activity[2], 2);
+}
+
+TEST_F(ProcessorTableTest, ReconcileProbesOnlyNewProcessors) {
+  using rocprofsys::amd_smi::discovered_processor;
+  rocprofsys::amd_smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU, 1);
+  table.add(cpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_CPU, 2);
+  table.probe();
+  ASSERT_EQ(table.sample(), 1);
+
+  auto reset_handle = reinterpret_cast<amdsmi_processor_handle>(0x1001);
+  auto new_handle = reinterpret_cast<amdsmi_processor_handle>(0x3000);
+  // The known GPU is rebound without probing; only the new GPU is probed.
+  EXPECT_CALL(*mock_driver, get_power_info(reset_handle, _)).Times(0);
+  EXPECT_CALL(*mock_driver, get_power_info(new_handle, _)).Times(1);
+
+  std::vector<discovered_processor> discovered{
+      {reset_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU, 1},
+      {new_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU, 3}};
+  auto diff = table.reconcile(discovered);
+
+  EXPECT_EQ(diff.added, (std::vector<std::size_t>{2}));
+  EXPECT_EQ(diff.retired, (std::vector<std::size_t>{1}));
+  EXPECT_EQ(diff.rebound, (std::vector<std::size_t>{0}));
+  ASSERT_EQ(table.size(), 3);
+  EXPECT_EQ(table.handles()[0], reset_handle);
+  EXPECT_EQ(table.samples()[0].current_socket_power, 140);
+  EXPECT_TRUE(table.retired(1));
+  EXPECT_NE(table.capabilities()[2], 0);
+
+  // A vanished processor coming back reuses its row.
+  discovered.push_back({cpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_CPU, 2});
+  diff = table.reconcile(discovered);
+  EXPECT_EQ(diff.added, (std::vector<std::size_t>{1}));
+  EXPECT_FALSE(table.retired(1));
+  EXPECT_EQ(table.size(), 3);
+  EXPECT_TRUE(table.reconcile(discovered).empty());
+}
+
+TEST_F(ProcessorTableTest, MemoryGroupReadsEverySupportedType) {
+  auto memory_driver = std::make_shared<NiceMock<mock_memory_driver>>();
+  ON_CALL(*memory_driver, get_memory_usage(_, _, _))
+      .WillByDefault([](amdsmi_processor_handle, amdsmi_memory_type_t type,
+                        uint64_t *used) {
+        if (type == AMDSMI_MEM_TYPE_VIS_VRAM) {
+          return AMDSMI_STATUS_NOT_SUPPORTED;
+        }
+        *used = type == AMDSMI_MEM_TYPE_GTT ? 512 : 4096;
+        return AMDSMI_STATUS_SUCCESS;
+      });
+  ON_CALL(*memory_driver, get_memory_total(_, _, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<2>(65536), Return(AMDSMI_STATUS_SUCCESS)));
+
+  rocprofsys::amd_smi::processor_table<mock_memory_driver> table{
+      memory_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  // A memory-only round reads VRAM and GTT, not the GPU metrics table.
+  EXPECT_CALL(*memory_driver, get_gpu_metrics_info(_, _)).Times(0);
+  EXPECT_CALL(*memory_driver, get_memory_usage(gpu_handle, _, _)).Times(2);
+  auto memory_group =
+      rocprofsys::amd_smi::group_bit(rocprofsys::amd_smi::metric_group::memory);
+  ASSERT_EQ(table.sample_row(0, memory_group), AMDSMI_STATUS_SUCCESS);
+
+  const auto &memory = table.memory()[0];
+  EXPECT_EQ(memory.used_bytes(AMDSMI_MEM_TYPE_VRAM), 4096);
+  EXPECT_EQ(memory.used_bytes(AMDSMI_MEM_TYPE_GTT), 512);
+  EXPECT_EQ(memory.used_bytes(AMDSMI_MEM_TYPE_VIS_VRAM), 0);
+  EXPECT_EQ(memory.total_bytes(AMDSMI_MEM_TYPE_GTT), 65536);
+  EXPECT_EQ(memory.total_bytes(AMDSMI_MEM_TYPE_VIS_VRAM), 0);
+  EXPECT_EQ(table.samples()[0].memory_usage, 4096);
+}
@@ -1,11 +1,13 @@
 #include "smi/processor.hpp"
 #include "gmock/gmock.h"
+#include <algorithm>
 #include <amd_smi/amdsmi.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 using ::testing::_;
 using ::testing::DoAll;
@@ -27,8 +29,6 @@ struct mock_processor_driver {
               ());
   MOCK_METHOD(amdsmi_status_t, get_gpu_metrics_info,
               (amdsmi_processor_handle, amdsmi_gpu_metrics_t *), ());
-  MOCK_METHOD(amdsmi_status_t, get_gpu_memory_usage,
-              (amdsmi_processor_handle, amdsmi_memory_type_t, uint64_t *), ());
 };
 
 class ProcessorTest : public ::testing::Test {
@@ -113,6 +113,13 @@ TEST_F(ProcessorTest, GetSupportedMetricsAllSupported) {
               get_memory_usage(processor_handle, AMDSMI_MEM_TYPE_VRAM, _))
       .WillOnce(
           DoAll(SetArgPointee<2>(memory_usage), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*mock_driver,
+              get_memory_usage(processor_handle, AMDSMI_MEM_TYPE_VIS_VRAM, _))
+      .WillOnce(
+          DoAll(SetArgPointee<2>(memory_usage), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*mock_driver,
+              get_memory_usage(processor_handle, AMDSMI_MEM_TYPE_GTT, _))
+      .WillOnce(Return(AMDSMI_STATUS_NOT_SUPPORTED));
 
   EXPECT_CALL(*mock_driver,
               get_temperature_metric(processor_handle,
@@ -139,12 +146,74 @@ TEST_F(ProcessorTest, GetSupportedMetricsAllSupported) {
   EXPECT_TRUE(metrics.mm_activity);
   EXPECT_TRUE(metrics.umc_activity);
   EXPECT_TRUE(metrics.memory_usage);
+  EXPECT_EQ(metrics.memory_types, (1u << AMDSMI_MEM_TYPE_VRAM) |
+                                      (1u << AMDSMI_MEM_TYPE_VIS_VRAM));
   EXPECT_TRUE(metrics.edge_temperature);
   EXPECT_TRUE(metrics.hotspot_temperature);
   EXPECT_TRUE(metrics.vcn_xcp_stats);
   EXPECT_TRUE(metrics.jpeg_xcp_stats);
 }
 
+TEST_F(ProcessorTest, GetSmiMetricsPacksSupportedXcpEngines) {
+  constexpr auto not_supported =
+      rocprofsys::amd_smi::metric_value_not_supported;
+  amdsmi_power_info_t power_info = {};
+  int64_t temperature = 50;
+  uint64_t memory_usage = 8192;
+
+  amdsmi_gpu_metrics_t gpu_metrics = {};
+  for (auto &xcp_stats : gpu_metrics.xcp_stats) {
+    std::fill(std::begin(xcp_stats.vcn_busy), std::end(xcp_stats.vcn_busy),
+              not_supported);
+    std::fill(std::begin(xcp_stats.jpeg_busy), std::end(xcp_stats.jpeg_busy),
+              not_supported);
+  }
+  gpu_metrics.xcp_stats[0].vcn_busy[1] = 25;
+  gpu_metrics.xcp_stats[2].jpeg_busy[3] = 40;
+
+  EXPECT_CALL(*mock_driver, get_power_info(processor_handle, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(power_info), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*mock_driver, get_gpu_activity(processor_handle, _))
+      .WillOnce(Return(AMDSMI_STATUS_SUCCESS));
+  // Three memory types probed, then VRAM read by get_smi_metrics().
+  EXPECT_CALL(*mock_driver, get_memory_usage(processor_handle, _, _))
+      .Times(4)
+      .WillRepeatedly(
+          DoAll(SetArgPointee<2>(memory_usage), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*mock_driver, get_temperature_metric(processor_handle, _, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          DoAll(SetArgPointee<3>(temperature), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(processor_handle, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(gpu_metrics), Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce([](amdsmi_processor_handle, amdsmi_gpu_metrics_t *metrics) {
+        *metrics = {};
+        metrics->xcp_stats[0].vcn_busy[1] = 30;
+        metrics->xcp_stats[2].jpeg_busy[3] = 45;
+        return AMDSMI_STATUS_SUCCESS;
+      });
+
+  auto supported = test_processor->get_supported_metrics();
+  EXPECT_TRUE(supported.vcn_xcp_stats);
+  EXPECT_TRUE(supported.jpeg_xcp_stats);
+
+  const auto &layout = test_processor->get_xcp_engine_layout();
+  ASSERT_EQ(layout.size(), 2);
+  EXPECT_EQ(layout.slots()[0].xcp, 0);
+  EXPECT_EQ(layout.slots()[0].kind, rocprofsys::amd_smi::xcp_engine_kind::vcn);
+  EXPECT_EQ(layout.slots()[0].engine, 1);
+  EXPECT_EQ(layout.slots()[1].xcp, 2);
+  EXPECT_EQ(layout.slots()[1].kind, rocprofsys::amd_smi::xcp_engine_kind::jpeg);
+  EXPECT_EQ(layout.slots()[1].engine, 3);
+
+  std::vector<uint16_t> xcp_activity(layout.size());
+  test_processor->get_smi_metrics(xcp_activity);
+  EXPECT_EQ(xcp_activity[0], 30);
+  EXPECT_EQ(xcp_activity[1], 45);
+}
+
 // TEST_F(ProcessorTest, GetSupportedMetricsPowerInfoFails) {
 //   amdsmi_engine_usage_t engine_usage = {};
 //   uint64_t memory_usage = 8192;
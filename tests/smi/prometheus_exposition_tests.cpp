@@ -0,0 +1,278 @@
+#include "mock_sampling_driver.hpp"
+#include "smi/metrics_endpoint.hpp"
+#include "smi/prometheus_exposition.hpp"
+#include <amd_smi/amdsmi.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::HasSubstr;
+using ::testing::NiceMock;
+using ::testing::Not;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+void set_gpu_metrics(mock_sampling_driver &driver, uint16_t power,
+                     uint16_t hotspot) {
+  amdsmi_gpu_metrics_t gpu_metrics = {};
+  gpu_metrics.current_socket_power = power;
+  gpu_metrics.temperature_hotspot = hotspot;
+  set_default_answers(driver, gpu_metrics);
+}
+
+std::string exchange(const sockaddr *address, socklen_t length, int domain,
+                     const std::string &request) {
+  int fd = socket(domain, SOCK_STREAM, 0);
+  if (connect(fd, address, length) != 0) {
+    close(fd);
+    return {};
+  }
+  send(fd, request.data(), request.size(), 0);
+  std::string response;
+  char buffer[1024];
+  ssize_t received;
+  while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, static_cast<std::size_t>(received));
+  }
+  close(fd);
+  return response;
+}
+
+std::string http_get(uint16_t port, const std::string &path) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return exchange(reinterpret_cast<sockaddr *>(&address), sizeof(address),
+                  AF_INET, "GET " + path + " HTTP/1.0\r\n\r\n");
+}
+} // namespace
+
+class PrometheusExpositionTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mock_driver = std::make_shared<NiceMock<mock_sampling_driver>>();
+    set_gpu_metrics(*mock_driver, 140, 60);
+  }
+
+  std::shared_ptr<NiceMock<mock_sampling_driver>> mock_driver;
+};
+
+TEST_F(PrometheusExpositionTest, RerendersOnlyRefreshedGroups) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  table.sample();
+
+  smi::prometheus_exposition exposition{table.size()};
+  smi::node_snapshot node{};
+  node.round = 1;
+  exposition.update(table, {}, node);
+  auto first = exposition.page();
+  EXPECT_THAT(*first, HasSubstr("# TYPE smi_current_socket_power_watts gauge\n"
+                                "smi_current_socket_power_watts"
+                                "{processor=\"0\"} 140\n"));
+  EXPECT_THAT(*first,
+              HasSubstr("smi_hotspot_temperature_celsius{processor=\"0\"} 60"));
+  EXPECT_THAT(*first, HasSubstr("smi_rounds_total 1\n"));
+
+  // Only power is due: the temperature line keeps its rendered value.
+  set_gpu_metrics(*mock_driver, 200, 90);
+  std::vector<smi::group_mask> due{smi::group_bit(smi::metric_group::power)};
+  table.sample_row(0, due[0]);
+  exposition.update(table, due, node);
+  auto second = exposition.page();
+  EXPECT_THAT(*second,
+              HasSubstr("smi_current_socket_power_watts{processor=\"0\"} 200"));
+  EXPECT_THAT(*second,
+              HasSubstr("smi_hotspot_temperature_celsius{processor=\"0\"} 60"));
+  // Pages handed out earlier are immutable.
+  EXPECT_THAT(*first, Not(HasSubstr("200")));
+
+  exposition.remove(0);
+  exposition.update(table, std::vector<smi::group_mask>{0}, node);
+  EXPECT_THAT(*exposition.page(), Not(HasSubstr("processor=\"0\"")));
+}
+
+TEST_F(PrometheusExpositionTest, ExportsDerivedMetrics) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  table.sample();
+
+  smi::derived_metrics derived{smi::standard_derived_metrics(), table.size()};
+  derived.update(table);
+  smi::prometheus_exposition exposition{table.size()};
+  exposition.update(table, {}, smi::node_snapshot{}, &derived);
+  auto page = exposition.page();
+  EXPECT_THAT(*page, HasSubstr("# TYPE smi_thermal_headroom gauge\n"
+                               "smi_thermal_headroom{processor=\"0\"} 60\n"));
+  EXPECT_THAT(*page, HasSubstr("smi_node_thermal_headroom 60\n"));
+}
+
+TEST_F(PrometheusExpositionTest, LeavesOutUnsupportedDerivedMetrics) {
+  amdsmi_gpu_metrics_t gpu_metrics = {};
+  gpu_metrics.current_socket_power = 140;
+  gpu_metrics.temperature_hotspot = 60;
+  set_default_answers(*mock_driver, gpu_metrics);
+  ON_CALL(*mock_driver,
+          get_temperature_metric(_, AMDSMI_TEMPERATURE_TYPE_EDGE, _, _))
+      .WillByDefault(Return(AMDSMI_STATUS_NOT_SUPPORTED));
+
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  table.sample();
+
+  smi::derived_metrics derived{smi::standard_derived_metrics(), table.size()};
+  derived.update(table);
+  smi::prometheus_exposition exposition{table.size()};
+  exposition.update(table, {}, smi::node_snapshot{}, &derived);
+  auto page = exposition.page();
+  EXPECT_THAT(*page, HasSubstr("smi_perf_per_watt{processor=\"0\"}"));
+  EXPECT_THAT(*page, Not(HasSubstr("thermal_headroom")));
+}
+
+TEST(MetricsEndpointTest, ServesPageOverLoopbackAndUnixSocket) {
+  auto page = std::make_shared<const std::string>("smi_rounds_total 7\n");
+  smi::metrics_endpoint endpoint{{.port = 0}, [&] { return page; }};
+  ASSERT_NE(endpoint.port(), 0);
+
+  auto response = http_get(endpoint.port(), "/metrics");
+  EXPECT_THAT(response, HasSubstr("HTTP/1.0 200 OK\r\n"));
+  EXPECT_THAT(response, HasSubstr("Content-Length: 19\r\n"));
+  EXPECT_THAT(response, HasSubstr("\r\n\r\nsmi_rounds_total 7\n"));
+  EXPECT_THAT(http_get(endpoint.port(), "/other"), HasSubstr("404"));
+  EXPECT_EQ(endpoint.requests(), 2);
+
+  auto path = ::testing::TempDir() + "smi_metrics.sock";
+  smi::metrics_endpoint local{{.unix_path = path}, [&] { return page; }};
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::copy(path.begin(), path.end(), address.sun_path);
+  auto unix_response =
+      exchange(reinterpret_cast<sockaddr *>(&address), sizeof(address),
+               AF_UNIX, "GET /metrics HTTP/1.0\r\n\r\n");
+  EXPECT_THAT(unix_response, HasSubstr("smi_rounds_total 7\n"));
+}
+
+TEST(MetricsEndpointTest, ReplacesOnlyStaleUnixSockets) {
+  auto page = std::make_shared<const std::string>("smi_rounds_total 7\n");
+  auto source = [&] { return page; };
+  auto path = ::testing::TempDir() + "smi_stale_" +
+              std::to_string(getpid()) + ".sock";
+
+  // A regular file at the path is never removed.
+  { std::ofstream{path} << "data"; }
+  EXPECT_THROW((smi::metrics_endpoint{{.unix_path = path}, source}),
+               std::runtime_error);
+  EXPECT_TRUE(std::filesystem::is_regular_file(path));
+  std::filesystem::remove(path);
+
+  // Nor is a socket another endpoint still listens on.
+  {
+    smi::metrics_endpoint live{{.unix_path = path}, source};
+    EXPECT_THROW((smi::metrics_endpoint{{.unix_path = path}, source}),
+                 std::runtime_error);
+  }
+
+  // A socket left behind by an exited process is replaced.
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::copy(path.begin(), path.end(), address.sun_path);
+  int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(
+      bind(stale, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+  close(stale);
+  smi::metrics_endpoint replaced{{.unix_path = path}, source};
+  EXPECT_THAT(exchange(reinterpret_cast<sockaddr *>(&address),
+                       sizeof(address), AF_UNIX,
+                       "GET /metrics HTTP/1.0\r\n\r\n"),
+              HasSubstr("smi_rounds_total 7\n"));
+}
+
+TEST(MetricsEndpointTest, DropsClientsThatDoNotRead) {
+  auto large = std::make_shared<const std::string>(std::string(32 << 20, '#'));
+  auto small = std::make_shared<const std::string>("smi_rounds_total 7\n");
+  std::atomic<int> scrapes{0};
+  smi::metrics_endpoint endpoint{
+      {.port = 0}, [&] { return scrapes++ == 0 ? large : small; }};
+
+  // A scraper that asks for a large page and never reads it.
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(endpoint.port());
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int stalled = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(stalled, reinterpret_cast<sockaddr *>(&address),
+                    sizeof(address)),
+            0);
+  std::string request{"GET /metrics HTTP/1.0\r\n\r\n"};
+  send(stalled, request.data(), request.size(), 0);
+
+  // It is dropped after the client timeout and the next scrape is served.
+  EXPECT_THAT(http_get(endpoint.port(), "/metrics"),
+              HasSubstr("smi_rounds_total 7\n"));
+  close(stalled);
+}
+
+TEST_F(PrometheusExpositionTest, LeavesOutUnsupportedMetrics) {
+  amdsmi_gpu_metrics_t gpu_metrics = {};
+  gpu_metrics.current_socket_power = 140;
+  amdsmi_power_info_t power_info = {};
+  power_info.average_socket_power = smi::metric_value_not_supported;
+  set_default_answers(*mock_driver, gpu_metrics, power_info);
+
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  table.sample();
+
+  smi::prometheus_exposition exposition{table.size()};
+  exposition.update(table, {}, smi::node_snapshot{});
+  auto page = exposition.page();
+  EXPECT_THAT(*page,
+              HasSubstr("smi_current_socket_power_watts{processor=\"0\"} 140"));
+  // Neither a sample line nor an empty family for the unsupported metric.
+  EXPECT_THAT(*page, Not(HasSubstr("smi_average_socket_power_watts")));
+}
+
+TEST_F(PrometheusExpositionTest, ExportsVramUsageAbove4GiB) {
+  constexpr uint64_t used = uint64_t{80} << 30;
+  ON_CALL(*mock_driver, get_memory_usage(_, _, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<2>(used), Return(AMDSMI_STATUS_SUCCESS)));
+
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x1000),
+            AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  table.sample();
+
+  smi::prometheus_exposition exposition{table.size()};
+  exposition.update(table, {}, smi::node_snapshot{});
+  EXPECT_THAT(*exposition.page(),
+              HasSubstr("# TYPE smi_memory_used_bytes gauge\n"
+                        "smi_memory_used_bytes{processor=\"0\"} "
+                        "85899345920\n"));
+}
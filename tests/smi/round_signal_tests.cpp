@@ -0,0 +1,120 @@
+#include "smi/async_generator.hpp"
+#include "smi/round_signal.hpp"
+#include <coroutine>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <optional>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+// Minimal eagerly started coroutine used to drive the awaitables.
+struct task {
+  struct promise_type {
+    task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+task wait_rounds(smi::round_signal &signal, int count,
+                 std::vector<uint64_t> &seen) {
+  for (int i = 0; i < count; ++i) {
+    seen.push_back(co_await signal.next_round());
+  }
+}
+
+smi::async_generator<uint64_t> rounds(smi::round_signal &signal) {
+  for (;;) {
+    co_yield co_await signal.next_round();
+  }
+}
+
+smi::async_generator<int> finite() {
+  co_yield 1;
+  co_yield 2;
+}
+
+task consume(smi::async_generator<uint64_t> &stream, int count,
+             std::vector<uint64_t> &seen) {
+  for (int i = 0; i < count; ++i) {
+    auto value = co_await stream.next();
+    seen.push_back(value.value_or(0));
+  }
+}
+
+task drain(smi::async_generator<int> &stream, std::vector<int> &seen) {
+  while (auto value = co_await stream.next()) {
+    seen.push_back(*value);
+  }
+}
+} // namespace
+
+TEST(RoundSignalTest, ResumesWaitersOnPublish) {
+  smi::round_signal signal;
+  std::vector<uint64_t> seen;
+  wait_rounds(signal, 2, seen);
+  EXPECT_TRUE(seen.empty());
+
+  signal.publish();
+  ASSERT_EQ(seen.size(), 1);
+  EXPECT_EQ(seen[0], 1);
+  signal.publish();
+  signal.publish();
+  EXPECT_EQ(seen, (std::vector<uint64_t>{1, 2}));
+}
+
+TEST(RoundSignalTest, PublishBeforeAwaitDoesNotSuspend) {
+  smi::round_signal signal;
+  auto awaiter = signal.next_round();
+  signal.publish();
+  EXPECT_TRUE(awaiter.await_ready());
+}
+
+TEST(RoundSignalTest, ExecutorReceivesHandles) {
+  std::vector<std::coroutine_handle<>> posted;
+  smi::round_signal signal{
+      [&](std::coroutine_handle<> handle) { posted.push_back(handle); }};
+  std::vector<uint64_t> seen;
+  wait_rounds(signal, 1, seen);
+
+  signal.publish();
+  EXPECT_TRUE(seen.empty());
+  ASSERT_EQ(posted.size(), 1);
+  posted[0].resume();
+  EXPECT_EQ(seen.size(), 1);
+}
+
+TEST(AsyncGeneratorTest, StreamsOneValuePerRound) {
+  smi::round_signal signal;
+  auto stream = rounds(signal);
+  std::vector<uint64_t> seen;
+  consume(stream, 3, seen);
+
+  signal.publish();
+  signal.publish();
+  EXPECT_EQ(seen, (std::vector<uint64_t>{1, 2}));
+  signal.publish();
+  EXPECT_EQ(seen, (std::vector<uint64_t>{1, 2, 3}));
+}
+
+TEST(AsyncGeneratorTest, EndsWithNullopt) {
+  auto stream = finite();
+  std::vector<int> seen;
+  drain(stream, seen);
+  EXPECT_EQ(seen, (std::vector<int>{1, 2}));
+}
+
+TEST(AsyncGeneratorTest, DestroyedStreamIsNotResumed) {
+  smi::round_signal signal;
+  {
+    auto stream = rounds(signal);
+    std::vector<uint64_t> seen;
+    consume(stream, 1, seen);
+  }
+  signal.publish();
+  SUCCEED();
+}
@@ -0,0 +1,130 @@
+#include "smi/reductions.hpp"
+#include "smi/sample_batch.hpp"
+#include <amd_smi/amdsmi.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using rocprofsys::amd_smi::metric_column;
+using rocprofsys::amd_smi::sample_batch;
+using rocprofsys::amd_smi::smi_metrics;
+
+namespace {
+std::vector<uint32_t> make_column(std::size_t size, uint32_t seed) {
+  std::mt19937 generator{seed};
+  std::uniform_int_distribution<uint32_t> distribution{
+      0, std::numeric_limits<uint32_t>::max()};
+  std::vector<uint32_t> column(size);
+  for (auto &value : column) {
+    value = distribution(generator);
+  }
+  return column;
+}
+} // namespace
+
+TEST(ReductionsTest, KernelsMatchScalarReference) {
+  namespace smi = rocprofsys::amd_smi;
+  // Odd sizes exercise both the vector body and the scalar tail.
+  for (std::size_t size : {0, 1, 3, 7, 8, 9, 31, 1000, 1027}) {
+    auto column = make_column(size, static_cast<uint32_t>(size));
+    const uint32_t threshold = std::numeric_limits<uint32_t>::max() / 3;
+
+    EXPECT_EQ(smi::column_sum(column),
+              smi::detail::scalar_sum(column.data(), size));
+    EXPECT_EQ(smi::column_min(column),
+              smi::detail::scalar_min(column.data(), size));
+    EXPECT_EQ(smi::column_max(column),
+              smi::detail::scalar_max(column.data(), size));
+    EXPECT_EQ(smi::column_count_above(column, threshold),
+              smi::detail::scalar_count_above(column.data(), size, threshold));
+  }
+}
+
+TEST(ReductionsTest, SummarizeColumn) {
+  std::vector<uint32_t> column{4, 8, 15, 16, 23, 42};
+  auto summary = rocprofsys::amd_smi::summarize_column(column);
+  EXPECT_EQ(summary.sum, 108);
+  EXPECT_EQ(summary.min, 4);
+  EXPECT_EQ(summary.max, 42);
+  EXPECT_EQ(summary.count, 6);
+  EXPECT_DOUBLE_EQ(summary.mean(), 18.0);
+  EXPECT_DOUBLE_EQ(rocprofsys::amd_smi::column_mean(column), 18.0);
+}
+
+TEST(SampleBatchTest, AppendStoresEachMetricInItsOwnColumn) {
+  sample_batch batch{2, 4};
+  smi_metrics metrics{};
+  metrics.current_socket_power = 300;
+  metrics.hotspot_temperature = 80;
+  metrics.gfx_activity = 90;
+
+  EXPECT_TRUE(batch.append(1, metrics));
+  metrics.current_socket_power = 100;
+  EXPECT_TRUE(batch.append(1, metrics));
+
+  EXPECT_EQ(batch.size(0), 0);
+  ASSERT_EQ(batch.size(1), 2);
+  auto power = batch.column(1, metric_column::current_socket_power);
+  EXPECT_EQ(power[0], 300);
+  EXPECT_EQ(power[1], 100);
+  EXPECT_EQ(batch.column(1, metric_column::hotspot_temperature)[1], 80);
+
+  auto summary = batch.summarize(1, metric_column::current_socket_power);
+  EXPECT_EQ(summary.max, 300);
+  EXPECT_DOUBLE_EQ(summary.mean(), 200.0);
+  EXPECT_EQ(batch.count_above(1, metric_column::current_socket_power, 200), 1);
+}
+
+TEST(SampleBatchTest, AppendStopsAtCapacity) {
+  sample_batch batch{1, 2};
+  smi_metrics metrics{};
+  EXPECT_TRUE(batch.append(0, metrics));
+  EXPECT_TRUE(batch.append(0, metrics));
+  EXPECT_FALSE(batch.append(0, metrics));
+
+  batch.clear();
+  EXPECT_EQ(batch.size(0), 0);
+  EXPECT_TRUE(batch.append(0, metrics));
+}
+
+TEST(SampleBatchTest, AppendConvertsDriverRecords) {
+  std::vector<amdsmi_gpu_metrics_t> records(3);
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    records[i] = {};
+    records[i].current_socket_power = static_cast<uint16_t>(100 + i);
+    records[i].temperature_hotspot = static_cast<uint16_t>(60 + i);
+    records[i].average_umc_activity = static_cast<uint16_t>(i);
+  }
+  constexpr uint64_t mib = uint64_t{1} << 20;
+  std::vector<uint64_t> memory_usage{1024 * mib, 80 * 1024 * mib, 4 * mib};
+
+  sample_batch batch{1, 2};
+  EXPECT_EQ(batch.append(0, records, memory_usage), 2);
+  EXPECT_EQ(batch.column(0, metric_column::current_socket_power)[1], 101);
+  EXPECT_EQ(batch.column(0, metric_column::hotspot_temperature)[0], 60);
+  EXPECT_EQ(batch.column(0, metric_column::umc_activity)[1], 1);
+  EXPECT_EQ(batch.column(0, metric_column::memory_usage)[0], 1024);
+  // 80 GiB in MiB; as bytes it would not fit the 32-bit column.
+  EXPECT_EQ(batch.column(0, metric_column::memory_usage)[1], 80 * 1024);
+}
+
+TEST(SampleBatchTest, SummarizeLatestAcrossProcessors) {
+  sample_batch batch{3, 4};
+  smi_metrics metrics{};
+  metrics.current_socket_power = 10;
+  batch.append(0, metrics);
+  metrics.current_socket_power = 250;
+  batch.append(0, metrics);
+  metrics.current_socket_power = 150;
+  batch.append(2, metrics);
+
+  auto summary = batch.summarize_latest(metric_column::current_socket_power);
+  EXPECT_EQ(summary.count, 2);
+  EXPECT_EQ(summary.sum, 400);
+  EXPECT_EQ(summary.min, 150);
+  EXPECT_EQ(summary.max, 250);
+  EXPECT_EQ(
+      batch.count_latest_above(metric_column::current_socket_power, 200), 1);
+}
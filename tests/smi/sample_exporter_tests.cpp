@@ -0,0 +1,138 @@
+#include "smi/derived_metrics.hpp"
+#include "smi/processor.hpp"
+#include "smi/sample_exporter.hpp"
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace smi = rocprofsys::amd_smi;
+
+namespace {
+smi::smi_metrics make_metrics() {
+  smi::smi_metrics metrics{};
+  metrics.current_socket_power = 300;
+  metrics.memory_usage = 4096;
+  metrics.hotspot_temperature = 80;
+  metrics.gfx_activity = 95;
+  return metrics;
+}
+
+// Processor 0 reports power and temperature, processor 1 only activity.
+const std::vector<smi::capability_mask> supported{
+    smi::capability::current_socket_power |
+        smi::capability::hotspot_temperature,
+    smi::capability::gfx_activity};
+} // namespace
+
+TEST(SampleExporterTest, CsvHasColumnsOfSupportedMetricsOnly) {
+  std::string text;
+  {
+    smi::sample_exporter exporter{
+        smi::export_format::csv, supported,
+        [&](std::string_view chunk) { text.append(chunk); }};
+    exporter.write(0, 1000, make_metrics());
+    exporter.write(1, 2000, make_metrics());
+    EXPECT_EQ(exporter.rows(), 2);
+  }
+  EXPECT_EQ(text, "host_ns,processor,current_socket_power,"
+                  "hotspot_temperature,gfx_activity\n"
+                  "1000,0,300,80,\n"
+                  "2000,1,,,95\n");
+}
+
+TEST(SampleExporterTest, JsonLinesOmitUnsupportedFields) {
+  std::string text;
+  smi::sample_exporter exporter{
+      smi::export_format::json_lines, supported,
+      [&](std::string_view chunk) { text.append(chunk); }};
+  smi::sample_record record;
+  record.host_ns = 5;
+  record.processor = 1;
+  record.values[static_cast<std::size_t>(smi::metric_column::gfx_activity)] =
+      42;
+  exporter.write(record);
+  exporter.write(0, 6, make_metrics());
+  exporter.flush();
+  EXPECT_EQ(text, "{\"host_ns\":5,\"processor\":1,\"gfx_activity\":42}\n"
+                  "{\"host_ns\":6,\"processor\":0,"
+                  "\"current_socket_power\":300,"
+                  "\"hotspot_temperature\":80}\n");
+}
+
+TEST(SampleExporterTest, DerivedColumnsFollowNativeOnes) {
+  smi::derived_metrics derived{smi::standard_derived_metrics(), 2};
+  derived.update(0, make_metrics());
+
+  std::string text;
+  smi::sample_exporter exporter{
+      smi::export_format::csv, supported,
+      [&](std::string_view chunk) { text.append(chunk); }};
+  exporter.add_derived_columns(derived);
+  exporter.write(0, 1000, make_metrics(), derived.values(0));
+  exporter.write(1, 2000, make_metrics());
+  exporter.flush();
+  EXPECT_EQ(text, "host_ns,processor,current_socket_power,"
+                  "hotspot_temperature,gfx_activity,perf_per_watt,"
+                  "activity_weighted_power,thermal_headroom\n"
+                  "1000,0,300,80,,0.31666666666666665,285,80\n"
+                  "2000,1,,,95,,,\n");
+}
+
+TEST(SampleExporterTest, NonFiniteDerivedValuesAreNotWrittenAsNumbers) {
+  smi::derived_metrics derived{smi::standard_derived_metrics(), 1};
+  // Unsupported, a division by zero and a regular value.
+  std::vector<double> values{std::numeric_limits<double>::quiet_NaN(),
+                             std::numeric_limits<double>::infinity(), 20.0};
+  for (auto format :
+       {smi::export_format::csv, smi::export_format::json_lines}) {
+    std::string text;
+    smi::sample_exporter exporter{
+        format, supported,
+        [&](std::string_view chunk) { text.append(chunk); }};
+    exporter.add_derived_columns(derived);
+    exporter.write(1, 7, make_metrics(), values);
+    exporter.flush();
+    if (format == smi::export_format::csv) {
+      EXPECT_TRUE(text.ends_with("\n7,1,,,95,,,20\n")) << text;
+    } else {
+      EXPECT_EQ(text, "{\"host_ns\":7,\"processor\":1,\"gfx_activity\":95,"
+                      "\"activity_weighted_power\":null,"
+                      "\"thermal_headroom\":20}\n");
+    }
+  }
+}
+
+TEST(SampleExporterTest, FlushesInLargeChunks) {
+  std::vector<std::size_t> chunks;
+  {
+    smi::sample_exporter exporter{
+        smi::export_format::csv, supported,
+        [&](std::string_view chunk) { chunks.push_back(chunk.size()); },
+        4096};
+    for (uint64_t row = 0; row < 10000; ++row) {
+      exporter.write(0, row, make_metrics());
+    }
+    EXPECT_FALSE(chunks.empty());
+  }
+  for (std::size_t i = 0; i + 1 < chunks.size(); ++i) {
+    EXPECT_GE(chunks[i], 4096);
+  }
+}
+
+TEST(SampleExporterTest, DestructorDropsWriteErrors) {
+  std::size_t attempts{0};
+  auto failing = [&](std::string_view) {
+    ++attempts;
+    throw std::runtime_error("Failed to write samples: disk full");
+  };
+  {
+    smi::sample_exporter exporter{smi::export_format::csv, supported,
+                                  failing};
+    exporter.write(0, 1, make_metrics());
+    EXPECT_THROW(exporter.flush(), std::runtime_error);
+  }
+  EXPECT_EQ(attempts, 2); // The destructor tried again and kept going
+}
@@ -0,0 +1,306 @@
+#include "smi/daemon_client.hpp"
+#include "smi/sampling_daemon.hpp"
+#include "smi/subscription_protocol.hpp"
+#include <amd_smi/amdsmi.h>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace smi = rocprofsys::amd_smi;
+using smi::metric_column;
+
+namespace {
+// Stateless driver API with one socket holding one GPU
+struct daemon_driver_api {
+  static amdsmi_status_t init() { return AMDSMI_STATUS_SUCCESS; }
+  static amdsmi_status_t get_version(amdsmi_version_t *version) {
+    *version = amdsmi_version_t{1, 0, 0, "daemon"};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_socket_handles(uint32_t *count,
+                                            amdsmi_socket_handle *handles) {
+    *count = 1;
+    if (handles != nullptr) {
+      handles[0] = reinterpret_cast<amdsmi_socket_handle>(0x10);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t
+  get_processor_handles(amdsmi_socket_handle, uint32_t *count,
+                        amdsmi_processor_handle *handles) {
+    *count = 1;
+    if (handles != nullptr) {
+      handles[0] = reinterpret_cast<amdsmi_processor_handle>(0x1000);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_processor_type(amdsmi_processor_handle,
+                                            processor_type_t *type) {
+    *type = AMDSMI_PROCESSOR_TYPE_AMD_GPU;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  // Capability probes: every scalar metric is supported.
+  static amdsmi_status_t get_power_info(amdsmi_processor_handle,
+                                        amdsmi_power_info_t *info) {
+    *info = {};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_gpu_activity(amdsmi_processor_handle,
+                                          amdsmi_engine_usage_t *usage) {
+    *usage = {};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_memory_usage(amdsmi_processor_handle,
+                                          amdsmi_memory_type_t,
+                                          uint64_t *usage) {
+    *usage = 4096;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t
+  get_temperature_metric(amdsmi_processor_handle, amdsmi_temperature_type_t,
+                         amdsmi_temperature_metric_t, int64_t *temperature) {
+    *temperature = 0;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_gpu_metrics_info(amdsmi_processor_handle,
+                                              amdsmi_gpu_metrics_t *metrics) {
+    *metrics = {};
+    metrics->current_socket_power = 275;
+    metrics->temperature_hotspot = 71;
+    metrics->average_gfx_activity = 64;
+    metrics->system_clock_counter = 1234;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+struct daemon_driver_factory {
+  using driver_t = daemon_driver_api;
+  static constexpr driver_t create_driver() { return driver_t{}; }
+};
+
+// Same driver with more GPUs than a subscription can address
+struct crowded_driver_api : daemon_driver_api {
+  static constexpr uint32_t gpus = smi::max_subscribed_processors + 1;
+  static amdsmi_status_t
+  get_processor_handles(amdsmi_socket_handle, uint32_t *count,
+                        amdsmi_processor_handle *handles) {
+    *count = gpus;
+    for (uint32_t gpu = 0; handles != nullptr && gpu < gpus; ++gpu) {
+      handles[gpu] = reinterpret_cast<amdsmi_processor_handle>(
+          uintptr_t{0x1000} + gpu * 0x10);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+struct crowded_driver_factory {
+  using driver_t = crowded_driver_api;
+  static constexpr driver_t create_driver() { return driver_t{}; }
+};
+
+std::size_t open_fd_count() {
+  return static_cast<std::size_t>(std::distance(
+      std::filesystem::directory_iterator{"/proc/self/fd"},
+      std::filesystem::directory_iterator{}));
+}
+
+std::string socket_path(const char *name) {
+  return ::testing::TempDir() + name + std::to_string(getpid()) + ".sock";
+}
+
+smi::sampling_policy fast_policy() {
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{1};
+  for (auto &period : policy.periods) {
+    period = std::chrono::milliseconds{1};
+  }
+  return policy;
+}
+} // namespace
+
+TEST(SubscriptionProtocolTest, SubscriptionRoundTrips) {
+  smi::subscription request{0b101, 0b11, 25, 4};
+  auto decoded = smi::decode_subscription(smi::encode_subscription(request));
+  EXPECT_EQ(decoded.processors, 0b101);
+  EXPECT_EQ(decoded.columns, 0b11);
+  EXPECT_EQ(decoded.period_ms, 25);
+  EXPECT_EQ(decoded.batch, 4);
+
+  request.period_ms = 0;
+  EXPECT_THROW(smi::decode_subscription(smi::encode_subscription(request)),
+               std::runtime_error);
+  EXPECT_THROW(smi::decode_subscription("short"), std::runtime_error);
+
+  request.period_ms = 25;
+  request.columns = 0;
+  EXPECT_THROW(smi::decode_subscription(smi::encode_subscription(request)),
+               std::runtime_error);
+  request.columns = smi::all_metric_columns | (1u << smi::metric_column_count);
+  EXPECT_THROW(smi::decode_subscription(smi::encode_subscription(request)),
+               std::runtime_error);
+}
+
+TEST(SubscriptionProtocolTest, SamplesCarryOnlySelectedColumns) {
+  uint32_t columns =
+      (1u << static_cast<uint32_t>(metric_column::current_socket_power)) |
+      (1u << static_cast<uint32_t>(metric_column::gfx_activity));
+  smi::sample_record record;
+  record.host_ns = 42;
+  record.gpu_clock_counter = 7;
+  record.processor = 3;
+  record.values.fill(9);
+
+  auto payload = smi::begin_samples(columns);
+  smi::encode_record(payload, columns, record);
+  smi::encode_record(payload, columns, record);
+  EXPECT_EQ(payload.size(), 4 + 2 * (20 + 2 * 4));
+
+  auto decoded = smi::decode_samples(payload);
+  ASSERT_EQ(decoded.size(), 2);
+  EXPECT_EQ(decoded[1].host_ns, 42);
+  EXPECT_EQ(decoded[1].gpu_clock_counter, 7);
+  EXPECT_EQ(decoded[1].processor, 3);
+  EXPECT_EQ(decoded[1].value(metric_column::current_socket_power), 9);
+  EXPECT_EQ(decoded[1].value(metric_column::gfx_activity), 9);
+  EXPECT_EQ(decoded[1].value(metric_column::edge_temperature), 0);
+
+  payload.pop_back();
+  EXPECT_THROW(smi::decode_samples(payload), std::runtime_error);
+
+  // Columns without a metric carry no value.
+  uint32_t padded = columns | (1u << 31);
+  payload = smi::begin_samples(padded);
+  smi::encode_record(payload, padded, record);
+  decoded = smi::decode_samples(payload);
+  ASSERT_EQ(decoded.size(), 1);
+  EXPECT_EQ(decoded[0].value(metric_column::gfx_activity), 9);
+}
+
+TEST(SubscriptionProtocolTest, MemoryColumnCarriesVramBytesAbove4GiB) {
+  constexpr uint64_t used = uint64_t{80} << 30;
+  smi::smi_metrics metrics{};
+  metrics.current_socket_power = 300;
+  auto record = smi::to_sample_record(2, metrics, used, {});
+  EXPECT_EQ(record.value(metric_column::memory_usage), used);
+
+  uint32_t columns = 1u << static_cast<uint32_t>(metric_column::memory_usage);
+  EXPECT_EQ(smi::record_size(columns), 28);
+  auto payload = smi::begin_samples(smi::all_metric_columns);
+  smi::encode_record(payload, smi::all_metric_columns, record);
+  EXPECT_EQ(payload.size(), 4 + smi::record_size(smi::all_metric_columns));
+
+  auto decoded = smi::decode_samples(payload);
+  ASSERT_EQ(decoded.size(), 1);
+  EXPECT_EQ(decoded[0].value(metric_column::memory_usage), used);
+  EXPECT_EQ(decoded[0].value(metric_column::current_socket_power), 300);
+}
+
+TEST(SubscriptionProtocolTest, FrameReaderReassemblesSplitFrames) {
+  auto stream = smi::encode_frame(smi::frame_type::error, "first") +
+                smi::encode_frame(smi::frame_type::subscribed, "second");
+  smi::frame_reader reader;
+  reader.feed(stream.substr(0, 7));
+  EXPECT_FALSE(reader.next());
+  reader.feed(stream.substr(7, 14));
+  auto first = reader.next();
+  ASSERT_TRUE(first);
+  EXPECT_EQ(first->type, smi::frame_type::error);
+  EXPECT_EQ(first->payload, "first");
+  EXPECT_FALSE(reader.next());
+  reader.feed(stream.substr(21));
+  auto second = reader.next();
+  ASSERT_TRUE(second);
+  EXPECT_EQ(second->type, smi::frame_type::subscribed);
+  EXPECT_EQ(second->payload, "second");
+
+  smi::frame_reader corrupt;
+  corrupt.feed(std::string(smi::frame_header_size, 'x'));
+  EXPECT_THROW(corrupt.next(), std::runtime_error);
+}
+
+TEST(SamplingDaemonTest, ClientReceivesSubscribedSamples) {
+  auto path = socket_path("smi-daemon-");
+  smi::sampling_daemon<daemon_driver_factory> daemon{path, fast_policy()};
+
+  smi::subscription request;
+  request.period_ms = 1;
+  request.batch = 2;
+  smi::daemon_client client{path, request};
+  ASSERT_EQ(client.processor_count(), 1);
+
+  auto records = client.next_batch(std::chrono::seconds{5});
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].processor, 0);
+  EXPECT_EQ(records[0].value(metric_column::current_socket_power), 275);
+  EXPECT_EQ(records[0].value(metric_column::memory_usage), 4096);
+  EXPECT_EQ(records[0].gpu_clock_counter, 1234);
+
+  const auto &samples = client.read();
+  ASSERT_EQ(samples.size(), 1);
+  EXPECT_EQ(samples[0].power, 275);
+  EXPECT_EQ(samples[0].temperature, 71);
+  EXPECT_EQ(samples[0].usage, 64);
+  EXPECT_EQ(client.read_metrics(0).gfx_activity, 64);
+  EXPECT_EQ(client.read_memory(0).used[AMDSMI_MEM_TYPE_VRAM], 4096);
+  EXPECT_EQ(daemon.client_count(), 1);
+
+  auto statuses = daemon.get_collector().read_statuses();
+  ASSERT_EQ(statuses.size(), 1);
+  EXPECT_EQ(statuses[0], AMDSMI_STATUS_SUCCESS);
+}
+
+TEST(SamplingDaemonTest, RejectsSubscriptionsToUnknownColumns) {
+  auto path = socket_path("smi-columns-");
+  smi::sampling_daemon<daemon_driver_factory> daemon{path, fast_policy()};
+
+  smi::subscription request;
+  request.columns = smi::all_metric_columns | (1u << 8);
+  EXPECT_THROW((smi::daemon_client{path, request}), std::runtime_error);
+  request.columns = 0;
+  EXPECT_THROW((smi::daemon_client{path, request}), std::runtime_error);
+}
+
+TEST(SamplingDaemonTest, ClientConnectFailsWithoutDaemon) {
+  EXPECT_THROW(smi::daemon_client{socket_path("smi-missing-")},
+               std::runtime_error);
+}
+
+TEST(SamplingDaemonTest, RejectsSubscriptionsBeyondAddressableProcessors) {
+  auto path = socket_path("smi-crowded-");
+  smi::sampling_daemon<crowded_driver_factory> daemon{path, fast_policy()};
+
+  auto before = open_fd_count();
+  try {
+    smi::daemon_client client{path};
+    FAIL() << "Subscription was accepted";
+  } catch (const std::runtime_error &error) {
+    EXPECT_NE(std::string{error.what()}.find("65 processors"),
+              std::string::npos);
+  }
+  // The rejected client closed its socket; the daemon closes its end once
+  // the error is sent.
+  for (int attempt = 0; attempt < 100 && open_fd_count() != before;
+       ++attempt) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  EXPECT_EQ(open_fd_count(), before);
+}
+
+TEST(SamplingDaemonTest, FailedStartReleasesSocketAndEventfd) {
+  auto path = socket_path("smi-unplaced-");
+  auto policy = fast_policy();
+  policy.placement.cpus = {-1};
+
+  auto before = open_fd_count();
+  EXPECT_THROW(
+      (smi::sampling_daemon<daemon_driver_factory>{path, policy}),
+      std::system_error);
+  EXPECT_EQ(open_fd_count(), before);
+  EXPECT_FALSE(std::filesystem::exists(path));
+}
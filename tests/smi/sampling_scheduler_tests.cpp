@@ -0,0 +1,415 @@
+#include "mock_sampling_driver.hpp"
+#include "smi/adaptive_sampling.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/sampler_overhead.hpp"
+#include "smi/sampling_scheduler.hpp"
+#include "smi/supervised_reader.hpp"
+#include "smi/thread_placement.hpp"
+#include "smi/timer_wheel.hpp"
+#include <amd_smi/amdsmi.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sched.h>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::DoAll;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace smi = rocprofsys::amd_smi;
+
+TEST(TimerWheelTest, ExpiresOnDeadline) {
+  smi::timer_wheel<int> wheel{4};
+  wheel.schedule(1, 10);
+  wheel.schedule(3, 30);
+  // Further than one revolution: must survive passes over its slot.
+  wheel.schedule(6, 60);
+  EXPECT_EQ(wheel.size(), 3);
+
+  std::vector<int> expired;
+  auto collect = [&](int payload) { expired.push_back(payload); };
+  for (int tick = 0; tick < 6; ++tick) {
+    wheel.advance(collect);
+  }
+
+  EXPECT_EQ(expired, (std::vector<int>{10, 30, 60}));
+  EXPECT_EQ(wheel.size(), 0);
+  EXPECT_EQ(wheel.now(), 6);
+}
+
+TEST(TimerWheelTest, CallbackMayReschedule) {
+  smi::timer_wheel<int> wheel{8};
+  wheel.schedule(2, 1);
+
+  std::size_t fired{0};
+  for (int tick = 0; tick < 10; ++tick) {
+    fired += wheel.advance([&](int payload) { wheel.schedule(2, payload); });
+  }
+  EXPECT_EQ(fired, 5);
+  EXPECT_EQ(wheel.size(), 1);
+}
+
+class SamplingSchedulerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mock_driver = std::make_shared<NiceMock<mock_sampling_driver>>();
+    gpu_handle = reinterpret_cast<amdsmi_processor_handle>(0x1000);
+
+    amdsmi_power_info_t power_info = {};
+    power_info.current_socket_power = 140;
+    amdsmi_gpu_metrics_t gpu_metrics = {};
+    gpu_metrics.current_socket_power = 140;
+    gpu_metrics.temperature_hotspot = 60;
+    gpu_metrics.average_gfx_activity = 75;
+
+    set_default_answers(*mock_driver, gpu_metrics, power_info);
+  }
+
+  std::shared_ptr<NiceMock<mock_sampling_driver>> mock_driver;
+  amdsmi_processor_handle gpu_handle;
+};
+
+TEST_F(SamplingSchedulerTest, GroupsFollowTheirPeriods) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  using std::chrono::milliseconds;
+  smi::sampling_policy policy;
+  policy.tick = milliseconds{10};
+  policy.periods.fill(milliseconds{40});
+  policy.period(smi::metric_group::power) = milliseconds{20};
+  policy.period(smi::metric_group::memory) = milliseconds{30};
+
+  std::vector<smi::group_mask> rounds;
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{
+      table, policy,
+      [&](const smi::processor_table<mock_sampling_driver> &,
+          std::span<const smi::group_mask> due) {
+        rounds.push_back(due[0]);
+      }};
+
+  // Every group is due on the first tick; afterwards power repeats every
+  // two ticks and memory every three. Tick 4 (memory only) must not read
+  // the GPU metrics table.
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _)).Times(2);
+  // Each memory round reads VRAM, visible VRAM and GTT.
+  EXPECT_CALL(*mock_driver, get_memory_usage(gpu_handle, _, _)).Times(6);
+
+  for (int tick = 0; tick < 4; ++tick) {
+    scheduler.tick();
+  }
+
+  auto bit = [](smi::metric_group group) { return smi::group_bit(group); };
+  ASSERT_EQ(rounds.size(), 3);
+  EXPECT_EQ(rounds[0], smi::all_metric_groups);
+  EXPECT_EQ(rounds[1], bit(smi::metric_group::power));
+  EXPECT_EQ(rounds[2], bit(smi::metric_group::memory));
+  EXPECT_EQ(scheduler.driver_calls(), 8);
+  EXPECT_EQ(table.statuses()[0], AMDSMI_STATUS_SUCCESS);
+}
+
+TEST_F(SamplingSchedulerTest, SkipsRowsWithoutCapabilities) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x2000),
+            AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  table.probe();
+
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{table, {}};
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(_, _)).Times(0);
+  EXPECT_EQ(scheduler.tick(), 0);
+}
+
+TEST_F(SamplingSchedulerTest, StartAndStopThread) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{1};
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{table, policy};
+  scheduler.start();
+  EXPECT_TRUE(scheduler.running());
+  scheduler.stop();
+  EXPECT_FALSE(scheduler.running());
+}
+
+TEST(ChangeDetectorTest, StrideGrowsWhileStableAndResetsOnChange) {
+  smi::adaptive_policy policy;
+  policy.enabled = true;
+  policy.max_stride = 4;
+  policy.power_tolerance = 5;
+  smi::change_detector detector{policy, 1};
+
+  smi::smi_metrics sample{};
+  sample.current_socket_power = 100;
+  EXPECT_EQ(detector.update(0, sample), 1);
+  EXPECT_EQ(detector.update(0, sample), 2);
+  sample.current_socket_power = 104;
+  EXPECT_EQ(detector.update(0, sample), 4);
+  EXPECT_EQ(detector.update(0, sample), 4);
+
+  // Drift is measured against the reference, not the previous sample.
+  sample.current_socket_power = 106;
+  EXPECT_EQ(detector.update(0, sample), 1);
+}
+
+TEST(ChangeDetectorTest, DisabledKeepsFullRate) {
+  smi::change_detector detector{smi::adaptive_policy{}, 1};
+  smi::smi_metrics sample{};
+  detector.update(0, sample);
+  EXPECT_EQ(detector.update(0, sample), 1);
+  EXPECT_EQ(detector.stride(0), 1);
+}
+
+TEST_F(SamplingSchedulerTest, AdaptiveStrideSnapsBackOnChange) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{10};
+  policy.periods.fill(std::chrono::milliseconds{10});
+  policy.adaptive.enabled = true;
+  policy.adaptive.max_stride = 4;
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{table, policy};
+
+  // Flat metrics: reads happen on ticks 1, 2, 4, 8 and 12.
+  std::size_t reads{0};
+  for (int tick = 0; tick < 12; ++tick) {
+    reads += scheduler.tick();
+  }
+  EXPECT_EQ(reads, 5);
+  EXPECT_EQ(scheduler.stride(0), 4);
+
+  amdsmi_gpu_metrics_t busy = {};
+  busy.current_socket_power = 400;
+  busy.average_gfx_activity = 100;
+  ON_CALL(*mock_driver, get_gpu_metrics_info(_, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<1>(busy), Return(AMDSMI_STATUS_SUCCESS)));
+
+  // The change is seen within max_stride ticks and full rate resumes.
+  reads = 0;
+  for (int tick = 0; tick < 4; ++tick) {
+    reads += scheduler.tick();
+  }
+  EXPECT_EQ(reads, 1);
+  EXPECT_EQ(scheduler.stride(0), 1);
+  EXPECT_EQ(scheduler.tick(), 1);
+}
+
+TEST_F(SamplingSchedulerTest, AdaptiveStrideFollowsPowerAndActivityReads) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  using std::chrono::milliseconds;
+  smi::sampling_policy policy;
+  policy.tick = milliseconds{10};
+  policy.periods.fill(milliseconds{10});
+  policy.period(smi::metric_group::power) = milliseconds{40};
+  policy.period(smi::metric_group::activity) = milliseconds{40};
+  policy.adaptive.enabled = true;
+  policy.adaptive.max_stride = 8;
+  smi::group_mask last_due{0};
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{
+      table, policy,
+      [&](const smi::processor_table<mock_sampling_driver> &,
+          std::span<const smi::group_mask> due) { last_due = due[0]; }};
+
+  // Thermal-only ticks carry stale power and must not stretch the stride:
+  // it only grows on the power reads of ticks 1 and 5.
+  for (int tick = 0; tick < 8; ++tick) {
+    scheduler.tick();
+  }
+  EXPECT_EQ(scheduler.stride(0), 2);
+
+  amdsmi_gpu_metrics_t busy = {};
+  busy.current_socket_power = 400;
+  ON_CALL(*mock_driver, get_gpu_metrics_info(_, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<1>(busy), Return(AMDSMI_STATUS_SUCCESS)));
+
+  // Power is next due on tick 13 and sees the change; every group,
+  // including power, is then due on the following tick.
+  for (int tick = 8; tick < 13; ++tick) {
+    scheduler.tick();
+  }
+  EXPECT_EQ(scheduler.stride(0), 1);
+  scheduler.tick();
+  EXPECT_NE(last_due & smi::group_bit(smi::metric_group::power), 0);
+}
+
+TEST_F(SamplingSchedulerTest, FollowsReconciledRows) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU, 1);
+  table.probe();
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{table, {}};
+  EXPECT_EQ(scheduler.tick(), 1);
+
+  auto new_handle = reinterpret_cast<amdsmi_processor_handle>(0x3000);
+  std::vector<smi::discovered_processor> discovered{
+      {new_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU, 2}};
+  scheduler.post([&] {
+    auto diff = table.reconcile(discovered);
+    scheduler.add_rows(diff.added);
+  });
+
+  // The retired row is never read again; the new row is due immediately.
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(_, _)).Times(AnyNumber());
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(gpu_handle, _)).Times(0);
+  EXPECT_EQ(scheduler.tick(), 1);
+  EXPECT_EQ(table.statuses()[1], AMDSMI_STATUS_SUCCESS);
+  for (int tick = 0; tick < 100; ++tick) {
+    scheduler.tick();
+  }
+}
+
+TEST_F(SamplingSchedulerTest, PostToThreadNeverStrandsATask) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{1};
+  smi::sampling_scheduler<mock_sampling_driver> *self{nullptr};
+  std::atomic<bool> asked{false};
+  std::promise<bool> queued_from_round;
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{
+      table, policy,
+      [&](const smi::processor_table<mock_sampling_driver> &,
+          std::span<const smi::group_mask>) {
+        if (!asked.exchange(true)) {
+          queued_from_round.set_value(self->post_to_thread([] {}));
+        }
+      }};
+  self = &scheduler;
+
+  // Stopped, or called on the scheduler thread: the caller runs the task.
+  EXPECT_FALSE(scheduler.post_to_thread([] {}));
+  scheduler.start();
+  EXPECT_FALSE(queued_from_round.get_future().get());
+
+  // A task the thread did not reach before exiting runs in stop().
+  bool ran{false};
+  EXPECT_TRUE(scheduler.post_to_thread([&] { ran = true; }));
+  scheduler.stop();
+  EXPECT_TRUE(ran);
+}
+
+TEST(ThreadPlacementTest, ParsesCpuListsAndNumaNodes) {
+  EXPECT_EQ(smi::parse_cpu_list("0-3,8,10-11\n"),
+            (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_TRUE(smi::parse_cpu_list("").empty());
+  EXPECT_THROW(smi::parse_cpu_list("4-2"), std::invalid_argument);
+
+  auto root = std::filesystem::path{::testing::TempDir()} / "smi_numa";
+  std::filesystem::create_directories(root / "node1");
+  std::ofstream{root / "node1" / "cpulist"} << "16-17,20\n";
+  EXPECT_EQ(smi::numa_node_cpus(1, root.string()),
+            (std::vector<int>{16, 17, 20}));
+  EXPECT_THROW(smi::numa_node_cpus(7, root.string()), std::runtime_error);
+  EXPECT_TRUE(smi::thread_placement{}.empty());
+}
+
+TEST(LatencyHistogramTest, QuantilesFollowPowerOfTwoBuckets) {
+  smi::latency_histogram histogram;
+  for (int sample = 0; sample < 98; ++sample) {
+    histogram.record(500); // below 1 us
+  }
+  histogram.record(3'000);   // [2, 4) us
+  histogram.record(900'000); // [512, 1024) us
+
+  EXPECT_EQ(histogram.count(), 100);
+  EXPECT_EQ(histogram.bucket(0), 98);
+  EXPECT_EQ(histogram.bucket(2), 1);
+  EXPECT_EQ(histogram.quantile_ns(0.5), 1'000);
+  EXPECT_EQ(histogram.quantile_ns(0.985), 4'000);
+  EXPECT_EQ(histogram.quantile_ns(1.0), 900'000);
+  EXPECT_EQ(histogram.max_ns(), 900'000);
+}
+
+TEST_F(SamplingSchedulerTest, ReportsOverheadOfPinnedThread) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{1};
+  policy.placement.cpus = {sched_getcpu()};
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{table, policy};
+  scheduler.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds{30});
+  scheduler.stop();
+
+  auto overhead = scheduler.overhead();
+  ASSERT_GT(overhead.rounds, 1);
+  EXPECT_GT(overhead.cpu_time_ns, 0);
+  EXPECT_GE(overhead.max_round_cpu_ns, overhead.mean_round_cpu_ns());
+  EXPECT_EQ(overhead.wakeup_latency.count(), overhead.rounds);
+  EXPECT_EQ(overhead.tick_jitter.count(), overhead.rounds - 1);
+}
+
+TEST_F(SamplingSchedulerTest, OverheadIncludesReaderWorkers) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  // Every driver call burns about a millisecond of worker CPU time.
+  amdsmi_gpu_metrics_t gpu_metrics = {};
+  ON_CALL(*mock_driver, get_gpu_metrics_info(_, _))
+      .WillByDefault([gpu_metrics](amdsmi_processor_handle,
+                                   amdsmi_gpu_metrics_t *metrics) {
+        auto begin = smi::thread_cpu_time_ns();
+        while (smi::thread_cpu_time_ns() - begin < 1'000'000) {
+        }
+        *metrics = gpu_metrics;
+        return AMDSMI_STATUS_SUCCESS;
+      });
+
+  smi::supervised_reader<mock_sampling_driver> reader{
+      table, std::chrono::seconds{1}};
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{2};
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{table, policy};
+  scheduler.set_reader(&reader);
+  scheduler.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds{30});
+  scheduler.stop();
+
+  auto overhead = scheduler.overhead();
+  ASSERT_GT(overhead.rounds, 1);
+  EXPECT_GE(overhead.worker_cpu_time_ns, 1'000'000);
+  EXPECT_LE(overhead.worker_cpu_time_ns, reader.worker_cpu_time_ns());
+  EXPECT_GT(overhead.cpu_time_ns, overhead.worker_cpu_time_ns);
+}
+
+TEST_F(SamplingSchedulerTest, FailedPlacementNeverTicks) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(gpu_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  smi::sampling_policy policy;
+  policy.tick = std::chrono::milliseconds{1};
+  policy.placement.cpus = {-1};
+  std::atomic<int> rounds{0};
+  smi::sampling_scheduler<mock_sampling_driver> scheduler{
+      table, policy,
+      [&](const smi::processor_table<mock_sampling_driver> &,
+          std::span<const smi::group_mask>) { ++rounds; }};
+  EXPECT_THROW(scheduler.start(), std::system_error);
+  EXPECT_FALSE(scheduler.running());
+  EXPECT_EQ(rounds, 0);
+}
@@ -166,3 +166,233 @@ TEST_F(ServiceTest, GetProcessorsProcessorTypeFail) {
   rocprofsys::amd_smi::service<mock_driver_factory> svc;
   EXPECT_THROW(svc.get_processors(), std::runtime_error);
 }
+
+TEST_F(ServiceTest, GetProcessorTableSuccess) {
+  EXPECT_CALL(*g_mock_api_instance, init());
+  EXPECT_CALL(*g_mock_api_instance, get_version(_));
+  EXPECT_CALL(*g_mock_api_instance, get_socket_handles(_, _)).Times(2);
+  EXPECT_CALL(*g_mock_api_instance, get_processor_handles(_, _, nullptr))
+      .WillOnce(DoAll(SetArgPointee<1>(2), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*g_mock_api_instance,
+              get_processor_handles(_, _, testing::NotNull()))
+      .WillOnce(DoAll(SetArgPointee<1>(2), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*g_mock_api_instance, get_processor_type(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(AMDSMI_PROCESSOR_TYPE_AMD_CPU),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillOnce(DoAll(SetArgPointee<1>(AMDSMI_PROCESSOR_TYPE_AMD_GPU),
+                      Return(AMDSMI_STATUS_SUCCESS)));
+
+  rocprofsys::amd_smi::service<mock_driver_factory> svc;
+  auto table = svc.get_processor_table();
+  ASSERT_EQ(table.size(), 2);
+  EXPECT_EQ(table.types()[0], AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  EXPECT_EQ(table.types()[1], AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  EXPECT_EQ(table.capabilities()[0], 0);
+  EXPECT_EQ(table.capabilities()[1], 0);
+}
+
+TEST_F(ServiceTest, FilterSkipsRejectedTypesAndDevices) {
+  EXPECT_CALL(*g_mock_api_instance, init());
+  EXPECT_CALL(*g_mock_api_instance, get_version(_));
+  EXPECT_CALL(*g_mock_api_instance, get_socket_handles(_, _)).Times(2);
+  EXPECT_CALL(*g_mock_api_instance, get_processor_handles(_, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          DoAll(SetArgPointee<1>(3), Return(AMDSMI_STATUS_SUCCESS)));
+  EXPECT_CALL(*g_mock_api_instance, get_processor_type(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(AMDSMI_PROCESSOR_TYPE_AMD_CPU),
+                      Return(AMDSMI_STATUS_SUCCESS)))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(AMDSMI_PROCESSOR_TYPE_AMD_GPU),
+                            Return(AMDSMI_STATUS_SUCCESS)));
+
+  // Device indices count per type: device 1 is the second GPU.
+  rocprofsys::amd_smi::processor_filter filter{
+      .types = {AMDSMI_PROCESSOR_TYPE_AMD_GPU}, .devices = {1}};
+  rocprofsys::amd_smi::service<mock_driver_factory> svc{filter};
+  auto table = svc.get_processor_table();
+  ASSERT_EQ(table.size(), 1);
+  EXPECT_EQ(table.types()[0], AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+}
+
+// Stateless driver API bound at compile time
+struct stateless_driver_api {
+  static amdsmi_status_t init() { return AMDSMI_STATUS_SUCCESS; }
+  static amdsmi_status_t get_version(amdsmi_version_t *version) {
+    *version = amdsmi_version_t{7, 8, 9, "stateless"};
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_socket_handles(uint32_t *count,
+                                            amdsmi_socket_handle *) {
+    *count = 0;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_processor_handles(amdsmi_socket_handle,
+                                               uint32_t *count,
+                                               amdsmi_processor_handle *) {
+    *count = 0;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_processor_type(amdsmi_processor_handle,
+                                            processor_type_t *) {
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+struct stateless_driver_factory {
+  using driver_t = stateless_driver_api;
+  static constexpr driver_t create_driver() { return driver_t{}; }
+};
+
+TEST(ServiceStatelessDriverTest, BindsWithoutSharedState) {
+  static_assert(rocprofsys::amd_smi::stateless_driver<stateless_driver_api>);
+  static_assert(!rocprofsys::amd_smi::stateless_driver<mock_driver_api>);
+  static_assert(std::is_empty_v<
+                rocprofsys::amd_smi::driver_binding<stateless_driver_api>>);
+
+  rocprofsys::amd_smi::service<stateless_driver_factory> svc;
+  EXPECT_EQ(svc.get_version().string_representation, "stateless");
+  EXPECT_TRUE(svc.get_processors().empty());
+}
+
+// Stateless driver API that reports PCI addresses
+struct identity_driver_api : stateless_driver_api {
+  static amdsmi_status_t get_socket_handles(uint32_t *count,
+                                            amdsmi_socket_handle *handles) {
+    *count = 1;
+    if (handles != nullptr) {
+      handles[0] = reinterpret_cast<amdsmi_socket_handle>(0x10);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t
+  get_processor_handles(amdsmi_socket_handle, uint32_t *count,
+                        amdsmi_processor_handle *handles) {
+    *count = 2;
+    if (handles != nullptr) {
+      handles[0] = reinterpret_cast<amdsmi_processor_handle>(0x1000);
+      handles[1] = reinterpret_cast<amdsmi_processor_handle>(0x2000);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_device_bdf(amdsmi_processor_handle handle,
+                                        amdsmi_bdf_t *bdf) {
+    // Only the first processor is a GPU with a PCI address.
+    if (handle != reinterpret_cast<amdsmi_processor_handle>(0x1000)) {
+      return AMDSMI_STATUS_NOT_SUPPORTED;
+    }
+    bdf->as_uint = 0xc100;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+struct identity_driver_factory {
+  using driver_t = identity_driver_api;
+  static constexpr driver_t create_driver() { return driver_t{}; }
+};
+
+TEST(ServiceIdentityTest, DiscoverUsesPciAddressWhenAvailable) {
+  static_assert(rocprofsys::amd_smi::identity_driver<identity_driver_api>);
+  static_assert(!rocprofsys::amd_smi::identity_driver<mock_driver_api>);
+
+  rocprofsys::amd_smi::service<identity_driver_factory> svc;
+  auto discovered = svc.discover();
+  ASSERT_EQ(discovered.size(), 2);
+  EXPECT_EQ(discovered[0].identity, 0xc100);
+  EXPECT_EQ(discovered[1].identity,
+            rocprofsys::amd_smi::handle_identity(discovered[1].handle));
+
+  auto table = svc.get_processor_table();
+  EXPECT_EQ(table.identities()[0], 0xc100);
+}
+
+// Stateless driver API that records the init flags it receives
+struct flagged_driver_api : identity_driver_api {
+  static inline uint64_t init_flags{0};
+  static amdsmi_status_t init(uint64_t flags = AMDSMI_INIT_AMD_GPUS) {
+    init_flags = flags;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+struct flagged_driver_factory {
+  using driver_t = flagged_driver_api;
+  static constexpr driver_t create_driver() { return driver_t{}; }
+};
+
+TEST(ServiceFilterTest, NarrowsInitFlagsAndSkipsSockets) {
+  namespace smi = rocprofsys::amd_smi;
+  // Without types every family is initialized, not the driver's default.
+  smi::service<flagged_driver_factory> all;
+  EXPECT_EQ(flagged_driver_api::init_flags, AMDSMI_INIT_ALL_PROCESSORS);
+  EXPECT_EQ(all.discover().size(), 2);
+
+  smi::processor_filter filter{.types = {AMDSMI_PROCESSOR_TYPE_AMD_CPU}};
+  smi::service<flagged_driver_factory> cpus{filter};
+  EXPECT_EQ(flagged_driver_api::init_flags, AMDSMI_INIT_AMD_CPUS);
+
+  smi::service<flagged_driver_factory> other_socket{
+      smi::processor_filter{.sockets = {1}}};
+  EXPECT_TRUE(other_socket.discover().empty());
+
+  EXPECT_EQ(smi::processor_filter{}.init_flags(), AMDSMI_INIT_ALL_PROCESSORS);
+  EXPECT_EQ(smi::processor_filter::amd_gpus().init_flags(),
+            AMDSMI_INIT_AMD_GPUS);
+}
+
+// Stateless driver API with two sockets of two GPUs each
+struct two_socket_driver_api : stateless_driver_api {
+  static amdsmi_status_t get_socket_handles(uint32_t *count,
+                                            amdsmi_socket_handle *handles) {
+    *count = 2;
+    if (handles != nullptr) {
+      handles[0] = reinterpret_cast<amdsmi_socket_handle>(0x10);
+      handles[1] = reinterpret_cast<amdsmi_socket_handle>(0x20);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t
+  get_processor_handles(amdsmi_socket_handle socket, uint32_t *count,
+                        amdsmi_processor_handle *handles) {
+    *count = 2;
+    if (handles != nullptr) {
+      auto base = reinterpret_cast<uintptr_t>(socket) * 0x100;
+      handles[0] = reinterpret_cast<amdsmi_processor_handle>(base + 1);
+      handles[1] = reinterpret_cast<amdsmi_processor_handle>(base + 2);
+    }
+    return AMDSMI_STATUS_SUCCESS;
+  }
+  static amdsmi_status_t get_processor_type(amdsmi_processor_handle,
+                                            processor_type_t *type) {
+    *type = AMDSMI_PROCESSOR_TYPE_AMD_GPU;
+    return AMDSMI_STATUS_SUCCESS;
+  }
+};
+
+struct two_socket_driver_factory {
+  using driver_t = two_socket_driver_api;
+  static constexpr driver_t create_driver() { return driver_t{}; }
+};
+
+TEST(ServiceFilterTest, DeviceIndicesSpanRejectedSockets) {
+  namespace smi = rocprofsys::amd_smi;
+  auto second_socket_gpu = reinterpret_cast<amdsmi_processor_handle>(0x2001);
+
+  // Device 2 is the first GPU of the second socket, with or without the
+  // socket filter.
+  smi::service<two_socket_driver_factory> unfiltered{
+      smi::processor_filter{.devices = {2}}};
+  auto all_sockets = unfiltered.discover();
+  ASSERT_EQ(all_sockets.size(), 1);
+  EXPECT_EQ(all_sockets[0].handle, second_socket_gpu);
+
+  smi::service<two_socket_driver_factory> second_socket{
+      smi::processor_filter{.sockets = {1}, .devices = {2}}};
+  auto filtered = second_socket.discover();
+  ASSERT_EQ(filtered.size(), 1);
+  EXPECT_EQ(filtered[0].handle, second_socket_gpu);
+
+  // Device 0 lives on the first socket, which the filter rejects.
+  smi::service<two_socket_driver_factory> first_device{
+      smi::processor_filter{.sockets = {1}, .devices = {0}}};
+  EXPECT_TRUE(first_device.discover().empty());
+}
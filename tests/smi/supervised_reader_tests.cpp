@@ -0,0 +1,198 @@
+#include "mock_sampling_driver.hpp"
+#include "smi/processor_table.hpp"
+#include "smi/supervised_reader.hpp"
+#include <amd_smi/amdsmi.h>
+#include <chrono>
+#include <future>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace smi = rocprofsys::amd_smi;
+
+class SupervisedReaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mock_driver = std::make_shared<NiceMock<mock_sampling_driver>>();
+    fast_handle = reinterpret_cast<amdsmi_processor_handle>(0x1000);
+    stuck_handle = reinterpret_cast<amdsmi_processor_handle>(0x2000);
+
+    amdsmi_power_info_t power_info = {};
+    power_info.current_socket_power = 140;
+    amdsmi_gpu_metrics_t gpu_metrics = {};
+    gpu_metrics.current_socket_power = 140;
+
+    set_default_answers(*mock_driver, gpu_metrics, power_info);
+  }
+
+  std::shared_ptr<NiceMock<mock_sampling_driver>> mock_driver;
+  amdsmi_processor_handle fast_handle;
+  amdsmi_processor_handle stuck_handle;
+};
+
+TEST_F(SupervisedReaderTest, ReadsEveryProcessorWithinDeadline) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(fast_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.add(stuck_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.add(reinterpret_cast<amdsmi_processor_handle>(0x3000),
+            AMDSMI_PROCESSOR_TYPE_AMD_CPU);
+  table.probe();
+
+  smi::supervised_reader<mock_sampling_driver> reader{
+      table, std::chrono::seconds{5}};
+  EXPECT_EQ(reader.read({}), 2);
+  EXPECT_EQ(table.statuses()[0], AMDSMI_STATUS_SUCCESS);
+  EXPECT_EQ(table.statuses()[1], AMDSMI_STATUS_SUCCESS);
+  EXPECT_EQ(table.statuses()[2], AMDSMI_STATUS_NO_DATA);
+  EXPECT_EQ(table.samples()[1].current_socket_power, 140);
+
+  auto health = reader.health();
+  ASSERT_EQ(health.size(), 3);
+  EXPECT_EQ(health[0].completed, 1);
+  EXPECT_EQ(health[0].timeouts, 0);
+  EXPECT_EQ(health[2].completed, 0);
+}
+
+TEST_F(SupervisedReaderTest, WorkersRunWithThePlacement) {
+  cpu_set_t allowed;
+  ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed),
+            0);
+  smi::thread_placement placement;
+  for (int cpu = 0; placement.cpus.empty(); ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      placement.cpus.push_back(cpu);
+    }
+  }
+
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(fast_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  std::mutex mutex;
+  std::vector<int> cpu_counts;
+  ON_CALL(*mock_driver, get_memory_usage(_, _, _))
+      .WillByDefault(Invoke([&](auto, auto, uint64_t *used) {
+        cpu_set_t set;
+        pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+        std::lock_guard lock{mutex};
+        cpu_counts.push_back(CPU_COUNT(&set));
+        *used = 4096;
+        return AMDSMI_STATUS_SUCCESS;
+      }));
+
+  smi::supervised_reader<mock_sampling_driver> reader{
+      table, std::chrono::seconds{5}};
+  EXPECT_EQ(reader.read({}), 1);
+  // Applied to the running worker and to the worker of a new row.
+  reader.set_placement(placement);
+  table.add(stuck_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+  reader.resize(table.size());
+  {
+    std::lock_guard lock{mutex};
+    cpu_counts.clear(); // drop the calls of probe()
+  }
+  EXPECT_EQ(reader.read({}), 2);
+  std::lock_guard lock{mutex};
+  ASSERT_FALSE(cpu_counts.empty());
+  for (auto count : cpu_counts) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST_F(SupervisedReaderTest, StuckProcessorIsMissingWhileOthersPublish) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(fast_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.add(stuck_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  amdsmi_gpu_metrics_t busy = {};
+  busy.current_socket_power = 300;
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(_, _)).Times(AnyNumber());
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(stuck_handle, _))
+      .Times(2)
+      .WillOnce([&](amdsmi_processor_handle, amdsmi_gpu_metrics_t *metrics) {
+        released.wait();
+        *metrics = busy;
+        return AMDSMI_STATUS_SUCCESS;
+      })
+      .WillOnce(
+          DoAll(SetArgPointee<1>(busy), Return(AMDSMI_STATUS_SUCCESS)));
+
+  smi::supervised_reader<mock_sampling_driver> reader{
+      table, std::chrono::milliseconds{20}, 2};
+  // The stuck call is not issued again while it is still in flight.
+  for (int round = 0; round < 3; ++round) {
+    EXPECT_EQ(reader.read({}), 1);
+    EXPECT_EQ(table.statuses()[0], AMDSMI_STATUS_SUCCESS);
+    EXPECT_EQ(table.statuses()[1], AMDSMI_STATUS_TIMEOUT);
+  }
+  auto health = reader.health();
+  EXPECT_EQ(health[0].completed, 3);
+  EXPECT_EQ(health[1].timeouts, 3);
+  EXPECT_EQ(health[1].consecutive_timeouts, 3);
+  EXPECT_TRUE(health[1].hung);
+  // The late result is discarded, so the sample is unchanged.
+  EXPECT_EQ(table.samples()[1].current_socket_power, 0);
+
+  release.set_value();
+  std::this_thread::sleep_for(std::chrono::milliseconds{50});
+  EXPECT_EQ(reader.read({}), 2);
+  EXPECT_EQ(table.samples()[1].current_socket_power, 300);
+  health = reader.health();
+  EXPECT_EQ(health[1].completed, 1);
+  EXPECT_EQ(health[1].consecutive_timeouts, 0);
+  EXPECT_FALSE(health[1].hung);
+}
+
+TEST_F(SupervisedReaderTest, DestructionDoesNotWaitForHungCalls) {
+  smi::processor_table<mock_sampling_driver> table{mock_driver};
+  table.add(fast_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.add(stuck_handle, AMDSMI_PROCESSOR_TYPE_AMD_GPU);
+  table.probe();
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  auto returned = std::make_shared<std::promise<void>>();
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(_, _)).Times(AnyNumber());
+  EXPECT_CALL(*mock_driver, get_gpu_metrics_info(stuck_handle, _))
+      .WillOnce([released, returned](amdsmi_processor_handle,
+                                     amdsmi_gpu_metrics_t *) {
+        released.wait();
+        returned->set_value();
+        return AMDSMI_STATUS_SUCCESS;
+      });
+
+  auto abandoned =
+      smi::supervised_reader<mock_sampling_driver>::abandoned_workers();
+  auto begin = std::chrono::steady_clock::now();
+  {
+    smi::supervised_reader<mock_sampling_driver> reader{
+        table, std::chrono::milliseconds{20}, 1};
+    EXPECT_EQ(reader.read({}), 1);
+    EXPECT_TRUE(reader.health()[1].hung);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds{1});
+  EXPECT_EQ(smi::supervised_reader<mock_sampling_driver>::abandoned_workers(),
+            abandoned + 1);
+
+  // The detached worker finishes the call on its own once the driver returns.
+  auto finished = returned->get_future();
+  release.set_value();
+  EXPECT_EQ(finished.wait_for(std::chrono::seconds{5}),
+            std::future_status::ready);
+}
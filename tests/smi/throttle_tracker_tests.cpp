@@ -0,0 +1,69 @@
+#include "smi/throttle_tracker.hpp"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+using rocprofsys::amd_smi::throttle_cause;
+using rocprofsys::amd_smi::throttle_event;
+using rocprofsys::amd_smi::throttle_tracker;
+
+namespace {
+// Bits of the ASIC-independent throttle status.
+constexpr uint64_t ppt0 = uint64_t{1} << 0;
+constexpr uint64_t spl = uint64_t{1} << 4;
+constexpr uint64_t temp_hotspot = uint64_t{1} << 36;
+} // namespace
+
+TEST(ThrottleTrackerTest, CauseBitsPartitionTheStatus) {
+  namespace smi = rocprofsys::amd_smi;
+  EXPECT_NE(smi::throttle_cause_bits(throttle_cause::power) & spl, 0);
+  EXPECT_NE(smi::throttle_cause_bits(throttle_cause::thermal) & temp_hotspot,
+            0);
+  uint64_t all{0};
+  for (std::size_t cause = 0; cause < smi::throttle_cause_count; ++cause) {
+    auto bits = smi::throttle_cause_bits(static_cast<throttle_cause>(cause));
+    EXPECT_EQ(all & bits, 0);
+    all |= bits;
+  }
+  EXPECT_EQ(all, ~uint64_t{0});
+}
+
+TEST(ThrottleTrackerTest, IntervalsCloseWithTheirDuration) {
+  throttle_tracker tracker{2};
+  std::vector<throttle_event> ended;
+
+  EXPECT_EQ(tracker.update(1, 0, 100, ended), 0);
+  EXPECT_EQ(tracker.update(1, ppt0, 200, ended), 0);
+  EXPECT_TRUE(tracker.active(1, throttle_cause::power));
+  EXPECT_EQ(tracker.active_since(1, throttle_cause::power), 200);
+
+  // Thermal joins while power is still capping.
+  EXPECT_EQ(tracker.update(1, spl | temp_hotspot, 300, ended), 0);
+  EXPECT_EQ(tracker.update(1, temp_hotspot, 450, ended), 1);
+  ASSERT_EQ(ended.size(), 1);
+  EXPECT_EQ(ended[0].row, 1);
+  EXPECT_EQ(ended[0].cause, throttle_cause::power);
+  EXPECT_EQ(ended[0].reasons, ppt0 | spl);
+  EXPECT_EQ(ended[0].begin_ns, 200);
+  EXPECT_EQ(ended[0].duration_ns(), 250);
+
+  EXPECT_EQ(tracker.update(1, 0, 500, ended), 1);
+  ASSERT_EQ(ended.size(), 2);
+  EXPECT_EQ(ended[1].cause, throttle_cause::thermal);
+  EXPECT_EQ(ended[1].duration_ns(), 200);
+
+  EXPECT_EQ(tracker.throttled_ns(1, throttle_cause::power), 250);
+  EXPECT_EQ(tracker.throttled_ns(1, throttle_cause::thermal), 200);
+  EXPECT_FALSE(tracker.active(1, throttle_cause::thermal));
+  EXPECT_EQ(tracker.throttled_ns(0, throttle_cause::power), 0);
+}
+
+TEST(ThrottleTrackerTest, ResetRowDropsOpenIntervals) {
+  throttle_tracker tracker{1};
+  std::vector<throttle_event> ended;
+  tracker.update(0, ppt0, 10, ended);
+  tracker.reset_row(0);
+  EXPECT_FALSE(tracker.active(0, throttle_cause::power));
+  EXPECT_EQ(tracker.update(0, 0, 20, ended), 0);
+  EXPECT_TRUE(ended.empty());
+}